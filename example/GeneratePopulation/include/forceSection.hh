@@ -60,7 +60,12 @@ public:
 		double rigidity = this->template load<double>(sectionName, "rigidity");
 		
 		
-		this->objToFill->setForceProperties(ratioToStableLength, rigidity);
+		// optional : evaluate each pair of neighbour cells once. Forces are then computed from the positions at the begining of each step
+		int pairwiseEvaluation = this->template loadOptional<int>(sectionName, "pairwiseEvaluation", 0);
+		// optional : neighbour cells further than the cutoff are not pulled. Not positive for no cutoff
+		double cutoff = this->template loadOptional<double>(sectionName, "cutoff", -1.);
+
+		this->objToFill->setForceProperties(ratioToStableLength, rigidity, pairwiseEvaluation != 0, cutoff);
     }
 };
 
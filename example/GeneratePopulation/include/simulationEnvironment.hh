@@ -16,6 +16,8 @@ See LICENSE.md for further details
 #include <Cell_Utils.hh>			// used for the getNearestAndFarthestPoints function
 #include <DistributionFactory.hh>	// used to distribute cell inside the sub environment
 #include <ElasticForce.hh>			// The type of force we want to apply
+#include <ElasticPairForces.hh>		// used to evaluate the elastic forces pair by pair
+#include <InformationSystemManager.hh>	// used to warn about the options ignored
 #include <MASPlatform.hh>			// THe platform used to manage agent ( cell ) execution
 #include <File_CPOP_Data.hh>		// CPOP tools for saving files
 #include <MeshFactory.hh>			// used to get the reuested mesh
@@ -33,6 +35,7 @@ using namespace Settings::nCell;
 using namespace Settings::nEnvironment;
 
 typedef ElasticForce<double, Point_3, Vector_3>				t_ElasticForce_3;
+typedef ElasticPairForces<double, Point_3, Vector_3>		t_ElasticPairForces_3;
 
 class SimulationEnvironment {
 	// Metric  system
@@ -46,6 +49,8 @@ class SimulationEnvironment {
 	int numberOfFacetPerCell;
 	// Simulation properties
 	MASPlatform* platform;
+	// Elastic forces evaluated pair by pair, NULL if each cell evaluates its own
+	t_ElasticPairForces_3* pairForces;
 	
 	G4Material* parseMaterial(const char* material);
 	
@@ -61,10 +66,14 @@ class SimulationEnvironment {
 						   const std::string& nucleusMaterials);
 	void setSpheroidProperties(double internalRadius, double externalRadius, int nbCell);
 	void setMeshProperties(int nOfFacetPerCell);
-	void setForceProperties(double ratioToStableLength, double rigidity);
+	void setForceProperties(double ratioToStableLength, double rigidity, bool pairwiseEvaluation, double cutoff);
 	void setSimulationProperties(double duration, int numberOfAgentToExecute, 
 								 double displacementThreshold,
 								 double stepDuration);
+	void setStoppingRule(double maxDisplacement, double meanDisplacement,
+						 double energyChange, double overlapChange, int nbSteps);
+	void setAdaptiveStepDuration(double minStep, double maxStep, double safetyFactor, double maxGrowth);
+	void setNeighbourListSkin(double skin);
 								 
 	// start the simulation
 	void startSimulation();
@@ -39,6 +39,7 @@ See LICENSE.md for further details
  * _double : double myDouble = this->template load<double>(sectionName, keyName);
  * _string : string myString = this->template load<string>(sectionName, keyName);
  * _vector : std::vector<double> myVector = this->template load<std::vector<double>>(sectionName, keyName);
+ * _optional : double myDouble = this->template loadOptional<double>(sectionName, keyName, defaultValue);
  * 
  * Note : vector can contain any type that supports << to a stringstream (according to zupply documentation http://zhreshold.github.io/zupply/classzz_1_1cfg_1_1_value.html)
  * 
@@ -63,6 +64,31 @@ public:
 		
 		
 		this->objToFill->setSimulationProperties(duration, numberOfAgentToExecute, displacementThreshold, stepDuration);
+
+		// optional stopping rule : the simulation stops once the cells are no longer moving. Negative tolerances are disabled
+		double convergenceMaxDisplacement = this->template loadOptional<double>(sectionName, "convergenceMaxDisplacement", -1.);
+		double convergenceMeanDisplacement = this->template loadOptional<double>(sectionName, "convergenceMeanDisplacement", -1.);
+		double convergenceEnergyChange = this->template loadOptional<double>(sectionName, "convergenceEnergyChange", -1.);
+		double convergenceOverlapChange = this->template loadOptional<double>(sectionName, "convergenceOverlapChange", -1.);
+		int convergenceNbSteps = this->template loadOptional<int>(sectionName, "convergenceNbSteps", 1);
+
+		this->objToFill->setStoppingRule(convergenceMaxDisplacement, convergenceMeanDisplacement,
+										 convergenceEnergyChange, convergenceOverlapChange, convergenceNbSteps);
+
+		// optional adaptive step duration : the step follows the strongest force, between the min and max durations. Disabled if the min duration is not positive
+		double adaptiveMinStepDuration = this->template loadOptional<double>(sectionName, "adaptiveMinStepDuration", -1.);
+		double adaptiveMaxStepDuration = this->template loadOptional<double>(sectionName, "adaptiveMaxStepDuration", adaptiveMinStepDuration);
+		double adaptiveSafetyFactor = this->template loadOptional<double>(sectionName, "adaptiveSafetyFactor", 0.5);
+		double adaptiveMaxGrowth = this->template loadOptional<double>(sectionName, "adaptiveMaxGrowth", 2.);
+
+		if (adaptiveMinStepDuration > 0.)
+			this->objToFill->setAdaptiveStepDuration(adaptiveMinStepDuration, adaptiveMaxStepDuration,
+													 adaptiveSafetyFactor, adaptiveMaxGrowth);
+
+		// optional skin of the neighbour lists of the forces with a cutoff : lists are kept until the cells moved of half the skin
+		double neighbourListSkin = this->template loadOptional<double>(sectionName, "neighbourListSkin", -1.);
+		if (neighbourListSkin > 0.)
+			this->objToFill->setNeighbourListSkin(neighbourListSkin);
     }
 };
 
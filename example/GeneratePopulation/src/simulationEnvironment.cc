@@ -8,6 +8,8 @@ See LICENSE.md for further details
 ----------------------*/
 #include "simulationEnvironment.hh"
 
+#include <stdexcept>
+
 SimulationEnvironment::SimulationEnvironment() {
 
 	// metric system
@@ -25,6 +27,7 @@ SimulationEnvironment::SimulationEnvironment() {
 
 	// simulation
 	platform = nullptr;
+	pairForces = nullptr;
 
 }
 
@@ -33,6 +36,7 @@ SimulationEnvironment::~SimulationEnvironment() {
 	if (cellProperties) delete cellProperties;
 	if (env)            delete env;
 	if (platform)       delete platform;
+	if (pairForces)     delete pairForces;
 }
 
 void SimulationEnvironment::setMetricSystem(const std::string& metric) {
@@ -110,7 +114,7 @@ void SimulationEnvironment::setMeshProperties(int nOfFacetPerCell) {
 	numberOfFacetPerCell = nOfFacetPerCell;
 }
 
-void SimulationEnvironment::setForceProperties(double ratioToStableLength, double rigidity) {
+void SimulationEnvironment::setForceProperties(double ratioToStableLength, double rigidity, bool pairwiseEvaluation, double cutoff) {
 	int error;
 	// get the generated cells
 	t_Mesh_3* voronoiMesh = MeshFactory::getInstance()->create_3DMesh(&error, simulatedEnv, MeshTypes::Round_Cell_Tesselation, numberOfFacetPerCell);
@@ -118,11 +122,24 @@ void SimulationEnvironment::setForceProperties(double ratioToStableLength, doubl
 	delete voronoiMesh;
 
 	// apply elastic forces to each cells
+	// the pair evaluation is scheduled before each step on its creation
+#ifdef SIMULATION_VALID_AGENT_NEW_POS
+	if (pairwiseEvaluation)
+		pairForces = new t_ElasticPairForces_3();
+#else
+	// the pairs see the positions of the begining of the step, the agents see the neighbours already moved
+	if (pairwiseEvaluation)
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::WARNING_MES,
+			"pairwiseEvaluation ignored : it needs SIMULATION_VALID_AGENT_NEW_POS (AgentSettings.hh) to keep the same dynamics", "SimulationEnvironment");
+#endif
 	set<t_Cell_3*>::iterator itCell;
 	for(itCell = lCells.begin(); itCell != lCells.end(); ++itCell)
 	{
 		t_ElasticForce_3* elasForce = new t_ElasticForce_3( *itCell, rigidity, ratioToStableLength);
+		elasForce->setCutoff(cutoff);
 		(*itCell)->addForce(elasForce);
+		if (pairForces)
+			pairForces->addForce(elasForce);
 	}
 
 }
@@ -140,8 +157,37 @@ void SimulationEnvironment::setSimulationProperties(double duration, int numberO
 	platform->setStepDuration(			stepDuration);
 	platform->setDuration(				duration);
 	platform->setDisplacementThreshold(	displacementThreshold);
-	platform->limiteNbAgentToSimulate(	numberOfAgentToExecute);
+	// all the cells move at each step unless a positive number of cells is given
+	if (numberOfAgentToExecute > 0)
+		platform->limiteNbAgentToSimulate(	numberOfAgentToExecute);
+
+}
+
+void SimulationEnvironment::setStoppingRule(double maxDisplacement, double meanDisplacement,
+					 double energyChange, double overlapChange, int nbSteps)
+{
+	/// stop the simulation before its duration once the cells are no longer moving
+	StoppingRule rule;
+	rule.setMaxDisplacement(	maxDisplacement);
+	rule.setMeanDisplacement(	meanDisplacement);
+	rule.setEnergyChange(		energyChange);
+	rule.setOverlapChange(		overlapChange);
+	rule.setNbSteps(			nbSteps > 0 ? nbSteps : 1);
+	platform->setStoppingRule(rule);
+}
 
+void SimulationEnvironment::setAdaptiveStepDuration(double minStep, double maxStep, double safetyFactor, double maxGrowth)
+{
+	/// adapt the step duration to the strongest force, the stepDuration being the one of the first step
+	if (minStep <= 0. || maxStep < minStep || safetyFactor <= 0. || maxGrowth < 1.)
+		throw std::invalid_argument("adaptive step duration : expected 0 < min <= max, a positive safety factor and a growth of at least 1");
+	platform->setAdaptiveStepDuration(minStep, maxStep, safetyFactor, maxGrowth);
+}
+
+void SimulationEnvironment::setNeighbourListSkin(double skin)
+{
+	/// the forces with a cutoff keep their neighbours until the cells moved of half the skin
+	platform->setNeighbourListSkin(skin);
 }
 
 void SimulationEnvironment::startSimulation() {
@@ -0,0 +1,152 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef AGENT_STATE_STORE_HH
+#define AGENT_STATE_STORE_HH
+
+#include <algorithm>
+#include <assert.h>
+#include <vector>
+
+template <typename Kernel, typename Point, typename Vector>
+class DynamicAgent;
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief contiguous storage (structure of arrays) of the step state of dynamic agents.
+/// \details Each agent added gets a dense index and writes its position and displacement
+/// in the arrays during its execution.
+/// Step updates (validation of the requested positions, metrics...) then run as
+/// loops over the arrays instead of casting each agent, and the forces read the
+/// neighbour positions from the arrays.
+/// The agent keeps its own copy of its position, the validated ones are copied back to the store.
+/// \warning arrays must not be resized while agents are executed : add agents between steps.
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+class AgentStateStore
+{
+public:
+	typedef DynamicAgent<Kernel, Point, Vector> t_Agent;
+
+	/// \brief constructor
+	AgentStateStore()													{};
+	/// \brief destructor
+	/// \warning agents are not unbound (they can be deleted before the store) : call clear while they exist
+	~AgentStateStore()													{};
+
+	/// \brief add an agent and return its index
+	size_t addAgent(t_Agent*);
+	/// \brief unbind and remove all agents
+	void clear();
+	/// \brief update the position of each agent from the agent
+	void pull();
+
+	/// \brief return the number of agents stored
+	size_t size() const													{ return agents.size();};
+	/// \brief return the agent at index i
+	t_Agent* getAgent(size_t i) const									{ assert(i < agents.size()); return agents[i];};
+
+	/// \brief register the state of the agent i after its execution. Thread safe for distinct agents
+	inline void writeStep(size_t i, const Point& pPosition, Kernel pDisplacement);
+
+	/// \brief return true if the agent i has been executed since the last clearExecuted
+	bool isExecuted(size_t i) const										{ return executed[i] != 0;};
+	/// \brief forget which agents have been executed
+	void clearExecuted()												{ std::fill(executed.begin(), executed.end(), 0);};
+	/// \brief move the agents executed to their requested position
+	void validRequestedPositions();
+
+	const std::vector<Point>& getPositions() const						{ return positions;};
+	const std::vector<Kernel>& getDisplacements() const					{ return displacements;};
+
+private:
+	std::vector<t_Agent*> agents;				///< \brief the agent of each index
+	std::vector<Point> positions;				///< \brief position of each agent
+	std::vector<Kernel> displacements;			///< \brief distance travelled during the last execution
+	std::vector<char> executed;					///< \brief true if the agent has been executed since the last clearExecuted
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pAgent The agent to add. Must not be in another store
+/// \return the index of the agent
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+size_t AgentStateStore<Kernel, Point, Vector>::addAgent(t_Agent* pAgent)
+{
+	assert(pAgent);
+	size_t lIndex = agents.size();
+	agents.push_back(pAgent);
+	positions.push_back(pAgent->getPosition());
+	displacements.push_back(pAgent->getLastDisplacement());
+	executed.push_back(0);
+	pAgent->bindStateStore(this, lIndex);
+	return lIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+void AgentStateStore<Kernel, Point, Vector>::clear()
+{
+	typename std::vector<t_Agent*>::iterator itAgent;
+	for(itAgent = agents.begin(); itAgent != agents.end(); ++itAgent)
+	{
+		(*itAgent)->bindStateStore(NULL, 0);
+	}
+	agents.clear();
+	positions.clear();
+	displacements.clear();
+	executed.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details needed if agents have been moved or resized out of a simulation step
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+void AgentStateStore<Kernel, Point, Vector>::pull()
+{
+	for(size_t i = 0; i < agents.size(); ++i)
+	{
+		positions[i] = agents[i]->getPosition();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param i The agent index
+/// \param pPosition The position of the agent after its execution
+/// \param pDisplacement The distance travelled (or requested) by the agent
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+void AgentStateStore<Kernel, Point, Vector>::writeStep(size_t i, const Point& pPosition, Kernel pDisplacement)
+{
+	assert(i < agents.size());
+	positions[i] = pPosition;
+	displacements[i] = pDisplacement;
+	executed[i] = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details the agents keep their requested position (which can be changed by the conflicts solving).
+/// The validated positions and displacements are copied back to the store.
+//////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+void AgentStateStore<Kernel, Point, Vector>::validRequestedPositions()
+{
+	for(size_t i = 0; i < agents.size(); ++i)
+	{
+		if(!executed[i] || !agents[i]->isRequiringNewPos())
+		{
+			continue;
+		}
+		agents[i]->validRequiredPos();
+		positions[i] = agents[i]->getPosition();
+		displacements[i] = agents[i]->getLastDisplacement();
+	}
+}
+
+#endif // AGENT_STATE_STORE_HH
@@ -9,6 +9,7 @@ See LICENSE.md for further details
 #ifndef DYNAMIC_AGENT_HH
 #define DYNAMIC_AGENT_HH
 
+#include "AgentStateStore.hh"
 #include "Movable.hh"
 #include "Scheduler.hh"
 #include "SpatialableAgent.hh"
@@ -56,19 +57,41 @@ public:
 	/// \brief return the requested position of the agent for next step
 	Point getRequestedPosition() const 		{ return requiredNewPos;};		///< \brief required position getter
 	/// \brief called to validate the new agent position.
-	void validRequiredPos()					{ Spatialable<Kernel, Point, Vector>::position = requiredNewPos; bIsReqNewPos = false;};	
+	void validRequiredPos();
 	/// \brief called when the agent require a new position
 	void setIsRequiringNewPos(bool b) 		{ bIsReqNewPos = b;};	
 	/// \brief true when the agent is requiring a new position
 	bool isRequiringNewPos() const			{ return bIsReqNewPos;};
+	/// \brief replace the requested position, used to solve conflicts between requests
+	void setRequiredPosition(Point p)		{ requiredNewPos = p;};
+
+	/// \brief return the distance travelled by the agent during its last execution
+	Kernel getLastDisplacement() const		{ return lastDisplacement;};
+	/// \brief return the potential energy of the agent interactions. 0 by default
+	virtual Kernel getPotentialEnergy() const	{ return Kernel();};
+	/// \brief return the volume the agent shares with its neighbours. 0 by default
+	virtual Kernel getOverlapVolume() const		{ return Kernel();};
+
+	/// \brief define the store the agent writes its step state in. NULL to unbind
+	void bindStateStore(AgentStateStore<Kernel, Point, Vector>* pStore, size_t pIndex)	{ stateStore = pStore; stateIndex = pIndex;};
+	/// \brief return the store the agent writes its step state in, NULL if none
+	AgentStateStore<Kernel, Point, Vector>* getStateStore() const	{ return stateStore;};
+	/// \brief return the index of the agent in its state store
+	size_t getStateIndex() const			{ return stateIndex;};
 
 private:
 	/// \brief called when we want to set a new position for the agent
 	void requireNewPos(Point p)				{ requiredNewPos = p; bIsReqNewPos = true;};
 
 protected:
+	/// \brief copy the state of the step on the state store
+	void writeStepState()					{ if(stateStore) stateStore->writeStep(stateIndex, Spatialable<Kernel, Point, Vector>::position, lastDisplacement);};
+
 	bool bIsReqNewPos;			///< \brief True if the agent request a new position for the next step
 	Point requiredNewPos;		///< \brief the new required position
+	Kernel lastDisplacement;	///< \brief the distance travelled during the last execution
+	AgentStateStore<Kernel, Point, Vector>* stateStore;	///< \brief the store of the step state, NULL if none
+	size_t stateIndex;			///< \brief index of the agent in stateStore
 };
 
 //////////////////// FUNCTION DEFINITIONS ///////////////////////////////////
@@ -79,7 +102,10 @@ protected:
 template<typename Kernel, typename Point, typename Vector>
 DynamicAgent<Kernel, Point, Vector>::DynamicAgent(Body* pBody, Point pPosition, Vector pOrientation):
 	SpatialableAgent<Kernel, Point, Vector>(pBody, pPosition, pOrientation), 
-	Movable<Kernel, Point, Vector>(Vector(), Kernel(), Vector())
+	Movable<Kernel, Point, Vector>(Vector(), Kernel(), Vector()),
+	lastDisplacement(Kernel()),
+	stateStore(NULL),
+	stateIndex(0)
 {
 
 }
@@ -104,6 +130,18 @@ int DynamicAgent<Kernel, Point, Vector>::exec()
 	return 0;
 }
 
+//////////////////////////////////////////////////////////////////
+/// \brief move the agent to the position requested. The displacement
+/// is the one validated, after conflicts solving
+//////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+void DynamicAgent<Kernel, Point, Vector>::validRequiredPos()
+{
+	lastDisplacement = sqrt((requiredNewPos - Spatialable<Kernel, Point, Vector>::position).squared_length());
+	Spatialable<Kernel, Point, Vector>::position = requiredNewPos;
+	bIsReqNewPos = false;
+}
+
 //////////////////////////////////////////////////////////////////
 /// \brief called when we want to set the agent in pause
 //////////////////////////////////////////////////////////////////
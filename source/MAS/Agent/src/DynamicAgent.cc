@@ -23,10 +23,13 @@ void DynamicAgent<double, Point_2, Vector_2>::updatePosition(double deltaT)
 
 	if(actingForce.squared_length() == 0.) 
 	{
+		lastDisplacement = 0.;
+		writeStepState();
 		return; 
 	}
-	/// make displacement
-	Vector_2 movement = actingForce;
+	/// make displacement, scaled by the step duration when it is adaptive
+	Scheduler* lScheduler = Scheduler::getInstance();
+	Vector_2 movement = actingForce * lScheduler->getStepScale();
 
 	/// check threshold
 	if(movement.squared_length() > (maxThreashold*maxThreashold) )
@@ -34,6 +37,8 @@ void DynamicAgent<double, Point_2, Vector_2>::updatePosition(double deltaT)
 		double lLength = sqrt(movement.squared_length());
 		movement = Vector_2( movement.x()/lLength*maxThreashold, movement.y()/lLength*maxThreashold);
 	}
+	lScheduler->reportAgentForce(sqrt(actingForce.squared_length()));
+	lastDisplacement = sqrt(movement.squared_length());
 	
 #ifdef SIMULATION_VALID_AGENT_NEW_POS		
 	requireNewPos(K::Point_2(position + movement));
@@ -46,6 +51,8 @@ void DynamicAgent<double, Point_2, Vector_2>::updatePosition(double deltaT)
 	assert(CGAL::is_finite(position.x()));
 	assert(CGAL::is_finite(position.y()));
 
+	writeStepState();
+
 	// reset forces
 	Movable<double, Point_2, Vector_2>::resetForce();
 }
@@ -61,10 +68,13 @@ void DynamicAgent<double, Point_3, Vector_3>::updatePosition(double deltaT)
 
 	if(actingForce.squared_length() == 0.) 
 	{
+		lastDisplacement = 0.;
+		writeStepState();
 		return; 
 	}
-	/// make displacement
-	Vector_3 movement = actingForce;
+	/// make displacement, scaled by the step duration when it is adaptive
+	Scheduler* lScheduler = Scheduler::getInstance();
+	Vector_3 movement = actingForce * lScheduler->getStepScale();
 
 	/// check threshold
 	if(movement.squared_length() > (maxThreashold*maxThreashold) )
@@ -72,6 +82,8 @@ void DynamicAgent<double, Point_3, Vector_3>::updatePosition(double deltaT)
 		double lLength = sqrt(movement.squared_length());
 		movement = Vector_3( movement.x()/lLength*maxThreashold, movement.y()/lLength*maxThreashold, movement.z()/lLength*maxThreashold );
 	}
+	lScheduler->reportAgentForce(sqrt(actingForce.squared_length()));
+	lastDisplacement = sqrt(movement.squared_length());
 	
 #ifdef SIMULATION_VALID_AGENT_NEW_POS		
 	requireNewPos(K::Point_3(position + movement));
@@ -85,6 +97,8 @@ void DynamicAgent<double, Point_3, Vector_3>::updatePosition(double deltaT)
 	assert(CGAL::is_finite(position.y()));
 	assert(CGAL::is_finite(position.z()));
 
+	writeStepState();
+
 	// reset forces
 	Movable<double, Point_3, Vector_3>::resetForce();
 }
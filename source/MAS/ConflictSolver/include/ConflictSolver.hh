@@ -27,7 +27,7 @@ public:
 
 	///\brief solve the pendante conflict with the Agents
 	/// \param pAgent The agent we want to solve the conflict for
-	virtual bool solveConflict(std::vector<Agent*> pAgent) const = 0;
+	virtual bool solveConflict(const std::vector<Agent*>& pAgent) const = 0;
 
 };
 
@@ -11,37 +11,98 @@ See LICENSE.md for further details
 
 #include "DynamicAgent.hh"
 #include "ConflictSolver.hh"
+#include "ParallelChunks.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
 
 #define NB_MAX_ITER_TO_SOLVE_SPA_POS 100
+#define SPA_POS_CONFLICT_DISTANCE 1e-6				///< \brief default distance under which two positions are in conflict
+#define MIN_NB_AGENT_PER_SPA_CONFLICT_THREAD 1024	///< \brief under this number of agents per thread the detection isn't split
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief The agent class : define rules to solve conflict between DYNAMIC AGENT ONLY and make
 /// sure two dynamic agent aren't at the same spot.
+/// \details Two positions closer than the conflict distance are in conflict. Positions are stored
+/// in a uniform spatial hash with cells of the conflict distance, so each check only looks at the
+/// neighbouring cells.
+/// Agents not requiring a new position keep their spot. The requests are then ranked in the agent
+/// order : a request is accepted if no fixed position nor an earlier request is in conflict with it.
+/// This detection is made in parallel. The (few) rejected requests are then moved along their
+/// journey toward the current position, in the same order, until they reach a free spot.
+/// The result only depends on the agent order.
 /// \warning this solver only affect dynamic agent.
 /// @author Henri Payno
 /////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename Kernel, typename Point, typename Vector>
 class SpatialConflictSolver : public ConflictSolver
 {
+	typedef DynamicAgent<Kernel, Point, Vector> t_DynamicAgent;
+	typedef std::array<long long int, 3> t_CellKey;		///< \brief the hash cell indexes. The last one is 0 in 2D
+
+	/// \brief hash of the cell indexes
+	struct CellKeyHash
+	{
+		size_t operator()(const t_CellKey& pKey) const
+		{
+			return static_cast<size_t>(pKey[0]*73856093LL ^ pKey[1]*19349663LL ^ pKey[2]*83492791LL);
+		}
+	};
+
+	/// \brief a position with the rank of its request. 0 for the fixed positions
+	struct RankedPosition
+	{
+		Point position;
+		size_t rank;
+	};
+
+	typedef std::unordered_map<t_CellKey, std::vector<RankedPosition>, CellKeyHash> t_SpatialHash;
+
 public:
 	/// \brief constructor
-	SpatialConflictSolver();
+	SpatialConflictSolver(Kernel pConflictDistance = SPA_POS_CONFLICT_DISTANCE, unsigned int pNbThreads = 0);
 	/// \brief destructor
 	~SpatialConflictSolver();
 	/// \brief solve the pendante conflict with the Agents
-	inline virtual bool solveConflict(std::vector<Agent*> agent) const;
+	inline virtual bool solveConflict(const std::vector<Agent*>& agent) const;
 
+	/// \brief set the distance under which two positions are in conflict
+	void setConflictDistance(Kernel pDistance)		{ assert(pDistance > 0); conflictDistance = pDistance;};
+	/// \brief return the distance under which two positions are in conflict
+	Kernel getConflictDistance() const				{ return conflictDistance;};
+	/// \brief set the number of threads used for the detection. 0 to follow the hardware
+	void setNbThreads(unsigned int pNbThreads)		{ nbThreads = pNbThreads;};
+
+protected:
+	/// \brief return the key of the hash cell containing the point
+	t_CellKey getCellKey(const Point&) const;
+	/// \brief add the position to the spatial hash
+	void insert(t_SpatialHash&, const Point&, size_t pRank) const;
+	/// \brief return true if a position of rank lower than pRank is in conflict with pPoint
+	bool isInConflict(const t_SpatialHash&, const Point&, size_t pRank) const;
+
+private:
+	Kernel conflictDistance;		///< \brief distance under which two positions are in conflict, also the hash cell size
+	unsigned int nbThreads;			///< \brief number of threads used for the detection. 0 to follow the hardware
 };
 
 //////////////////// FUNCTION DEFINITIONS ///////////////////////////////////
 
 /////////////////////////////////////////////////////////////////////////////
-///
+/// \param pConflictDistance distance under which two positions are in conflict
+/// \param pNbThreads number of threads used for the detection. 0 to follow the hardware
 /////////////////////////////////////////////////////////////////////////////
 template<typename Kernel, typename Point, typename Vector>
-SpatialConflictSolver<Kernel, Point, Vector>::SpatialConflictSolver()
+SpatialConflictSolver<Kernel, Point, Vector>::SpatialConflictSolver(Kernel pConflictDistance, unsigned int pNbThreads):
+	conflictDistance(pConflictDistance),
+	nbThreads(pNbThreads)
 {
-
+	assert(conflictDistance > 0);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -53,67 +114,172 @@ SpatialConflictSolver<Kernel, Point, Vector>::~SpatialConflictSolver()
 
 }
 
+/////////////////////////////////////////////////////////////////////////////
+/// \param pPoint The point to get the cell for
+/// \return the indexes of the hash cell containing the point
+/////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+typename SpatialConflictSolver<Kernel, Point, Vector>::t_CellKey SpatialConflictSolver<Kernel, Point, Vector>::getCellKey(const Point& pPoint) const
+{
+	t_CellKey key = {{0, 0, 0}};
+	for(int iDim = 0; iDim < pPoint.dimension(); ++iDim)
+	{
+		key[iDim] = static_cast<long long int>(std::floor(pPoint.cartesian(iDim) / conflictDistance));
+	}
+	return key;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \param pHash The spatial hash to fill
+/// \param pPoint The position to add
+/// \param pRank The rank of the position
+/////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+void SpatialConflictSolver<Kernel, Point, Vector>::insert(t_SpatialHash& pHash, const Point& pPoint, size_t pRank) const
+{
+	RankedPosition rankedPosition = {pPoint, pRank};
+	pHash[getCellKey(pPoint)].push_back(rankedPosition);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// \param pHash The spatial hash to look into
+/// \param pPoint The position to check
+/// \param pRank Only the positions with a lower rank are considered
+/// \return true if a position of rank lower than pRank is closer than the conflict distance
+/////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+bool SpatialConflictSolver<Kernel, Point, Vector>::isInConflict(const t_SpatialHash& pHash, const Point& pPoint, size_t pRank) const
+{
+	const t_CellKey center = getCellKey(pPoint);
+	const long long int zExtent = pPoint.dimension() > 2 ? 1 : 0;
+	const Kernel squareConflictDistance = conflictDistance*conflictDistance;
+
+	t_CellKey key;
+	for(key[0] = center[0] - 1; key[0] <= center[0] + 1; ++key[0])
+	{
+		for(key[1] = center[1] - 1; key[1] <= center[1] + 1; ++key[1])
+		{
+			for(key[2] = center[2] - zExtent; key[2] <= center[2] + zExtent; ++key[2])
+			{
+				typename t_SpatialHash::const_iterator itCell = pHash.find(key);
+				if(itCell == pHash.end())
+				{
+					continue;
+				}
+
+				typename std::vector<RankedPosition>::const_iterator itPos;
+				for(itPos = itCell->second.begin(); itPos != itCell->second.end(); ++itPos)
+				{
+					if( (itPos->rank < pRank) && (CGAL::squared_distance(itPos->position, pPoint) < squareConflictDistance) )
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 /// \param agents The agents we have to solve conflict for
 /// \return true if conflict solving succeded
 /////////////////////////////////////////////////////////////////////////////
 template<typename Kernel, typename Point, typename Vector>
-bool SpatialConflictSolver<Kernel, Point, Vector>::solveConflict(std::vector<Agent*> agents) const
+bool SpatialConflictSolver<Kernel, Point, Vector>::solveConflict(const std::vector<Agent*>& agents) const
 {
-	std::set<Point> alreadySettedPosition;
-
 	/// cast agent to dynamic
 	/// set none dynamic agent first.
-	typename std::set<DynamicAgent<Kernel, Point, Vector>* > dynamicAgents;
-	std::vector<Agent*>::iterator itIniAgt;
+	t_SpatialHash positions;
+	std::vector<t_DynamicAgent*> dynamicAgents;
+	std::vector<Agent*>::const_iterator itIniAgt;
 	for(itIniAgt = agents.begin(); itIniAgt != agents.end(); ++itIniAgt)
 	{
-		DynamicAgent<Kernel, Point, Vector>*  dymAgt = dynamic_cast<DynamicAgent<Kernel, Point, Vector>* >(*itIniAgt);
+		t_DynamicAgent* dymAgt = dynamic_cast<t_DynamicAgent*>(*itIniAgt);
 		if(dymAgt)
 		{
 			// if doesn't require a new position, he is prioritary
 			if(!dymAgt->isRequiringNewPos())
 			{
-				alreadySettedPosition.insert(dymAgt->getPosition());
+				insert(positions, dymAgt->getPosition(), 0);
 			}else
 			{
-				dynamicAgents.insert(dymAgt);
+				dynamicAgents.push_back(dymAgt);
 			}
 		}
 	}
 
-	/// check position
-	typename std::set<DynamicAgent<Kernel, Point, Vector>* >::iterator itAgent;
-	for(itAgent = dynamicAgents.begin(); itAgent != dynamicAgents.end(); ++itAgent)
+	if(dynamicAgents.empty())
 	{
-		if(alreadySettedPosition.find((*itAgent)->getRequestedPosition()) == alreadySettedPosition.end())
-		{
-			alreadySettedPosition.insert((*itAgent)->getRequestedPosition());
-		}else
-		{
-			// get a random point on "journey"/ flight
-			double ratio;
-			Vector v((*itAgent)->getPosition() -  (*itAgent)->getRequestedPosition());
-			unsigned int nbIter = 0;
-			while( 	(alreadySettedPosition.find((*itAgent)->getPosition() + v*ratio) != alreadySettedPosition.end() ) &&
-					( nbIter < NB_MAX_ITER_TO_SOLVE_SPA_POS ) )
+		return true;
+	}
+
+	/// request i has the rank i+1
+	for(size_t iAgent = 0; iAgent < dynamicAgents.size(); ++iAgent)
+	{
+		insert(positions, dynamicAgents[iAgent]->getRequestedPosition(), iAgent + 1);
+	}
+
+	/// detect the conflicting requests. The spatial hash is only read : each thread handles chunks of requests
+	std::vector<char> conflicting(dynamicAgents.size(), 0);
+	{
+		const size_t chunkSize = 256;
+		processChunksInParallel(dynamicAgents.size(), chunkSize, getNbThreadsFor(dynamicAgents.size(), MIN_NB_AGENT_PER_SPA_CONFLICT_THREAD, nbThreads),
+			[&](size_t pBegin, size_t pEnd, unsigned int)
 			{
-				ratio = ratio / 2.;
-				nbIter++;
-			}
-			
-			if(nbIter >= NB_MAX_ITER_TO_SOLVE_SPA_POS )
+				for(size_t iAgent = pBegin; iAgent < pEnd; ++iAgent)
+				{
+					conflicting[iAgent] = isInConflict(positions, dynamicAgents[iAgent]->getRequestedPosition(), iAgent + 1);
+				}
+			});
+	}
+
+	/// keep the fixed positions and the accepted requests
+	t_SpatialHash accepted;
+	typename t_SpatialHash::const_iterator itCell;
+	for(itCell = positions.begin(); itCell != positions.end(); ++itCell)
+	{
+		typename std::vector<RankedPosition>::const_iterator itPos;
+		for(itPos = itCell->second.begin(); itPos != itCell->second.end(); ++itPos)
+		{
+			if( (itPos->rank == 0) || !conflicting[itPos->rank - 1])
 			{
-				std::cout << " too much conflict " << std::endl;
-				return false;
+				accepted[itCell->first].push_back(*itPos);
 			}
+		}
+	}
+
+	/// move the rejected requests along their journey, the last try is the current position
+	const size_t anyRank = std::numeric_limits<size_t>::max();
+	for(size_t iAgent = 0; iAgent < dynamicAgents.size(); ++iAgent)
+	{
+		if(!conflicting[iAgent])
+		{
+			continue;
+		}
+
+		t_DynamicAgent* agent = dynamicAgents[iAgent];
+		Vector journey(agent->getRequestedPosition() - agent->getPosition());
+		double ratio = 1.;
+		Point newPos = agent->getRequestedPosition();
+		unsigned int nbIter = 0;
+		while( isInConflict(accepted, newPos, anyRank) && (nbIter <= NB_MAX_ITER_TO_SOLVE_SPA_POS) )
+		{
+			ratio = ratio / 2.;
+			nbIter++;
+			newPos = (nbIter < NB_MAX_ITER_TO_SOLVE_SPA_POS) ? agent->getPosition() + journey*ratio : agent->getPosition();
+		}
 
-			Point newPos = (*itAgent)->getPosition() + v*ratio;
-			(*itAgent)->setRequiredPosition(newPos);
-			alreadySettedPosition.insert(newPos);
+		if(nbIter > NB_MAX_ITER_TO_SOLVE_SPA_POS)
+		{
+			std::cout << " too much conflict " << std::endl;
+			return false;
 		}
+
+		agent->setRequiredPosition(newPos);
+		insert(accepted, newPos, iAgent + 1);
 	}
 	return true;
 }
 
-#endif // POSITION_CONFLICT_SOLVER_HH
\ No newline at end of file
+#endif // POSITION_CONFLICT_SOLVER_HH
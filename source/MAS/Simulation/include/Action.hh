@@ -15,7 +15,8 @@ See LICENSE.md for further details
 /// at each step we will check simulation time and if the action's time is reach 
 /// or beyond then the action will be launch. 
 /// \details
-/// On the worst case the action time can be exceed near a simulation step duration
+/// On the worst case the action time can be exceed near a simulation step duration.
+/// A punctual action with a positive period is repeated each period from its time.
 /// @author Henri Payno
 //////////////////////////////////////////////////////////////////////////////
 class Action
@@ -32,7 +33,7 @@ public:
 
 public:
 	/// \brief constructor
-	Action(ACTION_FREQUENCY pFrequency, double pTime = 0.);
+	Action(ACTION_FREQUENCY pFrequency, double pTime = 0., double pPeriod = 0.);
 
 	/// \brief destructor
 	virtual ~Action();
@@ -44,10 +45,13 @@ public:
 	double getActionTime()	const			{return actionTime;};
 	/// \brief return the frequency of the actions
 	ACTION_FREQUENCY getFrequency()	const 	{return frequency;};
+	/// \brief return the time between two executions of a punctual action. Not positive if run once
+	double getPeriod() const				{return period;};
 
 private:
 	ACTION_FREQUENCY frequency;		///< The freqeuncy of the action
 	double actionTime;				///< The time requested for this action.
+	double period;					///< The time between two executions, if positive.
 
 };
 #endif	// ACTION_HH
\ No newline at end of file
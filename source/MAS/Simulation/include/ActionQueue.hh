@@ -0,0 +1,94 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef ACTION_QUEUE_HH
+#define ACTION_QUEUE_HH
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+class Action;
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief priority queue of the actions to run, ordered by (time, sequence).
+/// \details The sequence is the scheduling order, kept by the next occurrences of
+/// recurring actions : actions due at the same time run in the order they have been scheduled. Actions to run at each step are
+/// due before any timed action.
+/// Each scheduled action gets an ID which stays the same for all its occurrences.
+/// Cancelled entries are dropped when they reach the top of the heap.
+//////////////////////////////////////////////////////////////////////////////
+class ActionQueue
+{
+public:
+	/// \brief identify an action scheduled, for all its occurrences
+	typedef unsigned long int ActionID;
+
+	/// \brief constructor
+	ActionQueue();
+	/// \brief destructor. Actions are not deleted
+	~ActionQueue()													{};
+
+	/// \brief schedule an action at pTime, repeated each pPeriod if positive. O(log n)
+	ActionID push(Action* pAction, double pTime, double pPeriod = 0.);
+	/// \brief schedule an action to run at each process. O(log n)
+	ActionID pushEachStep(Action* pAction);
+	/// \brief cancel the next occurrences of the action scheduled. O(log n)
+	bool cancel(ActionID pID);
+	/// \brief cancel the next occurrences of all the schedulings of the action. O(n)
+	unsigned int cancel(const Action* pAction);
+	/// \brief forget all the actions
+	void clear();
+
+	/// \brief run the actions due at pTime
+	bool process(double pTime);
+
+	/// \brief return true if the action scheduled has occurrences left
+	bool isPending(ActionID pID) const								{ return pending.find(pID) != pending.end();};
+	/// \brief return the number of actions scheduled with occurrences left
+	size_t size() const												{ return pending.size();};
+	/// \brief return true if no action is scheduled
+	bool empty() const												{ return pending.empty();};
+
+private:
+	/// \brief an occurrence of an action
+	struct Entry
+	{
+		double time;					///< \brief time the occurrence is due
+		unsigned long int sequence;		///< \brief scheduling order, break ties between occurrences due at the same time
+		ActionID id;					///< \brief the scheduling the occurrence belongs to
+		Action* action;					///< \brief the action to run
+		double period;					///< \brief time between two occurrences. Not positive if punctual
+		bool eachStep;					///< \brief true if the action runs at each process
+	};
+
+	/// \brief strict weak ordering on (time, sequence), greater first to get a min-heap from the std heap functions
+	struct LaterEntry
+	{
+		bool operator() (const Entry& e1, const Entry& e2) const
+		{
+			if(e1.time != e2.time)
+			{
+				return e1.time > e2.time;
+			}
+			return e1.sequence > e2.sequence;
+		}
+	};
+
+	/// \brief add an occurrence on the heap
+	void pushEntry(const Entry& pEntry);
+	/// \brief remove the cancelled entries if they are the majority of the heap
+	void compact();
+
+	std::vector<Entry> heap;				///< \brief the occurrences to run, as a min-heap on (time, sequence)
+	std::map<ActionID, Action*> pending;	///< \brief the schedulings not over nor cancelled
+	unsigned long int nextSequence;			///< \brief sequence of the next action scheduled
+	ActionID nextID;						///< \brief ID of the next action scheduled
+};
+
+#endif // ACTION_QUEUE_HH
@@ -43,6 +43,14 @@ public:
 	void setDuration(double);
 	/// \brief set the duration of steps
 	void setStepDuration(double);
+	/// \brief adapt the duration of steps to the motion of the agents
+	void setAdaptiveStepDuration(double pMinStep, double pMaxStep, double pSafetyFactor = 0.5, double pMaxGrowth = 2.);
+	/// \brief use steps of fixed duration
+	void unsetAdaptiveStepDuration();
+	/// \brief define when the simulation can stop before its duration
+	void setStoppingRule(const StoppingRule&);
+	/// \brief return the metrics of the last step simulated
+	const StepMetrics& getLastStepMetrics() const;
 	/// \brief displacementThreshold setter
 	void setDisplacementThreshold(double pThreshold) const;
 	/// \brief displacementThreshold getter
@@ -57,11 +65,17 @@ public:
 	void removeConflictSolver(ConflictSolver*);
 	/// \brief add a participant to the MAS platform
 	int addParticipant(Agent*);
+	/// \brief remove a participant from the MAS platform
+	int removeParticipant(Agent*);
 
 	/// \brief we will execute randomly a limited number of agent 
 	void limiteNbAgentToSimulate(unsigned int );
 	/// \brief avoid limitation of agent, execute all agent
 	void unlimiteNbAgentToSimulate(bool);
+	/// \brief store the step state of the dynamic agents in contiguous arrays
+	void useAgentStateStore(bool);
+	/// \brief keep the neighbour lists of the forces with a cutoff until agents moved of half the skin
+	void setNeighbourListSkin(double);
 
 private: 
 	/// \brief defined the agent to simulate from the layer
@@ -0,0 +1,75 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef PARALLEL_CHUNKS_HH
+#define PARALLEL_CHUNKS_HH
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief give the indices [0, n[ by chunks of consecutive indices to the threads sharing it.
+/// \details a thread which meets cheap items simply takes more chunks.
+/// In guided mode the chunks shrink with the number of remaining items so that
+/// the expensive items met at the end are spread over all threads.
+//////////////////////////////////////////////////////////////////////////////
+class ChunkQueue
+{
+public:
+	/// \brief constructor. pNbGuidedWorkers : number of threads sharing the queue to guide the chunk size, 0 for fixed size chunks
+	ChunkQueue(std::size_t pNbItems, std::size_t pChunkSize, unsigned int pNbGuidedWorkers = 0);
+
+	/// \brief take the next chunk [pBegin, pEnd[. Return false if no more item to process
+	bool takeChunk(std::size_t& pBegin, std::size_t& pEnd);
+	/// \brief return the number of items
+	std::size_t size() const							{ return nbItems; }
+
+private:
+	std::size_t nbItems;						///< \brief number of items to process
+	std::size_t chunkSize;						///< \brief the maximal number of items in a chunk
+	unsigned int nbGuidedWorkers;				///< \brief number of threads sharing the queue, 0 if chunks are of fixed size
+	std::atomic<std::size_t> next;				///< \brief index of the first item not given yet
+};
+
+/// \brief return the number of threads to use for pNbItems : pMaxThreads (the hardware one if 0),
+/// without creating threads with less than pMinItemsPerThread items. At least 1
+unsigned int getNbThreadsFor(std::size_t pNbItems, std::size_t pMinItemsPerThread, unsigned int pMaxThreads = 0);
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief call pProcess(begin, end, threadID) over chunks of [0, pNbItems[ taken
+/// from a shared ChunkQueue by pNbThreads threads, the calling one included with ID 0.
+/// Return once all the items are processed
+//////////////////////////////////////////////////////////////////////////////
+template<typename Process>
+void processChunksInParallel(std::size_t pNbItems, std::size_t pChunkSize, unsigned int pNbThreads, const Process& pProcess)
+{
+	ChunkQueue lQueue(pNbItems, pChunkSize);
+	auto lTakeChunks = [&](unsigned int pThreadID)
+	{
+		std::size_t lBegin, lEnd;
+		while(lQueue.takeChunk(lBegin, lEnd))
+		{
+			pProcess(lBegin, lEnd, pThreadID);
+		}
+	};
+
+	std::vector<std::thread> lThreads;
+	for(unsigned int iThread = 1; iThread < pNbThreads; ++iThread)
+	{
+		lThreads.push_back(std::thread(lTakeChunks, iThread));
+	}
+	lTakeChunks(0);
+	for(std::vector<std::thread>::iterator itThread = lThreads.begin(); itThread != lThreads.end(); ++itThread)
+	{
+		itThread->join();
+	}
+}
+
+#endif // PARALLEL_CHUNKS_HH
@@ -11,14 +11,51 @@ See LICENSE.md for further details
 
 #include <CLHEP/Random/RandomEngine.h>
 
+#include <algorithm>
 #include <assert.h>
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 #include <QString>
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief counter based random stream (Philox4x32-10).
+/// \details The n-th number of the stream is a pure function of the seed, the stream ID,
+/// the step and n. Streams are small value objects : each agent can build its own on its
+/// thread, and the numbers drawn do not depend on the number of threads nor on the order
+/// agents are executed.
+/// \warning the step takes one 32 bits word of the counter : streams of the steps s and
+/// s + 2^32 are the same.
+//////////////////////////////////////////////////////////////////////////////////////////////
+class RandomStream
+{
+public:
+	/// \brief constructor
+	RandomStream(uint64_t pSeed, uint64_t pStreamID, uint32_t pStep);
+
+	/// \brief return a random double value in [0, 1[
+	double randd();
+	/// \brief return a random double value between min and max
+	double randd(double min, double max);
+	/// \brief return a random value between min and max (included)
+	int randi(int min, int max);
+
+	/// \brief return the Philox4x32-10 block of the counter for the key
+	static void philox(const uint32_t pKey[2], const uint32_t pCounter[4], uint32_t pBlock[4]);
+
+private:
+	uint32_t key[2];		///< \brief the seed
+	uint32_t counter[4];	///< \brief {block index, step, stream ID low, stream ID high}
+	uint32_t block[4];		///< \brief the last block generated
+	unsigned int nbUsed;	///< \brief number of words of block already used
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 /// \brief The manager dealing with the random engine.
 /// basically a simple call to the CLHEP engine with some add on functions
+/// \warning the engine functions are not thread safe : agents executed by the
+/// simulation threads must draw from a stream (getStream).
 /// @author Henri Payno
 //////////////////////////////////////////////////////////////////////////////////////////////
 class RandomEngineManager
@@ -35,6 +72,14 @@ public:
 	void setEngine(CLHEP::HepRandomEngine*);
     /// \brief CLHEP engine getter
     CLHEP::HepRandomEngine* getEngine() const { return rndEngine;}
+
+    /// \brief seed of the streams setter. Also set from the engine seed by setEngine
+    void setStreamSeed(uint64_t pSeed)      { streamSeed = pSeed;}
+    /// \brief seed of the streams getter
+    uint64_t getStreamSeed() const          { return streamSeed;}
+    /// \brief return the stream of the given ID (agent ID...) for a simulation step. Thread safe.
+    /// Only the 32 low bits of the step are used : streams repeat every 2^32 steps
+    RandomStream getStream(uint64_t pStreamID, unsigned long int pStep) const   { return RandomStream(streamSeed, pStreamID, static_cast<uint32_t>(pStep));}
     
     /// \brief return a random double value between 0 and 1
     double randd();
@@ -68,11 +113,26 @@ public:
         return pVector->at(randi(0, pVector->size()-1));
     }
 
+    /// \brief move a uniform random subset of k elements on the first k positions (partial Fisher-Yates).
+    /// \details O(k) : the other elements stay in the vector, in any order.
+    /// The vector stays a permutation of its elements and can be reused at each call
+    template<typename Elmt>
+    void pickRandomFirst(std::vector<Elmt>& pVector, size_t k)
+    {
+        assert(k <= pVector.size());
+        for(size_t i = 0; i < k; ++i)
+        {
+            size_t j = randi(static_cast<int>(i), static_cast<int>(pVector.size() - 1));
+            std::swap(pVector[i], pVector[j]);
+        }
+    }
+
     /// \brief return the current shoot made
     // int getIShoot() const { return iShoot;}
 
 private:
 	CLHEP::HepRandomEngine* rndEngine;     ///< \brief the CLHEP engine used
+    uint64_t streamSeed;                   ///< \brief the key of the counter based streams
     std::ofstream* outputRandom;           ///< \brief used for debug
     // int iShoot;                            ///< \brief number of number shooted, used for random
 
@@ -10,9 +10,10 @@ See LICENSE.md for further details
 #define SCHEDULER_HH
 
 #include "Action.hh"
+#include "ActionQueue.hh"
 
 #include <assert.h>
-#include <set>
+#include <atomic>
 
 //////////////////////////////////////////////////////////////////////////////
 /// \brief Handles scheduling of action and the timer. Set as a singleton
@@ -22,28 +23,6 @@ class Scheduler
 {
 	friend class MASPlatform;
 
-	/// \brief used to served as the comparaison operation between actions
-	/// \todo : make a unitary test to check construction is on the right order
-	/// redefining the set structure in order to have it on this order :
-	/// 1. EACH BEGIN ITERATION
-	/// 2. punctual action ordered by increasing action's time
-	struct action_timing_comparison
-	{
-		/// \brief operator used to order actions
-		bool operator() (const Action* act1, const Action* act2) const
-		{
-			if(act1->getFrequency() == Action::EACH_BEGIN_ITERATION ||
-				act1->getFrequency() ==	Action::EACH_END_ITERATION)
-				return true;
-
-			if(act2->getFrequency() == Action::EACH_BEGIN_ITERATION ||
-				act2->getFrequency() ==	Action::EACH_END_ITERATION)
-				return false;
-
-			return act1->getActionTime() < act2->getActionTime();
-		}
-	};
-
 public:
 	/// \brief constructor
 	Scheduler();
@@ -52,14 +31,27 @@ public:
 
 	/// \brief schedule a given action to process
 	bool scheduleAction(Action*);
+	/// \brief stop to process the given action
+	bool cancelAction(const Action*);
 
 	/// \brief return the simulation time
 	inline double getRunningTime() const	{return currentTime;};
 
+	/// \brief return the index of the current simulated step, from 1. 0 before the first step
+	inline unsigned long int getStepIndex() const	{return stepIndex;};
 	/// \brief return the duration of the current simulated step
-	inline double getStepDuration() const	{return stepDuration;};
+	inline double getStepDuration() const	{return currentStepDuration;};
+	/// \brief return the ratio of the current step duration to the reference step duration.
+	/// Always 1 with fixed steps
+	inline double getStepScale() const		{return adaptiveStep ? currentStepDuration / stepDuration : 1.;};
+	/// \brief return true if the step duration is adapted to the motion of the previous step
+	inline bool isAdaptiveStep() const		{return adaptiveStep;};
+	/// \brief register the force acting on an agent during the current step. Thread safe
+	void reportAgentForce(double pForce);
 	/// \brief return the singleton of the instance
 	static Scheduler* getInstance();
+	/// \brief return true if the singleton exists
+	static bool hasInstance();
 	/// \brief reset all scheduler parameters, timers and action scheduled
 	void reset();
 	/// \brief Compute the simulation step duration
@@ -76,10 +68,16 @@ protected:
 	void setDuration(double pDuration) 		{totalDuration = pDuration;};
 	/// \brief  define the duration of a step
 	void setStepDuration(double pDuration) 	{stepDuration = pDuration;};
+	/// \brief enable the adaptive step duration
+	void setAdaptiveStep(double pMinStep, double pMaxStep, double pSafetyFactor, double pMaxGrowth);
+	/// \brief go back to fixed steps of stepDuration
+	void unsetAdaptiveStep()				{adaptiveStep = false;};
 
 private:
 	/// \brief will run each requested actions
 	bool processActions(bool postIteration);
+	/// \brief return the duration of the next step according to the motion of the previous one
+	double computeAdaptiveStepDuration() const;
 
 	/// \brief duration of a step on the simulation time
 	double stepDuration; 	///< in s
@@ -87,11 +85,23 @@ private:
 	double currentTime; 		///< in s
 	/// \brief duration of the simulation;
 	double totalDuration; 	//< in s
-
-	// The vector structure enable to process actions in the same order they have been registred.
-	// \todo : find a better data structure to speed up this process.
-	std::set<Action*, action_timing_comparison> preIterationActions;		///< The pre iteration actions
-	std::set<Action*, action_timing_comparison> postIterationActions;	///< The post iteration actions
+	/// \brief duration of the step being simulated
+	double currentStepDuration;	///< in s
+	/// \brief number of steps computed since the begining of the run
+	unsigned long int stepIndex;
+
+	bool adaptiveStep;				///< \brief true if the step duration follows the agent motion
+	double minStepDuration;			///< \brief lower bound of the adaptive step duration, in s
+	double maxStepDuration;			///< \brief upper bound of the adaptive step duration, in s
+	double safetyFactor;			///< \brief part of the displacement threshold the fastest agent can travel during a step
+	double maxGrowth;				///< \brief maximal ratio between two consecutive step durations
+
+	std::atomic<double> maxForce;	///< \brief maximal force norm reported during the last step
+
+	// Actions at each iteration first, then punctual actions by increasing time.
+	// Actions with the same timing are processed in the order they have been registred.
+	ActionQueue preIterationActions;		///< The pre iteration actions
+	ActionQueue postIterationActions;		///< The post iteration actions
 };
 
 #endif
@@ -10,7 +10,9 @@ See LICENSE.md for further details
 #define SIMULATION_MANAGER_HH
 
 #include "ConflictSolver.hh"
+#include "DynamicAgent.hh"
 #include "Layer.hh"
+#include "StoppingRule.hh"
 #include "ThreadAgentGroup.hh"
 
 #include <QThread>
@@ -50,10 +52,20 @@ public:
 	void reset();
 	/// \brief displacementThreshold getter
 	double getDisplacementThreshold() const						{ return displacementThreshold; };
+	/// \brief return the metrics of the last step simulated
+	const StepMetrics& getLastStepMetrics() const				{ return lastStepMetrics; };
+	/// \brief return the current neighbour lists epoch. Lists built on a previous epoch must be rebuilt
+	unsigned long int getNeighbourListEpoch() const				{ return neighbourListEpoch; };
+	/// \brief return the skin added to the cutoff of the neighbour lists. Not used if not positive
+	double getNeighbourListSkin() const							{ return neighbourListSkin; };
+	/// \brief return the epoch of the neighbour lists with a cutoff and a skin. Lists built on a previous epoch must be rebuilt
+	unsigned long int getSkinListEpoch() const					{ return skinListEpoch; };
 
 protected:
 	/// \brief add the agent on the simulation
 	int addAgent(Agent*);
+	/// \brief remove the agent from the simulation
+	int removeAgent(Agent*);
 	/// \brief the initialization of the simulation manager.
 	int init(); 
 	/// \brief conflict solver adder
@@ -65,9 +77,15 @@ protected:
 	void setDisplacementThreshold(double pThreshold)			{ displacementThreshold = pThreshold; };
 
 	/// \brief we will execute randomly a limited number of agent 
-	void limiteNbAgentToSimulate(unsigned int i )				{numberOfAgentToExecute = i;};
+	void limiteNbAgentToSimulate(unsigned int i )				{numberOfAgentToExecute = i; bExecuteAllAgent = false;};
 	/// \brief avoid limitation of agent, execute all agent
 	void unlimiteNbAgentToSimulate(bool b)						{bExecuteAllAgent = b;};
+	/// \brief define when the simulation can stop before its duration
+	void setStoppingRule(const StoppingRule& pRule)				{stoppingRule = pRule;};
+	/// \brief if true dynamic agents write their step state in contiguous stores
+	void useAgentStateStore(bool b)								{bUseStateStore = b;};
+	/// \brief neighbourListSkin setter
+	void setNeighbourListSkin(double pSkin)						{neighbourListSkin = pSkin; invalidateNeighbourLists();};
 
 private:
 	/// \brief return the best trhad to set this agent on.
@@ -82,28 +100,48 @@ private:
 	/// \brief run one step by the intermediary thread agent group 
 	bool runOneStepWithThread();
 	/// \brief pick randomly agent from the one to simulate
-	set<Agent*> pickRandomlyAgts(unsigned int);
+	void pickRandomlyAgts(unsigned int, vector<Agent*>& pPicked);
 	/// \brief setter  of the maximal number of thread
 	void setMaxNumberOfThread(int nb) {maxThreadAgentGroup = nb;};
 	/// \brief top layer setter, needed to know SDS to update.
 	void setTopLayer(Layer*);
 	/// \brief return all the agents running
-	vector<Agent*> getAllAgents();
+	const vector<Agent*>& getAllAgents() const					{ return managedAgents;};
+	/// \brief return the agents executed during the last step
+	const vector<Agent*>& getAgentsExecutedLastStep() const		{ return bExecutedAllLastStep ? managedAgents : agentExecutedLastStep;};
 	/// \brief update spatial data structures
 	void updateSDS();
 	/// \brief run all conflict manager
 	bool solveConflicts();
 	/// \brief update agent states ( include his position )
 	bool updateAgentState();
+	/// \brief update a dynamic agent executed and add it to the step metrics
+	template<typename Kernel, typename Point, typename Vector>
+	bool updateDynamicAgentState(Agent*, bool pWithInteractions);
+	/// \brief update the agents executed of a state store and add them to the step metrics
+	template<typename Kernel, typename Point, typename Vector>
+	void updateStoredAgentState(AgentStateStore<Kernel, Point, Vector>&, bool pWithInteractions);
+	/// \brief register the dynamic agents on the state stores
+	void buildStateStores();
+	/// \brief unbind agents from the state stores
+	void clearStateStores();
+	/// \brief force the rebuild of all the neighbour lists
+	void invalidateNeighbourLists();
 	/// \brief tag agent to execute during the next simulation step
 	void updateAgentToExecute();
 	
 private:
 	/// \brief the map of agent group. The key is the trehad ID
 	map<int, ThreadAgentGroup*> agentGroups; 
+	/// \brief the thread group of an agent and its index on managedAgents
+	struct AgentHandle
+	{
+		ThreadAgentGroup* thread;	///< \brief the thread group executing the agent
+		size_t index;				///< \brief index of the agent on managedAgents
+	};
 	/// \brief the map of the agent handlers
-	map<Agent*, ThreadAgentGroup*> agentHandler;
-	/// \brief store all agent manage
+	map<Agent*, AgentHandle> agentHandler;
+	/// \brief store all agent manage, without hole
 	vector<Agent*> managedAgents;
 
 	/// \brief the set of threads the simulation is waiting for to process next state
@@ -124,8 +162,38 @@ private:
 	bool bExecuteAllAgent;
 	/// \brief the number of agent to exexute if we want to execute a limited number of them.
 	unsigned int numberOfAgentToExecute;
-	/// \brief the set of agent executed last step
-	set<Agent*> agentExecutedLastStep;
+	/// \brief the agents executed last step, if not all of them
+	vector<Agent*> agentExecutedLastStep;
+	/// \brief true if all agents have been executed last step
+	bool bExecutedAllLastStep;
+	/// \brief the agents managed, permuted by each random pick
+	vector<Agent*> pickableAgents;
+	/// \brief true if agents have been removed since pickableAgents has been built
+	bool bPickableAgentsDirty;
+	/// \brief true if agents have been added or removed since the agents have been tagged
+	bool bAgentTagsDirty;
+	/// \brief define when the simulation can stop before its duration
+	StoppingRule stoppingRule;
+	/// \brief the metrics of the last step simulated
+	StepMetrics lastStepMetrics;
+
+	/// \brief do dynamic agents use the state stores
+	bool bUseStateStore;
+	/// \brief true if agents have been added or removed since the state stores have been built
+	bool bStateStoresDirty;
+	/// \brief the step state of the 2D dynamic agents
+	AgentStateStore<double, Point_2, Vector_2> stateStore_2;
+	/// \brief the step state of the 3D dynamic agents
+	AgentStateStore<double, Point_3, Vector_3> stateStore_3;
+
+	/// \brief incremented each time the neighbour lists must be rebuilt : SDS update, agent added or removed
+	unsigned long int neighbourListEpoch;
+	/// \brief distance added to the cutoff of the neighbour lists, so they can be kept while agents move
+	double neighbourListSkin;
+	/// \brief the neighbourListEpoch on which the lists with a skin have been invalidated
+	unsigned long int skinListEpoch;
+	/// \brief upper bound of the distance travelled by any agent since skinListEpoch
+	double displacementSinceEpoch;
 
 signals:
 	/// \brief the signal of the step has end run
@@ -0,0 +1,86 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef STOPPING_RULE_HH
+#define STOPPING_RULE_HH
+
+#include <QString>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief aggregate metrics of the dynamic agents executed during a simulation step
+/// \details the elastic energy and the overlap volume are estimated for the whole
+/// population from the agents executed (they are all executed when the number of
+/// agents to simulate is not limited).
+//////////////////////////////////////////////////////////////////////////////
+struct StepMetrics
+{
+	/// \brief constructor
+	StepMetrics()							{ reset();};
+	/// \brief set all metrics to zero
+	void reset();
+	/// \brief return a description of the metrics
+	QString toString() const;
+
+	unsigned int nbAgents;		///< \brief number of dynamic agents executed
+	double meanDisplacement;	///< \brief mean displacement of the agents executed
+	double maxDisplacement;		///< \brief maximal displacement of the agents executed
+	double elasticEnergy;		///< \brief total potential energy of the forces
+	double overlapVolume;		///< \brief total volume shared by neighbour agents
+	bool hasInteractionMetrics;	///< \brief true if elasticEnergy and overlapVolume have been computed
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief define when a simulation can stop before its duration because the
+/// agents are no longer evolving.
+/// \details A step is converged when each enabled criterion is fulfilled. The simulation
+/// stops after nbSteps consecutive converged steps. A criterion is disabled if its tolerance is negative.
+/// Energy and overlap criteria are relative changes between two consecutive steps.
+//////////////////////////////////////////////////////////////////////////////
+class StoppingRule
+{
+public:
+	/// \brief constructor. All criteria are disabled
+	StoppingRule();
+
+	/// \brief maximal displacement of a converged step
+	void setMaxDisplacement(double pTolerance)			{ maxDisplacement = pTolerance;};
+	/// \brief mean displacement of a converged step
+	void setMeanDisplacement(double pTolerance)			{ meanDisplacement = pTolerance;};
+	/// \brief relative change of the elastic energy of a converged step
+	void setEnergyChange(double pTolerance)				{ energyChange = pTolerance;};
+	/// \brief relative change of the overlap volume of a converged step
+	void setOverlapChange(double pTolerance)			{ overlapChange = pTolerance;};
+	/// \brief number of consecutive converged steps needed to stop
+	void setNbSteps(unsigned int pNbSteps)				{ nbSteps = (pNbSteps > 0) ? pNbSteps : 1;};
+
+	/// \brief return true if at least one criterion is enabled
+	bool isEnabled() const;
+	/// \brief return true if the elastic energy or the overlap volume are needed
+	bool needsInteractionMetrics() const				{ return energyChange >= 0. || overlapChange >= 0.;};
+
+	/// \brief forget the previous steps
+	void reset();
+	/// \brief register the metrics of a new step. Return true if the simulation should stop
+	bool update(const StepMetrics& pMetrics);
+
+private:
+	/// \brief return true if pMetrics fulfill all criteria enabled
+	bool isConverged(const StepMetrics& pMetrics) const;
+
+	double maxDisplacement;		///< \brief tolerance on the maximal displacement
+	double meanDisplacement;	///< \brief tolerance on the mean displacement
+	double energyChange;		///< \brief tolerance on the relative change of elastic energy
+	double overlapChange;		///< \brief tolerance on the relative change of overlap volume
+	unsigned int nbSteps;		///< \brief number of consecutive converged steps needed to stop
+
+	unsigned int nbConvergedSteps;	///< \brief number of consecutive converged steps so far
+	bool hasPreviousMetrics;		///< \brief true if previousMetrics is set
+	StepMetrics previousMetrics;	///< \brief the metrics of the previous step
+};
+
+#endif // STOPPING_RULE_HH
@@ -10,19 +10,25 @@ See LICENSE.md for further details
 #include "Scheduler.hh"
 
 //////////////////////////////////////////////////////////////////////////////////
-///
+/// \param pFrequency When the action is run
+/// \param pTime The time of the first execution of a punctual action
+/// \param pPeriod The time between two executions of a punctual action. Not positive to run it once
 //////////////////////////////////////////////////////////////////////////////////
-Action::Action(ACTION_FREQUENCY pFrequency, double pTime):
+Action::Action(ACTION_FREQUENCY pFrequency, double pTime, double pPeriod):
 	frequency(pFrequency), 
-	actionTime(pTime)	
+	actionTime(pTime),
+	period(pPeriod)
 {
 	Scheduler::getInstance()->scheduleAction(this);	
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-///
+/// \details the action is no longer run by the scheduler
 //////////////////////////////////////////////////////////////////////////////////
 Action::~Action()
 {
-
+	if(Scheduler::hasInstance())
+	{
+		Scheduler::getInstance()->cancelAction(this);
+	}
 }
@@ -0,0 +1,196 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "ActionQueue.hh"
+#include "Action.hh"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+ActionQueue::ActionQueue():
+	nextSequence(0),
+	nextID(1)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pAction The action to run
+/// \param pTime The time of the first occurrence
+/// \param pPeriod The time between two occurrences. Not positive to run it once
+/// \return the ID of the scheduling
+//////////////////////////////////////////////////////////////////////////////
+ActionQueue::ActionID ActionQueue::push(Action* pAction, double pTime, double pPeriod)
+{
+	assert(pAction);
+	Entry lEntry = {pTime, nextSequence++, nextID++, pAction, pPeriod, false};
+	pending.insert(make_pair(lEntry.id, pAction));
+	pushEntry(lEntry);
+	return lEntry.id;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pAction The action to run
+/// \return the ID of the scheduling
+//////////////////////////////////////////////////////////////////////////////
+ActionQueue::ActionID ActionQueue::pushEachStep(Action* pAction)
+{
+	assert(pAction);
+	Entry lEntry = {-numeric_limits<double>::infinity(), nextSequence++, nextID++, pAction, 0., true};
+	pending.insert(make_pair(lEntry.id, pAction));
+	pushEntry(lEntry);
+	return lEntry.id;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pEntry The occurrence to add, its sequence already set
+//////////////////////////////////////////////////////////////////////////////
+void ActionQueue::pushEntry(const Entry& pEntry)
+{
+	heap.push_back(pEntry);
+	push_heap(heap.begin(), heap.end(), LaterEntry());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pID The scheduling to cancel
+/// \return true if the scheduling had occurrences left
+//////////////////////////////////////////////////////////////////////////////
+bool ActionQueue::cancel(ActionID pID)
+{
+	if(pending.erase(pID) == 0)
+	{
+		return false;
+	}
+	compact();
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pAction The action to cancel
+/// \return the number of schedulings cancelled
+//////////////////////////////////////////////////////////////////////////////
+unsigned int ActionQueue::cancel(const Action* pAction)
+{
+	unsigned int lNbCancelled = 0;
+	map<ActionID, Action*>::iterator itPending = pending.begin();
+	while(itPending != pending.end())
+	{
+		if(itPending->second == pAction)
+		{
+			pending.erase(itPending++);
+			lNbCancelled++;
+		}else
+		{
+			++itPending;
+		}
+	}
+	if(lNbCancelled > 0)
+	{
+		compact();
+	}
+	return lNbCancelled;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void ActionQueue::clear()
+{
+	heap.clear();
+	pending.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details keeps the heap size in O(number of actions pending)
+//////////////////////////////////////////////////////////////////////////////
+void ActionQueue::compact()
+{
+	if(heap.size() <= 2 * pending.size() + 16)
+	{
+		return;
+	}
+	vector<Entry> lKept;
+	lKept.reserve(pending.size());
+	vector<Entry>::const_iterator itEntry;
+	for(itEntry = heap.begin(); itEntry != heap.end(); ++itEntry)
+	{
+		if(isPending(itEntry->id))
+		{
+			lKept.push_back(*itEntry);
+		}
+	}
+	heap.swap(lKept);
+	make_heap(heap.begin(), heap.end(), LaterEntry());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details Occurrences due at pTime run in (time, sequence) order. A recurring
+/// action runs once per process : its next occurrence is the first one after pTime,
+/// the occurrences missed during a long step are merged.
+/// If an action fails it stays scheduled and the next ones are not run.
+/// \param pTime The current simulation time
+/// \return true if all the actions run succeed
+//////////////////////////////////////////////////////////////////////////////
+bool ActionQueue::process(double pTime)
+{
+	vector<Entry> lRecurring;
+	bool lSucceed = true;
+	while(!heap.empty() && heap.front().time <= pTime)
+	{
+		pop_heap(heap.begin(), heap.end(), LaterEntry());
+		Entry lEntry = heap.back();
+		heap.pop_back();
+
+		// cancelled
+		if(!isPending(lEntry.id))
+		{
+			continue;
+		}
+
+		if(!lEntry.action->exec())
+		{
+			// keep its place for the next process
+			pushEntry(lEntry);
+			lSucceed = false;
+			break;
+		}
+
+		// the action can cancel itself during its execution
+		if(!isPending(lEntry.id))
+		{
+			continue;
+		}
+
+		if(lEntry.eachStep)
+		{
+			lRecurring.push_back(lEntry);
+		}else if(lEntry.period > 0.)
+		{
+			lEntry.time += lEntry.period * (floor((pTime - lEntry.time) / lEntry.period) + 1.);
+			lRecurring.push_back(lEntry);
+		}else
+		{
+			pending.erase(lEntry.id);
+		}
+	}
+
+	// pushed back once all are run. They keep their sequence, so ties stay in scheduling order
+	vector<Entry>::const_iterator itEntry;
+	for(itEntry = lRecurring.begin(); itEntry != lRecurring.end(); ++itEntry)
+	{
+		pushEntry(*itEntry);
+	}
+	return lSucceed;
+}
@@ -80,24 +80,21 @@ int MASPlatform::startSimulation()
 		return 2;
 	}
 
-	// if we can start the simulation
-	set<Agent*> agentsFromLayer = layerToSimulate->getUniqueAgentsAndSubAgents();
-	cout << " number of agent to simulate : " << agentsFromLayer.size() << endl;
-	
-	// check as some agent to simulate
-	if(agentsFromLayer.size() < 1 )
+	// the agent set is gathered once, by the initialisation
+	if(!initAgentToSimulate())
 	{
-		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, "can't launch simulation, no participant", "MASPlatform");
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, "can't launch simulation, erreur on adding agent to simulate. NULL agent", "MASPlatform");
 		return 3;
 	}
 
-	if(!initAgentToSimulate())
+	// check as some agent to simulate
+	unsigned int lNbAgents = SimulationManager::getInstance()->getNbAgent();
+	if(lNbAgents < 1 )
 	{
-		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, "can't launch simulation, erreur on adding agent to simulate. NULL agent", "MASPlatform");
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, "can't launch simulation, no participant", "MASPlatform");
 		return 3;
 	}
-	agentsFromLayer = layerToSimulate->getUniqueAgentsAndSubAgents();
-	std::cout << " number of agent to simulate : " << agentsFromLayer.size() << std::endl;
+	cout << " number of agent to simulate : " << lNbAgents << endl;
 	// then run the simulation
 	SimulationManager::getInstance()->run();
 	return 0;
@@ -126,6 +123,17 @@ int MASPlatform::addParticipant(Agent* pAgent)
 	return (SimulationManager::getInstance()->addAgent(pAgent) == 0);
 }
 
+/////////////////////////////////////////////////////////////////////////////////
+/// \param pAgent The agent to remove from the simulation
+/// \return error code {return 0 if succes, 1 if the agent isn't simulated}
+/// \warning must be called between two steps
+/////////////////////////////////////////////////////////////////////////////////
+int MASPlatform::removeParticipant(Agent* pAgent)
+{
+	assert(pAgent);
+	return SimulationManager::getInstance()->removeAgent(pAgent);
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 /// Must be defined p, order to connect it with the viewer.
 /// \param pUpdater the updater to called for view update
@@ -162,6 +170,50 @@ void MASPlatform::setStepDuration(double pStepDuration)
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////////
+/// \brief adapt the step duration to the strongest force of the previous step.
+/// The agent displacement is then scaled by step duration / the duration set by setStepDuration,
+/// which is also the duration of the first step.
+/// \param pMinStep The minimal step duration ( in s)
+/// \param pMaxStep The maximal step duration ( in s)
+/// \param pSafetyFactor The part of the displacement threshold the fastest agent can travel during a step
+/// \param pMaxGrowth The maximal ratio between two consecutive step durations
+/////////////////////////////////////////////////////////////////////////////////
+void MASPlatform::setAdaptiveStepDuration(double pMinStep, double pMaxStep, double pSafetyFactor, double pMaxGrowth)
+{
+	assert(pMinStep > 0. && pMinStep <= pMaxStep);
+	assert(pSafetyFactor > 0.);
+	assert(pMaxGrowth >= 1.);
+	if(pMinStep > 0. && pMinStep <= pMaxStep && pSafetyFactor > 0. && pMaxGrowth >= 1.)
+	{
+		Scheduler::getInstance()->setAdaptiveStep(pMinStep, pMaxStep, pSafetyFactor, pMaxGrowth);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// \brief go back to steps of the duration set by setStepDuration
+/////////////////////////////////////////////////////////////////////////////////
+void MASPlatform::unsetAdaptiveStepDuration()
+{
+	Scheduler::getInstance()->unsetAdaptiveStep();
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// \param pRule The rule stopping the simulation once the agents are no longer evolving
+/////////////////////////////////////////////////////////////////////////////////
+void MASPlatform::setStoppingRule(const StoppingRule& pRule)
+{
+	SimulationManager::getInstance()->setStoppingRule(pRule);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// \return The mean and max displacement, elastic energy and overlap volume of the last step
+/////////////////////////////////////////////////////////////////////////////////
+const StepMetrics& MASPlatform::getLastStepMetrics() const
+{
+	return SimulationManager::getInstance()->getLastStepMetrics();
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 /// \param pNbThread duration of a step ( in s)
 /////////////////////////////////////////////////////////////////////////////////
@@ -236,3 +288,24 @@ void MASPlatform::unlimiteNbAgentToSimulate(bool b)
 {
 	SimulationManager::getInstance()->unlimiteNbAgentToSimulate(b);
 }
+
+/////////////////////////////////////////////////////////////////////////////////
+/// \param b If true the dynamic agents write their position and displacement
+/// in contiguous arrays. The step metrics loop over those arrays and the elastic
+/// forces read the neighbour positions from them. The forces are still
+/// accumulated on each agent object
+/////////////////////////////////////////////////////////////////////////////////
+void MASPlatform::useAgentStateStore(bool b)
+{
+	SimulationManager::getInstance()->useAgentStateStore(b);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+/// \param pSkin The distance added to the cutoff of the forces neighbour lists. The lists
+/// are rebuilt once the agents may have moved of half the skin. If not positive, or for
+/// the forces without cutoff, the lists are rebuilt on every SDS update
+/////////////////////////////////////////////////////////////////////////////////
+void MASPlatform::setNeighbourListSkin(double pSkin)
+{
+	SimulationManager::getInstance()->setNeighbourListSkin(pSkin);
+}
@@ -0,0 +1,76 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "ParallelChunks.hh"
+
+#include <algorithm>
+
+#include <QThread>
+
+/// \brief the number of chunks each thread should take on average in guided mode, more means a better balance
+static const std::size_t chunksPerWorker = 8;
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pNbItems The number of items to process
+/// \param pChunkSize The number of items of a chunk, the maximal one in guided mode
+/// \param pNbGuidedWorkers The number of threads taking chunks from the queue, 0 for fixed size chunks
+//////////////////////////////////////////////////////////////////////////////
+ChunkQueue::ChunkQueue(std::size_t pNbItems, std::size_t pChunkSize, unsigned int pNbGuidedWorkers):
+	nbItems(pNbItems),
+	chunkSize(std::max<std::size_t>(1, pChunkSize)),
+	nbGuidedWorkers(pNbGuidedWorkers),
+	next(0)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pBegin index of the first item of the chunk
+/// \param pEnd index after the last item of the chunk
+/// \return true if a chunk has been given
+//////////////////////////////////////////////////////////////////////////////
+bool ChunkQueue::takeChunk(std::size_t& pBegin, std::size_t& pEnd)
+{
+	std::size_t current = next.load(std::memory_order_relaxed);
+	std::size_t chunk;
+	do
+	{
+		if(current >= nbItems)
+		{
+			return false;
+		}
+		chunk = chunkSize;
+		if(nbGuidedWorkers > 0)
+		{
+			std::size_t remaining = nbItems - current;
+			chunk = std::min(chunkSize, std::max<std::size_t>(1, remaining / (chunksPerWorker * nbGuidedWorkers)));
+		}
+	}while(!next.compare_exchange_weak(current, current + chunk, std::memory_order_relaxed));
+
+	pBegin = current;
+	pEnd = std::min(current + chunk, nbItems);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pNbItems The number of items to process
+/// \param pMinItemsPerThread The minimal number of items for a thread to be worth creating
+/// \param pMaxThreads The maximal number of threads, 0 for the hardware one
+/// \return the number of threads to use, the calling one included
+//////////////////////////////////////////////////////////////////////////////
+unsigned int getNbThreadsFor(std::size_t pNbItems, std::size_t pMinItemsPerThread, unsigned int pMaxThreads)
+{
+	std::size_t lNbThreads = pMaxThreads;
+	if(lNbThreads == 0)
+	{
+		int lHardwareThreads = QThread::idealThreadCount();
+		lNbThreads = (lHardwareThreads > 0) ? static_cast<std::size_t>(lHardwareThreads) : 1;
+	}
+	lNbThreads = std::min(lNbThreads, pNbItems / std::max<std::size_t>(1, pMinItemsPerThread));
+	return static_cast<unsigned int>(std::max<std::size_t>(1, lNbThreads));
+}
@@ -10,6 +10,7 @@ See LICENSE.md for further details
 
 static RandomEngineManager* randomEngine = 0;
 
+#include <algorithm>
 #include <limits> 
 #include <QString>
 
@@ -20,6 +21,7 @@ static QString fileOutName = "randomOutput";
 /////////////////////////////////////////////////////////////////////
 RandomEngineManager::RandomEngineManager():
 	rndEngine(NULL),
+	streamSeed(0),
 	outputRandom(NULL)
 {
 
@@ -52,6 +54,7 @@ void RandomEngineManager::setEngine(CLHEP::HepRandomEngine* pEngine)
 {
 	assert(pEngine);
 	rndEngine = pEngine;
+	streamSeed = static_cast<uint64_t>(pEngine->getSeed());
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -98,3 +101,88 @@ double RandomEngineManager::normaled(double min, double max, double medium, doub
 {
 	return -1.;
 }
+
+/////////////////////////////////////////////////////////////////////
+/// \param pSeed The key of the stream
+/// \param pStreamID The ID of the stream (agent ID...)
+/// \param pStep The simulation step
+/////////////////////////////////////////////////////////////////////
+RandomStream::RandomStream(uint64_t pSeed, uint64_t pStreamID, uint32_t pStep):
+	nbUsed(4)
+{
+	key[0] = static_cast<uint32_t>(pSeed);
+	key[1] = static_cast<uint32_t>(pSeed >> 32);
+	counter[0] = 0;
+	counter[1] = pStep;
+	counter[2] = static_cast<uint32_t>(pStreamID);
+	counter[3] = static_cast<uint32_t>(pStreamID >> 32);
+}
+
+/////////////////////////////////////////////////////////////////////
+/// \details ten rounds of Philox4x32 (Salmon et al., "Parallel random
+/// numbers: as easy as 1, 2, 3", SC11)
+/////////////////////////////////////////////////////////////////////
+void RandomStream::philox(const uint32_t pKey[2], const uint32_t pCounter[4], uint32_t pBlock[4])
+{
+	const uint32_t M0 = 0xD2511F53;
+	const uint32_t M1 = 0xCD9E8D57;
+	const uint32_t W0 = 0x9E3779B9;
+	const uint32_t W1 = 0xBB67AE85;
+
+	uint32_t k0 = pKey[0];
+	uint32_t k1 = pKey[1];
+	uint32_t c0 = pCounter[0], c1 = pCounter[1], c2 = pCounter[2], c3 = pCounter[3];
+	for(int iRound = 0; iRound < 10; ++iRound)
+	{
+		uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+		uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+		uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+		uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+		c1 = static_cast<uint32_t>(p1);
+		c3 = static_cast<uint32_t>(p0);
+		c0 = n0;
+		c2 = n2;
+		k0 += W0;
+		k1 += W1;
+	}
+	pBlock[0] = c0;
+	pBlock[1] = c1;
+	pBlock[2] = c2;
+	pBlock[3] = c3;
+}
+
+/////////////////////////////////////////////////////////////////////
+/// \return a double with 53 random bits, from two words of the block
+/////////////////////////////////////////////////////////////////////
+double RandomStream::randd()
+{
+	if(nbUsed >= 4)
+	{
+		philox(key, counter, block);
+		counter[0]++;
+		nbUsed = 0;
+	}
+	uint64_t lBits = (static_cast<uint64_t>(block[nbUsed]) << 32) | block[nbUsed + 1];
+	nbUsed += 2;
+	return static_cast<double>(lBits >> 11) * (1. / 9007199254740992.);	// 2^-53
+}
+
+/////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////
+double RandomStream::randd(double min, double max)
+{
+	if(min == max)	return min;
+	return randd() * ( max - min ) + min;
+}
+
+/////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////
+int RandomStream::randi(int min, int max)
+{
+	if(min == max)  return min;
+	if(min > max)   return randi(max, min);
+	int lValue = min + static_cast<int>(randd() * (static_cast<double>(max) - min + 1.));
+	return std::min(lValue, max);
+}
@@ -8,6 +8,7 @@ See LICENSE.md for further details
 ----------------------*/
 #include "Scheduler.hh"
 #include "InformationSystemManager.hh"
+#include "SimulationManager.hh"
 
 static Scheduler* scheduler = 0;
 
@@ -19,8 +20,21 @@ static Scheduler* scheduler = 0;
 	#define DEBUG_SCHEDULER 0 	// must always stay to 0
 #endif
 
+#include <algorithm>
 #include <iostream>
 using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \brief set pValue to pCandidate if pCandidate is greater. Thread safe
+//////////////////////////////////////////////////////////////////////////////////
+static void atomicMax(std::atomic<double>& pValue, double pCandidate)
+{
+	double lCurrent = pValue.load(std::memory_order_relaxed);
+	while(lCurrent < pCandidate && !pValue.compare_exchange_weak(lCurrent, pCandidate, std::memory_order_relaxed))
+	{
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////////
@@ -30,14 +44,18 @@ Scheduler::Scheduler()
 }
 
 //////////////////////////////////////////////////////////////////////////////////
-///
+/// \warning actions are not deleted
 //////////////////////////////////////////////////////////////////////////////////
 Scheduler::~Scheduler()
 {
-
+	if(scheduler == this)
+	{
+		scheduler = 0;
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////
+/// \details actions are scheduled by their constructor. An action scheduled twice is processed twice.
 /// \param pAction The action to schedule
 /// \return true if scheduling is a success
 //////////////////////////////////////////////////////////////////////////////////
@@ -52,10 +70,12 @@ bool Scheduler::scheduleAction(Action* pAction)
 			{
 				return false;
 			}
-		}// go throw	
+			preIterationActions.push(pAction, pAction->getActionTime(), pAction->getPeriod());
+			return true;
+		}
 		case Action::EACH_BEGIN_ITERATION:
 		{
-			preIterationActions.insert(pAction);
+			preIterationActions.pushEachStep(pAction);
 			return true;
 		}
 		case Action::PUNCTUAL_AFTER_ITERATION :
@@ -64,10 +84,12 @@ bool Scheduler::scheduleAction(Action* pAction)
 			{
 				return false;
 			}
-		}// go throw	
+			postIterationActions.push(pAction, pAction->getActionTime(), pAction->getPeriod());
+			return true;
+		}
 		case Action::EACH_END_ITERATION:
 		{
-			postIterationActions.insert(pAction);
+			postIterationActions.pushEachStep(pAction);
 			return true;
 		}
 		default:	// unknow frequency
@@ -77,60 +99,27 @@ bool Scheduler::scheduleAction(Action* pAction)
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// \details can be called by an action during its execution
+/// \param pAction The action to cancel
+/// \return true if the action was scheduled
+//////////////////////////////////////////////////////////////////////////////
+bool Scheduler::cancelAction(const Action* pAction)
+{
+	assert(pAction);
+	unsigned int lNbCancelled = preIterationActions.cancel(pAction);
+	lNbCancelled += postIterationActions.cancel(pAction);
+	return lNbCancelled > 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 /// \param postIteration True if we want to apply the post iteration if we want to apply the pre iteration this will be set as false
 /// \return true if the action proceeding ok
 //////////////////////////////////////////////////////////////////////////////
 bool Scheduler::processActions(bool postIteration)
 {
-	std::set<Action*, action_timing_comparison>::iterator actionIt;
-	// init the iterator
-	actionIt = (postIteration ? postIterationActions.begin() : preIterationActions.begin());
-	bool lContinue = true;
-
-	//  his execution time is good
-	while( lContinue)
-	{
-		// if no more action to run
-		if(actionIt == (postIteration ? postIterationActions.end() : preIterationActions.end()))
-		{
-			return true; 
-		}
-		// if to run at each iteration
-		if((*actionIt)->getFrequency() == (postIteration? Action::EACH_END_ITERATION : Action::EACH_BEGIN_ITERATION) )
-		{
-			// if failed to execute the action
-			if(!(*actionIt)->exec())
-			{
-				return false;
-			}
-			++actionIt;
-		}else
-		{	
-			// if a Ponctual action
-			// if the action execution time is over : execute it
-			if((*actionIt)->getActionTime()<= getRunningTime())
-			{
-				// if failed to execute the action
-				if(!(*actionIt)->exec())
-				{
-					return false;
-				}
-				// then remove this action wich is limited to one
-				(postIteration ? postIterationActions : preIterationActions).erase((*actionIt++));
-
-				// !!! DO NOT INCREMENT THE ITERATOR
-				// because we juste remove the current action and we want to check the 
-				// one just after wich took her place
-			}else
-			{
-				// we want throught all the actions we needed for this simulation time.
-				// thanks to the ordonned set of action
-				return true;
-			}
-		}	// end else Ponctual action
-	}	// end while (lContinue)
-	return true;
+	// actions at each iteration, then punctual ones whose execution time is over
+	return (postIteration ? postIterationActions : preIterationActions).process(getRunningTime());
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -145,8 +134,16 @@ Scheduler* Scheduler::getInstance()
 	return scheduler;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// \return true if the singleton of the scheduler has been created and not deleted
+//////////////////////////////////////////////////////////////////////////////
+bool Scheduler::hasInstance()
+{
+	return scheduler != 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
-/// \return {The duration of the next step}
+/// \return {The duration of the next step. 0 if the simulation is over}
 //////////////////////////////////////////////////////////////////////////////////
 double Scheduler::computeSimulationStepDuration()
 {
@@ -156,21 +153,78 @@ double Scheduler::computeSimulationStepDuration()
 		mess += "\n   - current time : " + QString::number(currentTime);
 		mess += "\n   - step duration : " + QString::number(stepDuration);
 		mess += "\n   - totalDuration : " + QString::number(totalDuration);
+		mess += "\n   - previous step max force : " + QString::number(maxForce.load());
 		InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, mess.toStdString(), "SCHEDULER");
 	}
 
+	double lStepDuration = adaptiveStep ? computeAdaptiveStepDuration() : stepDuration;
 	double lNextStepDuration = 0.;
-	if((totalDuration - currentTime)/stepDuration > 1 )
+	if((totalDuration - currentTime)/lStepDuration > 1 )
 	{
-		lNextStepDuration = stepDuration;
+		lNextStepDuration = lStepDuration;
 	}else
 	{
 		lNextStepDuration = totalDuration - currentTime;
 	}
 	currentTime += lNextStepDuration;
+	currentStepDuration = lNextStepDuration;
+	stepIndex++;
+
+	// agents will report their force during the step
+	maxForce = 0.;
 	return lNextStepDuration;
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+/// \details The agents move of force * step / stepDuration, so the step is limited
+/// as in a CFL condition : the agent under the strongest force of the previous step
+/// should not travel more than safetyFactor * the displacement threshold.
+/// The step can grow of maxGrowth at most between two steps and stays in
+/// [minStepDuration, maxStepDuration].
+/// \return {The duration of the next step before the total duration truncation}
+//////////////////////////////////////////////////////////////////////////////////
+double Scheduler::computeAdaptiveStepDuration() const
+{
+	double lStepDuration = stepDuration;
+	// no motion known before the first step
+	if(currentStepDuration > 0.)
+	{
+		lStepDuration = currentStepDuration * maxGrowth;
+		double lThreshold = SimulationManager::getInstance()->getDisplacementThreshold();
+		if(lThreshold > 0. && maxForce > 0.)
+		{
+			lStepDuration = std::min(lStepDuration, safetyFactor * lThreshold * stepDuration / maxForce);
+		}
+	}
+	return std::max(minStepDuration, std::min(maxStepDuration, lStepDuration));
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \param pForce The norm of the force acting on the agent
+//////////////////////////////////////////////////////////////////////////////////
+void Scheduler::reportAgentForce(double pForce)
+{
+	atomicMax(maxForce, pForce);
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \param pMinStep The minimal step duration, in s
+/// \param pMaxStep The maximal step duration, in s
+/// \param pSafetyFactor The part of the displacement threshold the fastest agent can travel during a step
+/// \param pMaxGrowth The maximal ratio between two consecutive step durations
+//////////////////////////////////////////////////////////////////////////////////
+void Scheduler::setAdaptiveStep(double pMinStep, double pMaxStep, double pSafetyFactor, double pMaxGrowth)
+{
+	assert(pMinStep > 0. && pMinStep <= pMaxStep);
+	assert(pSafetyFactor > 0.);
+	assert(pMaxGrowth >= 1.);
+	adaptiveStep = true;
+	minStepDuration = pMinStep;
+	maxStepDuration = pMaxStep;
+	safetyFactor = pSafetyFactor;
+	maxGrowth = pMaxGrowth;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 /// 
 //////////////////////////////////////////////////////////////////////////////////
@@ -183,6 +237,16 @@ void Scheduler::reset()
 	stepDuration = 0.;
 	currentTime = 0.;
 	totalDuration = 0.;
+	currentStepDuration = 0.;
+	stepIndex = 0;
+
+	adaptiveStep = false;
+	minStepDuration = 0.;
+	maxStepDuration = 0.;
+	safetyFactor = 0.5;
+	maxGrowth = 2.;
+
+	maxForce = 0.;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -195,4 +259,7 @@ void Scheduler::init()
 		InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, "Scheduler initalisation", "SCHEDULER");
 	}
 	currentTime = 0.;
+	currentStepDuration = 0.;
+	stepIndex = 0;
+	maxForce = 0.;
 }
\ No newline at end of file
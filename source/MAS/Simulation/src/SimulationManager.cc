@@ -14,6 +14,7 @@ See LICENSE.md for further details
 #include "SpatialDataStructureManager.hh"
 #include "SpatialConflictSolver.hh"
 #include "EngineSettings.hh"
+#include <algorithm>
 #include <limits>
 
 static SimulationManager* simulationManager = 0;
@@ -33,7 +34,17 @@ SimulationManager::SimulationManager() :
 	maxThreadAgentGroup(INITIAL_MAX_THREAD),
 	nextThreadID(0),
 	displacementThreshold(-1.),
-	numberOfAgentToExecute(1)
+	bExecuteAllAgent(true),
+	numberOfAgentToExecute(1),
+	bExecutedAllLastStep(false),
+	bPickableAgentsDirty(false),
+	bAgentTagsDirty(true),
+	bUseStateStore(false),
+	bStateStoresDirty(false),
+	neighbourListEpoch(1),
+	neighbourListSkin(-1.),
+	skinListEpoch(1),
+	displacementSinceEpoch(0.)
 {
 
 #ifdef SIMULATION_VALID_AGENT_NEW_POS	
@@ -95,8 +106,15 @@ void SimulationManager::reset()
 		itThread->second->reset();
 	}
 	// reset agents
+	clearStateStores();
 	agentHandler.clear();
 	managedAgents.clear();
+	pickableAgents.clear();
+	agentExecutedLastStep.clear();
+	bExecutedAllLastStep = false;
+	bPickableAgentsDirty = false;
+	bAgentTagsDirty = true;
+	invalidateNeighbourLists();
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -108,8 +126,18 @@ int SimulationManager::init()
 	InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, "Init", "SimlationManager");
 	// ini scheduler
 	Scheduler::getInstance()->init();
+	// forget the metrics of the previous run
+	stoppingRule.reset();
+	lastStepMetrics.reset();
+	// register dynamic agents on the contiguous stores
+	if(bUseStateStore)
+	{
+		buildStateStores();
+	}
 	// update SDS if some agent change of position from the SDS creation
 	updateSDS();
+	// agents may have been moved out of the simulation since the lists have been built
+	invalidateNeighbourLists();
 
 	return 0;
 }
@@ -143,8 +171,14 @@ int SimulationManager::addAgent(Agent* pAgent)
 		if(thread->addAgent(pAgent)==0)
 		{
 			// register the tuple agent / Thread group
-			agentHandler.insert(pair<Agent*, ThreadAgentGroup*> ( pAgent, thread));
+			AgentHandle lHandle = {thread, managedAgents.size()};
+			agentHandler.insert(pair<Agent*, AgentHandle> ( pAgent, lHandle));
 			managedAgents.push_back(pAgent);
+			pickableAgents.push_back(pAgent);
+			// neighbour lists may miss the new agent, which is also to tag and to store
+			invalidateNeighbourLists();
+			bAgentTagsDirty = true;
+			bStateStoresDirty = true;
 			return 0;			
 		}else
 		{
@@ -158,6 +192,40 @@ int SimulationManager::addAgent(Agent* pAgent)
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+/// \details the last agent takes the place of the removed one. Agents are only
+/// read again on the next step, so they can be deleted once removed.
+/// \warning must not be called while agents are executed
+/// \param pAgent The agent to remove from the simulation
+/// \return 0 if succes, 1 if the agent isn't registred
+//////////////////////////////////////////////////////////////////////////////////
+int SimulationManager::removeAgent(Agent* pAgent)
+{
+	map<Agent*, AgentHandle>::iterator itHandle = agentHandler.find(pAgent);
+	if(itHandle == agentHandler.end())
+	{
+		return 1;
+	}
+
+	itHandle->second.thread->removeAgent(pAgent);
+	size_t lIndex = itHandle->second.index;
+	managedAgents[lIndex] = managedAgents.back();
+	agentHandler[managedAgents[lIndex]].index = lIndex;
+	managedAgents.pop_back();
+	agentHandler.erase(itHandle);
+
+	// unbind the stores while the agent exists, they are rebuilt on the next step
+	if(bUseStateStore)
+	{
+		clearStateStores();
+		bStateStoresDirty = true;
+	}
+	invalidateNeighbourLists();
+	bPickableAgentsDirty = true;
+	bAgentTagsDirty = true;
+	return 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 /// \param <pLayer> {The layer to set and from which we update SDS}
 //////////////////////////////////////////////////////////////////////////////////
@@ -172,12 +240,10 @@ void SimulationManager::setTopLayer(Layer* pLayer)
 //////////////////////////////////////////////////////////////////////////////////
 bool SimulationManager::solveConflicts()
 {
-	vector<Agent*> agents = getAllAgents();
-
 	vector<ConflictSolver*>::const_iterator itCS;
 	for(itCS = conflictSolvers.begin(); itCS != conflictSolvers.end(); ++itCS)
 	{
-		if(!(*itCS)->solveConflict(agents))
+		if(!(*itCS)->solveConflict(managedAgents))
 		{
 			return false;
 		}
@@ -186,45 +252,175 @@ bool SimulationManager::solveConflicts()
 }
 
 //////////////////////////////////////////////////////////////////////////////////
+/// \details also compute the metrics of the step. Elastic energy and overlap volume
+/// are only computed when the stopping rule needs them, and extrapolated to all agents
+/// when only some of them have been executed.
 /// \return {True if sucess}
 //////////////////////////////////////////////////////////////////////////////////
 bool SimulationManager::updateAgentState()
 {
+	bool lWithInteractions = stoppingRule.needsInteractionMetrics();
+	lastStepMetrics.reset();
 
-#ifdef SIMULATION_VALID_AGENT_NEW_POS	
-	/// update position of the agent executed.
-	set<Agent*>::iterator itAgent;
-	for(itAgent = agentExecutedLastStep.begin(); itAgent != agentExecutedLastStep.end(); ++itAgent)
+	/// update the agent executed and their metrics
+	if(bUseStateStore)
 	{
-		// try 2D cast
+		updateStoredAgentState(stateStore_2, lWithInteractions);
+		updateStoredAgentState(stateStore_3, lWithInteractions);
+	}else
+	{
+		const vector<Agent*>& lAgentsExecuted = getAgentsExecutedLastStep();
+		vector<Agent*>::const_iterator itAgent;
+		for(itAgent = lAgentsExecuted.begin(); itAgent != lAgentsExecuted.end(); ++itAgent)
 		{
-			t_DynamicAgent_2* dymAgent = dynamic_cast<t_DynamicAgent_2*>(*itAgent);
-			if(dymAgent)
+			// try 2D cast then 3D cast
+			if(!updateDynamicAgentState<double, Point_2, Vector_2>(*itAgent, lWithInteractions))
 			{
-				dymAgent->validRequiredPos();
+				updateDynamicAgentState<double, Point_3, Vector_3>(*itAgent, lWithInteractions);
 			}
 		}
+	}
 
-		// try 3D cast
+	if(lastStepMetrics.nbAgents > 0)
+	{
+		lastStepMetrics.meanDisplacement /= lastStepMetrics.nbAgents;
+		if(lWithInteractions)
 		{
-			t_DynamicAgent_3* dymAgent = dynamic_cast<t_DynamicAgent_3*>(*itAgent);
-			if(dymAgent)
-			{
-				dymAgent->validRequiredPos();
-			}
-		}		
+			double lSampleRatio = (double)getNbAgent() / (double)lastStepMetrics.nbAgents;
+			lastStepMetrics.elasticEnergy *= lSampleRatio;
+			lastStepMetrics.overlapVolume *= lSampleRatio;
+		}
+	}
+	lastStepMetrics.hasInteractionMetrics = lWithInteractions;
+
+	if(DEBUG_SIMULATION_MANAGER)
+	{
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, lastStepMetrics.toString().toStdString(), "SimulationManager");
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \param pAgent The agent executed
+/// \param pWithInteractions True if we want the potential energy and overlap volume of the agent
+/// \return {True if the agent is a dynamic agent of this kind}
+//////////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+bool SimulationManager::updateDynamicAgentState(Agent* pAgent, bool pWithInteractions)
+{
+	DynamicAgent<Kernel, Point, Vector>* dymAgent = dynamic_cast<DynamicAgent<Kernel, Point, Vector>*>(pAgent);
+	if(!dymAgent)
+	{
+		return false;
+	}
+
+#ifdef SIMULATION_VALID_AGENT_NEW_POS	
+	/// update position of the agent executed.
+	if(dymAgent->isRequiringNewPos())
+	{
+		dymAgent->validRequiredPos();
 	}
 #endif
 
+	double lDisplacement = dymAgent->getLastDisplacement();
+	lastStepMetrics.nbAgents++;
+	lastStepMetrics.meanDisplacement += lDisplacement;
+	lastStepMetrics.maxDisplacement = std::max(lastStepMetrics.maxDisplacement, lDisplacement);
+	if(pWithInteractions)
+	{
+		lastStepMetrics.elasticEnergy += dymAgent->getPotentialEnergy();
+		lastStepMetrics.overlapVolume += dymAgent->getOverlapVolume();
+	}
 	return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////////
+/// \param pStore The store of the agents to update
+/// \param pWithInteractions True if we want the potential energy and overlap volume of the agents
+//////////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+void SimulationManager::updateStoredAgentState(AgentStateStore<Kernel, Point, Vector>& pStore, bool pWithInteractions)
+{
+#ifdef SIMULATION_VALID_AGENT_NEW_POS	
+	/// update position of the agent executed.
+	pStore.validRequestedPositions();
+#endif
+
+	const std::vector<Kernel>& lDisplacements = pStore.getDisplacements();
+	for(size_t iAgent = 0; iAgent < pStore.size(); ++iAgent)
+	{
+		if(!pStore.isExecuted(iAgent))
+		{
+			continue;
+		}
+		lastStepMetrics.nbAgents++;
+		lastStepMetrics.meanDisplacement += lDisplacements[iAgent];
+		lastStepMetrics.maxDisplacement = std::max(lastStepMetrics.maxDisplacement, (double)lDisplacements[iAgent]);
+		if(pWithInteractions)
+		{
+			lastStepMetrics.elasticEnergy += pStore.getAgent(iAgent)->getPotentialEnergy();
+			lastStepMetrics.overlapVolume += pStore.getAgent(iAgent)->getOverlapVolume();
+		}
+	}
+	pStore.clearExecuted();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \details dynamic agents are cast once per run instead of once per step
+//////////////////////////////////////////////////////////////////////////////////
+void SimulationManager::buildStateStores()
+{
+	clearStateStores();
+	vector<Agent*>::const_iterator itAgent;
+	for(itAgent = managedAgents.begin(); itAgent != managedAgents.end(); ++itAgent)
+	{
+		DynamicAgent<double, Point_2, Vector_2>* dymAgent_2 = dynamic_cast<DynamicAgent<double, Point_2, Vector_2>*>(*itAgent);
+		if(dymAgent_2)
+		{
+			stateStore_2.addAgent(dymAgent_2);
+			continue;
+		}
+		DynamicAgent<double, Point_3, Vector_3>* dymAgent_3 = dynamic_cast<DynamicAgent<double, Point_3, Vector_3>*>(*itAgent);
+		if(dymAgent_3)
+		{
+			stateStore_3.addAgent(dymAgent_3);
+		}
+	}
+	bStateStoresDirty = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////
+void SimulationManager::clearStateStores()
+{
+	stateStore_2.clear();
+	stateStore_3.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+/// \details the lists with a skin are also rebuilt, whatever the agents displacement
+//////////////////////////////////////////////////////////////////////////////////
+void SimulationManager::invalidateNeighbourLists()
+{
+	neighbourListEpoch++;
+	skinListEpoch = neighbourListEpoch;
+	displacementSinceEpoch = 0.;
+}
+
 //////////////////////////////////////////////////////////////////////////////////
 /// \brief the run of the simulation
 //////////////////////////////////////////////////////////////////////////////////
 void SimulationManager::run()
 {
 	init();
+
+	// agents must be unbound from the state stores while they exist, whatever the way the run ends
+	struct StateStoresRelease
+	{
+		SimulationManager* manager;
+		~StateStoresRelease()		{ manager->clearStateStores();};
+	} lStateStoresRelease = {this};
 	
 	/// signal the begining of the simulation
 	InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, "StartRun", "SimlationManager");
@@ -251,6 +447,12 @@ void SimulationManager::run()
 			return;
 		}
 
+		/// - register the agents added or removed since the last step
+		if(bUseStateStore && bStateStoresDirty)
+		{
+			buildStateStores();
+		}
+
 		/// - if running the next step failed
 		if(!runOneStep())
 		{
@@ -275,6 +477,14 @@ void SimulationManager::run()
 		}
 		// 	- signal we runned a step
 		emit si_stepRunned();
+
+		/// - stop if agents are no longer evolving
+		if(stoppingRule.update(lastStepMetrics))
+		{
+			QString mess = "Simulation converged at time " + QString::number(Scheduler::getInstance()->getRunningTime()) + " s : " + lastStepMetrics.toString();
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::INFORMATION_MES, mess.toStdString(), "SimulationManager");
+			simulationOver = true;
+		}
 	}
 
 	/// stop thread agent group
@@ -288,25 +498,28 @@ void SimulationManager::run()
 }
 
 //////////////////////////////////////////////////////////////////////////////////
+/// \details partial Fisher-Yates on pickableAgents : O(nbAgent) whatever the
+/// number of agents managed
 /// \param <nbAgent> {The number of agent to pick}
-/// \return {The randomly picked agent}
+/// \param <pPicked> {The randomly picked agent. Its capacity is reused}
 //////////////////////////////////////////////////////////////////////////////////
-set<Agent*> SimulationManager::pickRandomlyAgts(unsigned int nbAgent)
+void SimulationManager::pickRandomlyAgts(unsigned int nbAgent, vector<Agent*>& pPicked)
 {
 	if(nbAgent >= getNbAgent())
 	{
-		return set<Agent*>(managedAgents.begin(), managedAgents.end());
+		pPicked = managedAgents;
+		return;
 	}
 
 	assert( getNbAgent() > nbAgent);
-	set<Agent*> agentsPicked;
-	while(agentsPicked.size() < nbAgent)
+	if(bPickableAgentsDirty)
 	{
-		Agent* pickAgt = RandomEngineManager::getInstance()->pickRandom(&managedAgents);
-		assert(pickAgt);
-		agentsPicked.insert( pickAgt );
+		pickableAgents = managedAgents;
+		bPickableAgentsDirty = false;
 	}
-	return agentsPicked;
+	assert( pickableAgents.size() == managedAgents.size());
+	RandomEngineManager::getInstance()->pickRandomFirst(pickableAgents, nbAgent);
+	pPicked.assign(pickableAgents.begin(), pickableAgents.begin() + nbAgent);
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -315,6 +528,16 @@ set<Agent*> SimulationManager::pickRandomlyAgts(unsigned int nbAgent)
 void SimulationManager::updateSDS()
 {
 	SpatialDataStructureManager::getInstance()->update();
+	// the neighbours given by the SDS may have changed
+	neighbourListEpoch++;
+	// Verlet criterion : the sum of the maximal displacements of each step bounds the distance
+	// travelled by any agent. Once it exceeds half the skin two agents may have come closer of the skin
+	displacementSinceEpoch += lastStepMetrics.maxDisplacement;
+	if(neighbourListSkin <= 0. || displacementSinceEpoch > 0.5 * neighbourListSkin)
+	{
+		skinListEpoch = neighbourListEpoch;
+		displacementSinceEpoch = 0.;
+	}
 	/// \todo : check why doesn't work. In many case we should update SDS for some agent and not for all as we do actually
 	// if( bExecuteAllAgent )
 	// {
@@ -403,33 +626,57 @@ bool SimulationManager::runOneStepWithThread()
 
 //////////////////////////////////////////////////////////////////////////////////
 /// \details will tag agent to execute, if tagged to true : will be executed next 
-/// round else will not be.
+/// round else will not be. Tags are only updated for the agents which change of
+/// state, so steps executing all agents don't go through them.
 //////////////////////////////////////////////////////////////////////////////////
 void SimulationManager::updateAgentToExecute()
 {
-	// get the agent to execute
-	if(bExecuteAllAgent || getNbAgent() > numberOfAgentToExecute )
+	bool lExecuteAll = bExecuteAllAgent || getNbAgent() <= numberOfAgentToExecute;
+
+	// reset agent execution : only the agents tagged by the last step, unless agents changed
+	if(bAgentTagsDirty || (bExecutedAllLastStep && !lExecuteAll))
 	{
-		agentExecutedLastStep.clear();
-		agentExecutedLastStep.insert(managedAgents.begin(), managedAgents.end());
-	}else
+		vector<Agent*>::iterator itAgentReset;
+		for(itAgentReset = managedAgents.begin(); itAgentReset != managedAgents.end(); ++itAgentReset )
+		{
+			(*itAgentReset)->setToBeExecute(false);
+		}
+		bExecutedAllLastStep = false;
+	}else if(!bExecutedAllLastStep)
 	{
-		agentExecutedLastStep = pickRandomlyAgts(numberOfAgentToExecute);
+		vector<Agent*>::iterator itAgentReset;
+		for(itAgentReset = agentExecutedLastStep.begin(); itAgentReset != agentExecutedLastStep.end(); ++itAgentReset )
+		{
+			(*itAgentReset)->setToBeExecute(false);
+		}
 	}
+	bAgentTagsDirty = false;
 
-	// reset agent execution
-	vector<Agent*>::iterator itAgentReset;
-	for(itAgentReset = managedAgents.begin(); itAgentReset != managedAgents.end(); ++itAgentReset )
+	// get the agent to execute and tag them
+	if(lExecuteAll)
 	{
-		(*itAgentReset)->setToBeExecute(false);
-	}
-
-	// then tag them
-	set<Agent*>::iterator itAgentSet;
-	for(itAgentSet = agentExecutedLastStep.begin(); itAgentSet != agentExecutedLastStep.end(); ++itAgentSet)
+		// all agents are still tagged if they all have been executed last step
+		if(!bExecutedAllLastStep)
+		{
+			vector<Agent*>::iterator itAgentSet;
+			for(itAgentSet = managedAgents.begin(); itAgentSet != managedAgents.end(); ++itAgentSet)
+			{
+				assert(*itAgentSet);
+				(*itAgentSet)->setToBeExecute(true);
+			}
+		}
+		agentExecutedLastStep.clear();
+		bExecutedAllLastStep = true;
+	}else
 	{
-		assert(*itAgentSet);
-		(*itAgentSet)->setToBeExecute(true);
+		pickRandomlyAgts(numberOfAgentToExecute, agentExecutedLastStep);
+		vector<Agent*>::iterator itAgentSet;
+		for(itAgentSet = agentExecutedLastStep.begin(); itAgentSet != agentExecutedLastStep.end(); ++itAgentSet)
+		{
+			assert(*itAgentSet);
+			(*itAgentSet)->setToBeExecute(true);
+		}
+		bExecutedAllLastStep = false;
 	}
 }
 
@@ -513,11 +760,3 @@ void SimulationManager::removeConflictSolver(ConflictSolver* pConflictSolver)
 		}
 	}
 }
-
-//////////////////////////////////////////////////////////////////////////////////
-/// \return Return all the agents currently registred
-//////////////////////////////////////////////////////////////////////////////////
-vector<Agent*> SimulationManager::getAllAgents()
-{
-	return managedAgents;
-}
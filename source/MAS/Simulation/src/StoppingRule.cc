@@ -0,0 +1,131 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "StoppingRule.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pPrevious The previous value
+/// \param pCurrent The current value
+/// \return the relative change between the two values
+//////////////////////////////////////////////////////////////////////////////
+static double relativeChange(double pPrevious, double pCurrent)
+{
+	double lScale = std::max(std::fabs(pPrevious), std::numeric_limits<double>::min());
+	return std::fabs(pCurrent - pPrevious) / lScale;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void StepMetrics::reset()
+{
+	nbAgents = 0;
+	meanDisplacement = 0.;
+	maxDisplacement = 0.;
+	elasticEnergy = 0.;
+	overlapVolume = 0.;
+	hasInteractionMetrics = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \return the metrics on one line
+//////////////////////////////////////////////////////////////////////////////
+QString StepMetrics::toString() const
+{
+	QString lDescription = "agents : " + QString::number(nbAgents);
+	lDescription += ", mean displacement : " + QString::number(meanDisplacement);
+	lDescription += ", max displacement : " + QString::number(maxDisplacement);
+	if(hasInteractionMetrics)
+	{
+		lDescription += ", elastic energy : " + QString::number(elasticEnergy);
+		lDescription += ", overlap volume : " + QString::number(overlapVolume);
+	}
+	return lDescription;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+StoppingRule::StoppingRule():
+	maxDisplacement(-1.),
+	meanDisplacement(-1.),
+	energyChange(-1.),
+	overlapChange(-1.),
+	nbSteps(1)
+{
+	reset();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \return true if the rule can stop a simulation
+//////////////////////////////////////////////////////////////////////////////
+bool StoppingRule::isEnabled() const
+{
+	return maxDisplacement >= 0. || meanDisplacement >= 0. || needsInteractionMetrics();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void StoppingRule::reset()
+{
+	nbConvergedSteps = 0;
+	hasPreviousMetrics = false;
+	previousMetrics.reset();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pMetrics The metrics of the step just run
+/// \return true if the step fulfill all the criteria enabled
+//////////////////////////////////////////////////////////////////////////////
+bool StoppingRule::isConverged(const StepMetrics& pMetrics) const
+{
+	if(maxDisplacement >= 0. && pMetrics.maxDisplacement > maxDisplacement)
+	{
+		return false;
+	}
+	if(meanDisplacement >= 0. && pMetrics.meanDisplacement > meanDisplacement)
+	{
+		return false;
+	}
+	// relative changes need the previous step
+	if(needsInteractionMetrics() && (!hasPreviousMetrics || !pMetrics.hasInteractionMetrics))
+	{
+		return false;
+	}
+	if(energyChange >= 0. && relativeChange(previousMetrics.elasticEnergy, pMetrics.elasticEnergy) > energyChange)
+	{
+		return false;
+	}
+	if(overlapChange >= 0. && relativeChange(previousMetrics.overlapVolume, pMetrics.overlapVolume) > overlapChange)
+	{
+		return false;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pMetrics The metrics of the step just run
+/// \return true if the simulation converged during the last nbSteps steps
+//////////////////////////////////////////////////////////////////////////////
+bool StoppingRule::update(const StepMetrics& pMetrics)
+{
+	if(!isEnabled())
+	{
+		return false;
+	}
+
+	nbConvergedSteps = isConverged(pMetrics) ? nbConvergedSteps + 1 : 0;
+	previousMetrics = pMetrics;
+	hasPreviousMetrics = true;
+	return nbConvergedSteps >= nbSteps;
+}
@@ -59,7 +59,7 @@ public:
 	double get16squareA() const;
 
 private:
-	std::vector<Point_3> points;	///< \brief the list of vertex
+	Point_3 points[3];				///< \brief the list of vertex
 	bool reffinable;				///< \brief can we reffine this triangle.
 };
 
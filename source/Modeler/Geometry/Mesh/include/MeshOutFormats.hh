@@ -24,6 +24,7 @@ namespace MeshOutFormats
 		GDML,	
 		GEANT_4,
 		GATE,
+		PLY,	///< \brief binary Polygon File Format
 		Unknow	///< \warning Unknow foramt must always stay last
 	};
 
@@ -18,9 +18,13 @@ See LICENSE.md for further details
 
 #include "CellSettings.hh"
 #include "CellProperties.hh"
+#include "Mesh_Statistics.hh"
 #include "SpheroidalCell.hh"
+#include "SpheroidalCellMeshCache.hh"
 #include "Nucleus.hh"
 
+#include <memory>
+
 #ifdef WITH_GEANT_4
 	#include "G4LogicalVolume.hh"
 	#include "G4PVPlacement.hh"
@@ -30,6 +34,11 @@ See LICENSE.md for further details
 using namespace Settings::nCell;
 using namespace std;
 
+namespace IO
+{
+	class IndexedMesh;
+}
+
 #ifdef NDEBUG
 	#define DEFAULT_OVER_LAP = 1;
 #else
@@ -56,6 +65,25 @@ public:
 	unsigned int getNumberOfVisibleCell()	{ return Voronoi_3D_Mesh::delaunay.number_of_vertices();};
 	/// \brief generate all cell structures.
 	virtual std::vector<SpheroidalCell*> generateMesh();
+	/// \brief store and reuse the cell meshes from the given directory. pSourceKey identifies the source of the cells (population file hash)
+	void setMeshCache(QString pDirectory, uint64_t pSourceKey);
+	/// \brief disable the mesh cache
+	void disableMeshCache()					{ meshCache.reset();};
+	/// \brief export the convex cell membranes to G4 as CPOP_ConvexPolyhedron instead of G4TessellatedSolid
+	void setConvexMembraneSolid(bool pConvex)			{ convexMembraneSolid = pConvex;};
+	/// \brief return true if the convex cell membranes are exported to G4 as CPOP_ConvexPolyhedron
+	bool isConvexMembraneSolid() const					{ return convexMembraneSolid;};
+	/// \brief set the file where the mesh validation report is written before the conversion to G4. Empty to skip the validation
+	void setValidationReportFile(QString pFile)			{ validationReportFile = pFile;};
+	/// \brief return the file where the mesh validation report is written
+	QString getValidationReportFile() const				{ return validationReportFile;};
+	/// \brief set the verbosity level. 0 : silent, 1 : print the timings of the conversion to G4
+	void setVerboseLevel(int pLevel)					{ verboseLevel = pLevel;};
+	/// \brief return the verbosity level
+	int getVerboseLevel() const							{ return verboseLevel;};
+	/// \brief check the quality and the topology of the cell meshes
+	Statistics::MeshValidationReport validateMeshes(const std::vector<SpheroidalCell*>& pCells,
+		const Statistics::MeshValidationSettings& pSettings = Statistics::MeshValidationSettings()) const;
 
 #if defined(WITH_GEANT_4) || defined(WITH_GDML_EXPORT)
 	/// \brief export the configuration to a G4PVPlacement. The one returned is the "world"/top G4 entity
@@ -77,6 +105,12 @@ public:
 protected:
 	/// \brief export all cells on the same file
 	virtual int exportToFileOff_undivided(QString, std::vector<SpheroidalCell*>* );
+	/// \brief export all cells on the same binary .ply file
+	int exportToFilePly(QString, std::vector<SpheroidalCell*>* );
+	/// \brief refine the membrane meshes of the cells, return the number of failures
+	virtual unsigned long reffineCells(const std::vector<SpheroidalCell*>& pCells);
+	/// \brief add the cells (and markup points) meshes to an indexed mesh
+	void fillIndexedMesh(IO::IndexedMesh&, const std::vector<SpheroidalCell*>*) const;
 	/// \brief clean data structures
 	virtual void clean();
 
@@ -85,6 +119,11 @@ protected:
 	virtual int exportToFileGDML(QString, std::vector<SpheroidalCell*>, bool);
 #endif
 
+private:
+	std::unique_ptr<SpheroidalCellMeshCache> meshCache;		///< \brief the on-disk cache of the cell meshes. NULL if disabled
+	bool convexMembraneSolid;								///< \brief true if convex membranes are exported as CPOP_ConvexPolyhedron
+	QString validationReportFile;							///< \brief file of the mesh validation report, empty if no validation
+	int verboseLevel;										///< \brief verbosity level, 0 for silent
 };
 
 #endif // SPHEROIDAL_CELL_MESH_HH
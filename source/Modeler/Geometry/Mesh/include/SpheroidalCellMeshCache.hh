@@ -0,0 +1,54 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef SPHEROIDAL_CELL_MESH_CACHE_HH
+#define SPHEROIDAL_CELL_MESH_CACHE_HH
+
+#include "CellRefinementTarget.hh"
+#include "SpheroidalCell.hh"
+
+#include <QString>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief on-disk binary cache of the refined spheroidal cell meshes.
+/// \details one file per key, storing for each cell (identified by its agent ID)
+/// the nuclei position and radius and the membrane polyhedron (vertices and facets).
+/// The key is built from a hash of the source (the population file), the meshing
+/// parameters and the cells to mesh, so a file can't be reused for an other population.
+/// Files are written to a temporary file first then renamed so concurrent jobs never
+/// read a partial cache.
+//////////////////////////////////////////////////////////////////////////////
+class SpheroidalCellMeshCache
+{
+public:
+	/// \brief constructor
+	SpheroidalCellMeshCache(QString pDirectory, uint64_t pSourceKey);
+
+	/// \brief return the key of the mesh of the given cells with the given parameters
+	uint64_t computeKey(const std::vector<SpheroidalCell*>& pCells, unsigned int pMaxNbFacet, double pDeltaWin, double pMaxRatioNucleusToCell,
+		const CellRefinementTargets& pTargets = CellRefinementTargets()) const;
+	/// \brief set cells meshes from the cache file of the given key. Return false and leave cells untouched if no valid cache
+	bool load(const std::vector<SpheroidalCell*>& pCells, uint64_t pKey) const;
+	/// \brief write the cells meshes to the cache file of the given key
+	bool save(const std::vector<SpheroidalCell*>& pCells, uint64_t pKey) const;
+	/// \brief return the path of the cache file of the given key
+	QString getFilePath(uint64_t pKey) const;
+
+	/// \brief return the hash of the file content, 0 if the file can't be read
+	static uint64_t hashFile(const std::string& pPath);
+
+private:
+	QString directory;		///< \brief the directory containing cache files
+	uint64_t sourceKey;		///< \brief hash of the source the cells are coming from
+};
+
+#endif // SPHEROIDAL_CELL_MESH_CACHE_HH
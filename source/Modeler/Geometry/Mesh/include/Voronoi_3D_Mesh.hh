@@ -10,6 +10,7 @@ See LICENSE.md for further details
 #define VORONOI_3D_MESH_HH
 
 #include "AgentSettings.hh"
+#include "CellRefinementTarget.hh"
 #include "CellSettings.hh"
 #include "CGAL_Utils.hh"
 #include "Mesh.hh"
@@ -66,6 +67,16 @@ public:
 	void setDeltaGain(double pGain)				{deltaGain = pGain;};
 	/// \brief threshold refinnement setter
 	double getDeltaWin()							{return deltaGain;};
+	/// \brief set the file where IDs of the cells removed for conflicts are appended. Empty to disable
+	void setRemovedCellsFile(QString pFile)		{removedCellsFile = pFile;};
+	/// \brief file where IDs of the cells removed for conflicts are appended
+	QString getRemovedCellsFile() const			{return removedCellsFile;};
+	/// \brief set the refinement target of the cell of the given ID, overriding the global criteria
+	void setRefinementTarget(unsigned long int pCellID, const CellRefinementTarget& pTarget)	{refinementTargets[pCellID] = pTarget;};
+	/// \brief remove all the per cell refinement targets
+	void clearRefinementTargets()				{refinementTargets.clear();};
+	/// \brief per cell refinement targets getter
+	const CellRefinementTargets& getRefinementTargets() const	{return refinementTargets;};
 	/// \brief update cell shapes according to other cell contained on the mesh
 	virtual std::vector<SpheroidalCell*> generateMesh();
 	/// \brief check if the mesh is valid <=> no mesh recovery
@@ -93,7 +104,6 @@ protected:
 	virtual void removeConflicts();
 
 protected:
-	std::map<Point_3, double> weights;										///< \brief the map of weights
 	std::map<SpheroidalCell*, std::set<const SpheroidalCell*> > neighboursCell;	///< \brief for each cell the neighbourhood
 
 private:
@@ -103,6 +113,8 @@ private:
 
 	unsigned int maxNumberOfFacetPerCell;									///< \brief The maximal number of facet a cell must contained
 	double deltaGain;														///< \brief The minimal value for which we continu to reffine
+	QString removedCellsFile;												///< \brief file where IDs of removed cells are appended, empty if none
+	CellRefinementTargets refinementTargets;								///< \brief the refinement targets overriding the global criteria, by cell ID
 
 	std::map<const t_SpatialableAgent_3*, SpheroidalCell*> mConstCellToSpheroidal;	///< \brief map from spatiable agent to Spheroidal Cell
 };
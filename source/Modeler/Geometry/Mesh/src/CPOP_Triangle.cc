@@ -17,7 +17,6 @@ See LICENSE.md for further details
 CPOP_Triangle::CPOP_Triangle(Point_3 a, Point_3 b, Point_3 c, bool pReffinable):
 	reffinable(pReffinable)
 {
-	points.resize(3);
 	setA(a);
 	setB(b);
 	setC(c);
@@ -28,7 +27,7 @@ CPOP_Triangle::CPOP_Triangle(Point_3 a, Point_3 b, Point_3 c, bool pReffinable):
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 CPOP_Triangle::~CPOP_Triangle()
 {
-	points.clear();
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
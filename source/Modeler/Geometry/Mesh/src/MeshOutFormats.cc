@@ -25,6 +25,8 @@ namespace MeshOutFormats
 				return "GEANT_4";			
 			case GATE:
 				return "GATE";
+			case PLY:
+				return "PLY";
 			default:
 				return "Unknow";
 		}
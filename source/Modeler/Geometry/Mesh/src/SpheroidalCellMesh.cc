@@ -14,14 +14,19 @@ See LICENSE.md for further details
 #include "CellMeshSettings.hh"
 #include "EngineSettings.hh"
 #include "Geometry_Utils_Sphere.hh"
+#include "File_Utils_IndexedMesh.hh"
 #include "File_Utils_OFF.hh"
 #include "File_Utils_TXT.hh"
+#include "ParallelChunks.hh"
 #include "Round_Shape.hh"
 #include "SpheroidalCell_MeshSub_Thread.hh"
 #include "UnitSystemManager.hh"
 
 #include <CGAL/convex_hull_3.h>
 
+#include <algorithm>
+#include <chrono>
+
 #ifdef WITH_GDML_EXPORT
 	#include "MyGDML_Parser.hh"	// The GDML parser.
 #endif
@@ -65,7 +70,10 @@ SpheroidalCellMesh::SpheroidalCellMesh(	unsigned int nbFacetPerCell,
 										double delta,
 										set<t_Cell_3* > pCells) :
 	Voronoi_3D_Mesh(nbFacetPerCell, delta, pCells),
-	CellMesh()
+	CellMesh(),
+	convexMembraneSolid(false),
+	validationReportFile(""),
+	verboseLevel(0)
 {
 
 }
@@ -86,6 +94,15 @@ void SpheroidalCellMesh::clean()
 	Voronoi_3D_Mesh::clean();
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// \param pDirectory The directory containing cache files
+/// \param pSourceKey The hash of the source of the cells
+//////////////////////////////////////////////////////////////////////////////
+void SpheroidalCellMesh::setMeshCache(QString pDirectory, uint64_t pSourceKey)
+{
+	meshCache.reset(new SpheroidalCellMeshCache(pDirectory, pSourceKey));
+}
+
 //////////////////////////////////////////////////////////////////////////////
 /// \param pPath The output path file
 /// \param pFormat The requested file format
@@ -129,6 +146,11 @@ int SpheroidalCellMesh::exportToFile(QString pPath, MeshOutFormats::outputFormat
 			error = exportToFileOff(pPath, cells, pDivided);
 			break;
 		}
+		case MeshOutFormats::PLY:
+		{
+			error = exportToFilePly(pPath, &cells);
+			break;
+		}
 		default:
 		{
 			InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES,
@@ -141,6 +163,16 @@ int SpheroidalCellMesh::exportToFile(QString pPath, MeshOutFormats::outputFormat
 	return error;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+/// \param pCells The cells to check, as returned by generateMesh
+/// \param pSettings The thresholds of the checks
+/// \return The validation report. Overlaps are looked for between neighbours
+//////////////////////////////////////////////////////////////////////////////
+Statistics::MeshValidationReport SpheroidalCellMesh::validateMeshes(const vector<SpheroidalCell*>& pCells, const Statistics::MeshValidationSettings& pSettings) const
+{
+	return Statistics::validateCellMeshes(pCells, &neighboursCell, pSettings);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// \return the vector of SpheroidalCell containg a mesh generated by this function
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -156,8 +188,48 @@ vector<SpheroidalCell*> SpheroidalCellMesh::generateMesh()
 
 	vector<SpheroidalCell*> cells = getCellsStructure();
 
-	map<SpheroidalCell*, set<const SpheroidalCell*> > neighbours = static_cast<const map<SpheroidalCell*, set<const SpheroidalCell*> > > (neighboursCell );
+	// the neighbourhood is still needed (convertToG4Logical) but the refinement can be skipped
+	uint64_t cacheKey = 0;
+	if(meshCache)
+	{
+		cacheKey = meshCache->computeKey(cells, getMaxNbFacetPerCell(), getDeltaWin(), MAX_RATIO_NUCLEUS_TO_CELL, getRefinementTargets());
+		if(meshCache->load(cells, cacheKey))
+		{
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::INFORMATION_MES,
+				"cell meshes loaded from " + meshCache->getFilePath(cacheKey).toStdString(), "SpheroidalCellMesh");
+			return cells;
+		}
+	}
+
+	unsigned long nbFailures = reffineCells(cells);
+
+	if(meshCache)
+	{
+		// a partial refinement must not be reused by the next jobs
+		if(nbFailures > 0)
+		{
+			QString failMess = "refinement failed for " + QString::number(nbFailures) + " cell(s), the mesh cache is not written";
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, failMess.toStdString(), "SpheroidalCellMesh");
+		}else if(!meshCache->save(cells, cacheKey))
+		{
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES,
+				"failed to write the mesh cache " + meshCache->getFilePath(cacheKey).toStdString(), "SpheroidalCellMesh");
+		}
+	}
+
+	return cells;
+}
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pCells The cells to refine, their neighbourhood already computed
+/// \return the number of cells for which the refinement failed
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned long SpheroidalCellMesh::reffineCells(const vector<SpheroidalCell*>& pCells)
+{
+	// shared read only by all the refinement threads
+	const map<SpheroidalCell*, set<const SpheroidalCell*> >& neighbours = neighboursCell;
+
+	unsigned long nbFailures = 0;
 	if(!USE_THREAD_FOR_MESH_SUBDVN)
 	{
 		SpheroidalCellMeshSubThread reffinement(
@@ -167,156 +239,97 @@ vector<SpheroidalCell*> SpheroidalCellMesh::generateMesh()
 												&neighbours,
 												MAX_RATIO_NUCLEUS_TO_CELL
 												);
-		for(vector<SpheroidalCell*>::iterator itCell = cells.begin(); itCell != cells.end(); ++itCell)
+		reffinement.setRefinementTargets(&getRefinementTargets());
+		for(vector<SpheroidalCell*>::const_iterator itCell = pCells.begin(); itCell != pCells.end(); ++itCell)
 		{
-			reffinement.reffineCell(*itCell);
+			if(!reffinement.reffineCell(*itCell))
+			{
+				nbFailures++;
+			}
 		}
 	}else
 	{
-		vector<SpheroidalCellMeshSubThread*> reffinementThreads;
-		// create the reffinement threads
-		unsigned int nbThreadToCreate = (cells.size() / MIN_NB_CELL_PER_THREAD) + 1 ;
-		{
-			// create as much thread as needed
-			if(nbThreadToCreate > INITIAL_MAX_THREAD)
-			{
-				nbThreadToCreate = INITIAL_MAX_THREAD;
-			}
-
-			unsigned int threadID = 0;
-			while(reffinementThreads.size() < nbThreadToCreate)
+		const unsigned int maxNbFacet = getMaxNbFacetPerCell();
+		const double deltaWin = getDeltaWin();
+		nbFailures = Voronoi3DCellMeshSubThread::reffineCellsInParallel(pCells,
+			[&](unsigned int threadID) -> Voronoi3DCellMeshSubThread*
 			{
 				if(SPHEROIDAL_CELL_MESH_DEBUG)
 				{
-					mess = "create a new thread of ID "  + QString::number(threadID);
+					QString mess = "create a new thread of ID "  + QString::number(threadID);
 					InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, mess.toStdString(), "SpheroidalCellMesh");
 				}
-
-				reffinementThreads.push_back(	new SpheroidalCellMeshSubThread(
-																					threadID,
-																					getMaxNbFacetPerCell(),
-																					getDeltaWin(),
-																					&neighbours,
-																					MAX_RATIO_NUCLEUS_TO_CELL
-																				));
-				threadID++;
-			}
-		}
-
-		// add cells to threads
-		{
-			vector<SpheroidalCell*>::iterator itCell;
-			int iCell = 0;
-			for(itCell = cells.begin(); itCell != cells.end(); ++itCell)
-			{
-				// G4cout << " \n itCell getID " << itCell->getID() << G4endl;
-				reffinementThreads[iCell%nbThreadToCreate]->addCell(*itCell);
-				iCell++;
-			}
-		}
-
-		// run threads.
-		vector<SpheroidalCellMeshSubThread*>::iterator itThread;
-		for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			(*itThread)->start(MESHING_THREAD_PRIORITY);
-		}
-
-		/// wait until all threads process
-		for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			(*itThread)->wait();
-		}
-
-		//delete reffinement thread
-		for( itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			delete *itThread;
-			*itThread = NULL;
-		}
+				SpheroidalCellMeshSubThread* thread = new SpheroidalCellMeshSubThread(threadID, maxNbFacet, deltaWin, &neighbours, MAX_RATIO_NUCLEUS_TO_CELL);
+				thread->setRefinementTargets(&getRefinementTargets());
+				return thread;
+			});
 	}
-
-
-	return cells;
+	return nbFailures;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
-/// \param pPath 	The output path file
-/// \param cells 	The list of cell to export
-/// \return 		int return values :
-///					- 0 : success
-///					- 1 : not implemented yet
-///					- 2 : failed during export
-///
+/// \param pMesh 	The mesh to fill
+/// \param cells 	The list of cell to add
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
-int SpheroidalCellMesh::exportToFileOff_undivided(QString pPath, std::vector<SpheroidalCell*>* cells)
+void SpheroidalCellMesh::fillIndexedMesh(IO::IndexedMesh& pMesh, const std::vector<SpheroidalCell*>* cells) const
 {
-	unsigned long int nbFacets = 0;				// hte total number of facet on the file
-	set<Point_3, comparePoint_3> points; 						// all the points included inside the mesh
-	map<Point_3, unsigned long int, comparePoint_3> indexes;	// the points and their ids
-	/// create .off file for the mesh
-	pPath += ".off";
-	ofstream* voronoiOut = IO::OFF::createOffFileWithHeader(pPath.toStdString());
-
-	// deal with markup points
-	std::map<set<Point_3>, pair<CGAL::Color, double> > boxes;
+	// deal with markup points, converted to boxes
+	std::map<Point_3, pair<CGAL::Color, double> >::const_iterator itMarkPoint;
+	for( itMarkPoint = markupPoints.begin(); itMarkPoint != markupPoints.end(); ++itMarkPoint)
 	{
-		// convert all of them to boxes
-		std::map<Point_3, pair<CGAL::Color, double> >::const_iterator itMarkPoint;
-		for( itMarkPoint = markupPoints.begin(); itMarkPoint != markupPoints.end(); ++itMarkPoint)
-		{
-			std::set<Point_3> boxPoints = Utils::myCGAL::convertPointToBox(itMarkPoint->first, itMarkPoint->second.second);
-			boxes.insert(make_pair(boxPoints, itMarkPoint->second) );
-			points.insert( boxPoints.begin(), boxPoints.end());
-			Polyhedron_3 polyMark;
-			CGAL::convex_hull_3(boxPoints.begin(), boxPoints.end(), polyMark);
-			nbFacets += Utils::myCGAL::getNumberOfFacets(&polyMark);
-		}
+		std::set<Point_3> boxPoints = Utils::myCGAL::convertPointToBox(itMarkPoint->first, itMarkPoint->second.second);
+		Polyhedron_3 polyMark;
+		CGAL::convex_hull_3(boxPoints.begin(), boxPoints.end(), polyMark);
+		pMesh.addPolyhedron(polyMark, itMarkPoint->second.first);
 	}
 
-	std::vector<SpheroidalCell*>::iterator itCell;
-	Polyhedron_3::Point_iterator itPolyPts;
+	std::vector<SpheroidalCell*>::const_iterator itCell;
 	for(itCell = (*cells).begin(); itCell != (*cells).end(); ++itCell)
 	{
-		points.insert((*itCell)->shape_points_begin(), (*itCell)->shape_points_end());
-		// add shape facets
-		nbFacets += Utils::myCGAL::getNumberOfFacets((*itCell)->getShape());
+		pMesh.addPolyhedron(*(*itCell)->getShape(), (*itCell)->getColor());
 
-		// add nucleus points
+		// add nucleus
 		std::vector<t_Nucleus_3*> lNuclei = (*itCell)->getNuclei();
 		std::vector<t_Nucleus_3*>::iterator itNucleus;
 		for(itNucleus = lNuclei.begin(); itNucleus != lNuclei.end(); ++itNucleus)
 		{
 			std::vector<Point_3> lCellNucleusPoints = (*itNucleus)->getShapePoints();
-			points.insert(lCellNucleusPoints.begin(), lCellNucleusPoints.end());
-			// add the nucleus facets :
 			Polyhedron_3 polyNucleus;
 			CGAL::convex_hull_3(lCellNucleusPoints.begin(), lCellNucleusPoints.end(), polyNucleus);
-			nbFacets += Utils::myCGAL::getNumberOfFacets(&polyNucleus);
+			pMesh.addPolyhedron(polyNucleus, (*itCell)->getColor());
 		}
 	}
+}
 
-	*voronoiOut << distance(points.begin(), points.end()) << " " << nbFacets << " 0" << endl;
-	/// \todo : generate a thread to write on it
-	IO::OFF::exportVerticesToOff(points, indexes, voronoiOut);
-	for(itCell = (*cells).begin(); itCell != (*cells).end(); ++itCell)
-	{
-	    IO::OFF::exportSpheroidalCellToOff(*itCell, voronoiOut, indexes);
-	}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
+/// \param pPath 	The output path file
+/// \param cells 	The list of cell to export
+/// \return 		int return values :
+///					- 0 : success
+///					- 1 : not implemented yet
+///					- 2 : failed during export
+///
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
+int SpheroidalCellMesh::exportToFileOff_undivided(QString pPath, std::vector<SpheroidalCell*>* cells)
+{
+	IO::IndexedMesh mesh;
+	fillIndexedMesh(mesh, cells);
+	return mesh.writeOff((pPath + ".off").toStdString()) ? 0 : 2;
+}
 
-	// export organelles points
-	{
-		std::map<set<Point_3>, pair<CGAL::Color, double> >::const_iterator itMark;
-		for( itMark = boxes.begin(); itMark != boxes.end(); ++itMark)
-		{
-			Polyhedron_3 polyMark;
-			CGAL::convex_hull_3(itMark->first.begin(), itMark->first.end(), polyMark);
-			IO::OFF::exportPolyhedronToOff(&polyMark, voronoiOut, indexes, false, itMark->second.first);
-		}
-	}
-	voronoiOut->close();
-	delete voronoiOut;
-    return 0;
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
+/// \param pPath 	The output path file
+/// \param cells 	The list of cell to export
+/// \return 		int return values :
+///					- 0 : success
+///					- 2 : failed during export
+///
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////:
+int SpheroidalCellMesh::exportToFilePly(QString pPath, std::vector<SpheroidalCell*>* cells)
+{
+	IO::IndexedMesh mesh;
+	fillIndexedMesh(mesh, cells);
+	return mesh.writeBinaryPly((pPath + ".ply").toStdString()) ? 0 : 2;
 }
 
 #if defined(WITH_GEANT_4) || defined(WITH_GDML_EXPORT)
@@ -449,36 +462,88 @@ G4LogicalVolume* SpheroidalCellMesh::convertToG4Logical( G4LogicalVolume* parent
 	assert(delaunay.is_valid());
 	InformationSystemManager::getInstance()->Message(InformationSystemManager::INFORMATION_MES, "starting convertion to G4Logical ", "SpheroidalCellMesh");
 
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 	vector<SpheroidalCell*> cells = generateMesh();
 	if(cells.size() < 1)
 	{
 		return 0;
 	}
+	std::chrono::steady_clock::time_point meshedTime = std::chrono::steady_clock::now();
 
-
-	vector<SpheroidalCell*>::iterator itCell;
-	int iPoly = 0;
-	// set indexes
-	Polyhedron_3::Point_iterator itPolyPts;
-
-	/// \brief generate the cell mesh
+	/// \brief check the meshes before they go to the transport
+	if(!getValidationReportFile().isEmpty())
+	{
+		Statistics::MeshValidationReport report = validateMeshes(cells);
+		std::ofstream reportFile(getValidationReportFile().toStdString().c_str());
+		report.write(reportFile);
+
+		QString mess = QString::number(report.faultyCells.size()) + " faulty cell mesh(es) over " + QString::number(report.nbCells)
+			+ ", report written in " + getValidationReportFile();
+		InformationSystemManager::getInstance()->Message(report.isValid() ? InformationSystemManager::INFORMATION_MES : InformationSystemManager::WARNING_MES,
+			mess.toStdString(), "SpheroidalCellMesh");
+	}
+	std::chrono::steady_clock::time_point validatedTime = std::chrono::steady_clock::now();
+
+	/// \brief convert the cells by blocks : the membrane facets of a block are prepared in parallel on a flat buffer,
+	/// then the G4 entities are created serially since Geant4 geometry construction isn't thread safe.
+	/// The buffer only holds the facets of one block, not the whole population
+	const size_t cellsPerBlock = 1024;
+	const G4double convertionToG4 = G4double(UnitSystemManager::getInstance()->getConversionToG4());
+	vector<size_t> facetsOffsets(std::min(cellsPerBlock, cells.size()) + 1, 0);
+	vector<G4double> membraneFacets;
+	size_t nbFacets = 0;
 	unsigned int nbRemovedForG4 = 0;
-	vector<pair<G4TessellatedSolid*, G4Orb*> > solids;
-	for(itCell = cells.begin(); itCell != cells.end(); ++itCell)
+	std::chrono::steady_clock::duration preparationDuration(0);
+	std::chrono::steady_clock::duration creationDuration(0);
+	for(size_t blockBegin = 0; blockBegin < cells.size(); blockBegin += cellsPerBlock)
 	{
-		QString polyName = cellNamePrefix + QString::number(iPoly);
+		const size_t blockEnd = std::min(blockBegin + cellsPerBlock, cells.size());
+		std::chrono::steady_clock::time_point blockStartTime = std::chrono::steady_clock::now();
 
-		// because of dimension changement from CPOP to G4 and numerical precision we can be forced to remove some cells to ensure no recovrement.
-		map<SpheroidalCell*, set<const SpheroidalCell*> > neighbours = static_cast<const map<SpheroidalCell*, set<const SpheroidalCell*> > > (neighboursCell );
+		for(size_t iCell = blockBegin; iCell < blockEnd; ++iCell)
+		{
+			facetsOffsets[iCell - blockBegin + 1] = facetsOffsets[iCell - blockBegin] + cells[iCell]->getNbMembraneFacets();
+		}
+		membraneFacets.resize(9*facetsOffsets[blockEnd - blockBegin]);
+		nbFacets += facetsOffsets[blockEnd - blockBegin];
 
+		const size_t chunkSize = 64;
+		processChunksInParallel(blockEnd - blockBegin, chunkSize, getNbThreadsFor(blockEnd - blockBegin, chunkSize),
+			[&](size_t pBegin, size_t pEnd, unsigned int)
+			{
+				for(size_t iInBlock = pBegin; iInBlock < pEnd; ++iInBlock)
+				{
+					cells[blockBegin + iInBlock]->writeMembraneFacets(membraneFacets.data() + 9*facetsOffsets[iInBlock], convertionToG4);
+				}
+			});
+		std::chrono::steady_clock::time_point blockPreparedTime = std::chrono::steady_clock::now();
 
-		if( !(*itCell)->convertToG4Structure(logicBB, polyName, checkOverlaps, &neighboursCell, getMaxNbFacetPerCell(), getDeltaWin(), pMapCells, pMapNuclei, pExportNuclei ) )
+		for(size_t iCell = blockBegin; iCell < blockEnd; ++iCell)
 		{
-			cout << "\n polyname : " << (polyName.toStdString()).c_str() << endl;
-			nbRemovedForG4 ++;
+			QString polyName = cellNamePrefix + QString::number(iCell);
+			const size_t iInBlock = iCell - blockBegin;
+
+			// because of dimension changement from CPOP to G4 and numerical precision we can be forced to remove some cells to ensure no recovrement.
+			if( !cells[iCell]->convertToG4Structure(logicBB, polyName, checkOverlaps, &neighboursCell, getMaxNbFacetPerCell(), getDeltaWin(), pMapCells, pMapNuclei, pExportNuclei,
+				membraneFacets.data() + 9*facetsOffsets[iInBlock], facetsOffsets[iInBlock + 1] - facetsOffsets[iInBlock], isConvexMembraneSolid()) )
+			{
+				cout << "\n polyname : " << (polyName.toStdString()).c_str() << endl;
+				nbRemovedForG4 ++;
+			}
 		}
 
-		iPoly ++;
+		preparationDuration += blockPreparedTime - blockStartTime;
+		creationDuration += std::chrono::steady_clock::now() - blockPreparedTime;
+	}
+
+	if(getVerboseLevel() > 0)
+	{
+		typedef std::chrono::duration<double> t_seconds;
+		G4cout << "convertToG4Logical : meshing " << std::chrono::duration_cast<t_seconds>(meshedTime - startTime).count() << " s, "
+			<< "validation " << std::chrono::duration_cast<t_seconds>(validatedTime - meshedTime).count() << " s, "
+			<< "facets preparation " << std::chrono::duration_cast<t_seconds>(preparationDuration).count() << " s, "
+			<< "G4 entities creation " << std::chrono::duration_cast<t_seconds>(creationDuration).count() << " s "
+			<< "(" << nbFacets << " facets, " << nbRemovedForG4 << " cell(s) removed)" << G4endl;
 	}
 	cout << "\n\n\n Real number of cells : " <<  cells.size() << "\n" << endl;
 	return logicBB;
@@ -0,0 +1,494 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "SpheroidalCellMeshCache.hh"
+
+#include "CellSettings.hh"
+#include "InformationSystemManager.hh"
+
+#include <CGAL/Polyhedron_incremental_builder_3.h>
+
+#include <QDir>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+using namespace Settings::Geometry;
+using namespace Settings::Geometry::Mesh3D;
+using namespace Settings::nCell;
+
+/// \brief first bytes of a cache file
+static const char cacheMagic[8] = {'C', 'P', 'O', 'P', 'M', 'S', 'H', '\0'};
+/// \brief version of the cache format. Must be incremented each time the format or the meshing changes
+static const uint32_t cacheVersion = 1;
+/// \brief written as is to reject files coming from a machine with a different endianness
+static const uint32_t endiannessMarker = 0x01020304;
+
+namespace
+{
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief 64 bits FNV-1a hash
+	//////////////////////////////////////////////////////////////////////////////
+	class Hasher
+	{
+	public:
+		Hasher(): value(14695981039346656037ULL)	{}
+
+		void add(const void* pData, size_t pSize)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(pData);
+			for(size_t i = 0; i < pSize; ++i)
+			{
+				value ^= bytes[i];
+				value *= 1099511628211ULL;
+			}
+		}
+
+		template<typename T>
+		void add(const T& pValue)				{ add(&pValue, sizeof(T)); }
+
+		uint64_t getValue() const				{ return value; }
+
+	private:
+		uint64_t value;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief mesh of a cell as stored on the cache
+	//////////////////////////////////////////////////////////////////////////////
+	struct CellRecord
+	{
+		std::vector<double> nuclei;					///< \brief x, y, z, radius of each nucleus
+		std::vector<Point_3> vertices;				///< \brief membrane vertices
+		std::vector<uint32_t> facets;				///< \brief for each facet : degree then vertex indexes
+		uint32_t nbFacets;							///< \brief number of facets
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief bounds checked reader on the cache file content
+	//////////////////////////////////////////////////////////////////////////////
+	class BufferReader
+	{
+	public:
+		BufferReader(const std::vector<char>& pBuffer): buffer(pBuffer), position(0)	{}
+
+		template<typename T>
+		bool read(T& pValue)
+		{
+			if(buffer.size() - position < sizeof(T))
+			{
+				return false;
+			}
+			memcpy(&pValue, &buffer[position], sizeof(T));
+			position += sizeof(T);
+			return true;
+		}
+
+		/// \brief return true if at least pNbItems of pItemSize bytes remain
+		bool hasRoomFor(uint64_t pNbItems, size_t pItemSize) const
+		{
+			return pNbItems <= (buffer.size() - position) / pItemSize;
+		}
+
+		bool isAtEnd() const					{ return position == buffer.size(); }
+
+	private:
+		const std::vector<char>& buffer;
+		size_t position;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief build a polyhedron from the stored vertices and facets
+	//////////////////////////////////////////////////////////////////////////////
+	class MembraneBuilder : public CGAL::Modifier_base<Polyhedron_3::HalfedgeDS>
+	{
+	public:
+		MembraneBuilder(const CellRecord& pRecord): record(pRecord), success(false)	{}
+
+		void operator()(Polyhedron_3::HalfedgeDS& pHDS)
+		{
+			CGAL::Polyhedron_incremental_builder_3<Polyhedron_3::HalfedgeDS> builder(pHDS, false);
+			builder.begin_surface(record.vertices.size(), record.nbFacets);
+			for(std::vector<Point_3>::const_iterator itVertex = record.vertices.begin(); itVertex != record.vertices.end(); ++itVertex)
+			{
+				builder.add_vertex(*itVertex);
+			}
+			size_t iIndex = 0;
+			for(uint32_t iFacet = 0; iFacet < record.nbFacets; ++iFacet)
+			{
+				uint32_t degree = record.facets[iIndex++];
+				builder.begin_facet();
+				for(uint32_t iVertex = 0; iVertex < degree; ++iVertex)
+				{
+					builder.add_vertex_to_facet(record.facets[iIndex++]);
+				}
+				builder.end_facet();
+				if(builder.error())
+				{
+					break;
+				}
+			}
+			if(builder.error())
+			{
+				builder.rollback();
+				return;
+			}
+			builder.end_surface();
+			success = !builder.error();
+		}
+
+		bool succeeded() const		{ return success; }
+
+	private:
+		const CellRecord& record;
+		bool success;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief return the round nuclei of the cell, false if one of them isn't round
+	//////////////////////////////////////////////////////////////////////////////
+	bool getRoundNuclei(const SpheroidalCell* pCell, std::vector<t_RoundNucleus_3*>& pNuclei)
+	{
+		pNuclei.clear();
+		std::vector<t_Nucleus_3*> nuclei = pCell->getNuclei();
+		for(std::vector<t_Nucleus_3*>::iterator itNucleus = nuclei.begin(); itNucleus != nuclei.end(); ++itNucleus)
+		{
+			t_RoundNucleus_3* roundNucleus = dynamic_cast<t_RoundNucleus_3*>(*itNucleus);
+			if(!roundNucleus)
+			{
+				return false;
+			}
+			pNuclei.push_back(roundNucleus);
+		}
+		return true;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pDirectory The directory containing cache files
+/// \param pSourceKey The hash of the source the cells are coming from
+//////////////////////////////////////////////////////////////////////////////////////////////
+SpheroidalCellMeshCache::SpheroidalCellMeshCache(QString pDirectory, uint64_t pSourceKey):
+	directory(pDirectory),
+	sourceKey(pSourceKey)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pPath The file to hash
+/// \return the FNV-1a hash of the file content, 0 if the file can't be read
+//////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t SpheroidalCellMeshCache::hashFile(const std::string& pPath)
+{
+	std::ifstream file(pPath.c_str(), std::ios::in | std::ios::binary);
+	if(!file)
+	{
+		return 0;
+	}
+
+	Hasher hasher;
+	std::vector<char> buffer(1 << 16);
+	while(file)
+	{
+		file.read(&buffer[0], buffer.size());
+		hasher.add(&buffer[0], static_cast<size_t>(file.gcount()));
+	}
+	if(file.bad())
+	{
+		return 0;
+	}
+	return hasher.getValue();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pKey The key of the cache
+/// \return The path of the cache file
+//////////////////////////////////////////////////////////////////////////////////////////////
+QString SpheroidalCellMeshCache::getFilePath(uint64_t pKey) const
+{
+	return QDir(directory).filePath("cpop_mesh_" + QString::number(static_cast<qulonglong>(pKey), 16).rightJustified(16, '0') + ".bin");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \details nuclei are not part of the key : their radius is updated by the meshing itself
+/// but only depends on the source and on the cells positions and radius.
+/// \param pCells The cells to mesh
+/// \param pMaxNbFacet The maximal number of facet per cell
+/// \param pDeltaWin The minimal value for which we continu to reffine
+/// \param pMaxRatioNucleusToCell The maximal ratio between nucleus and cell radius
+/// \param pTargets The per cell refinement targets
+/// \return The key of the mesh
+//////////////////////////////////////////////////////////////////////////////////////////////
+uint64_t SpheroidalCellMeshCache::computeKey(const std::vector<SpheroidalCell*>& pCells, unsigned int pMaxNbFacet, double pDeltaWin, double pMaxRatioNucleusToCell,
+	const CellRefinementTargets& pTargets) const
+{
+	Hasher hasher;
+	hasher.add(cacheVersion);
+	hasher.add(sourceKey);
+	hasher.add(static_cast<uint64_t>(pMaxNbFacet));
+	hasher.add(pDeltaWin);
+	hasher.add(pMaxRatioNucleusToCell);
+
+	// the cell order depends on the triangulation : make the key independant of it
+	std::vector<const SpheroidalCell*> cells(pCells.begin(), pCells.end());
+	std::sort(cells.begin(), cells.end(), [](const SpheroidalCell* a, const SpheroidalCell* b) { return a->getID() < b->getID(); });
+
+	hasher.add(static_cast<uint64_t>(cells.size()));
+	for(std::vector<const SpheroidalCell*>::const_iterator itCell = cells.begin(); itCell != cells.end(); ++itCell)
+	{
+		Point_3 origin = (*itCell)->getOrigin();
+		hasher.add(static_cast<uint64_t>((*itCell)->getID()));
+		hasher.add(origin.x());
+		hasher.add(origin.y());
+		hasher.add(origin.z());
+		hasher.add((*itCell)->getRadius());
+	}
+
+	// targets are sorted by cell ID
+	hasher.add(static_cast<uint64_t>(pTargets.size()));
+	for(CellRefinementTargets::const_iterator itTarget = pTargets.begin(); itTarget != pTargets.end(); ++itTarget)
+	{
+		hasher.add(static_cast<uint64_t>(itTarget->first));
+		hasher.add(static_cast<uint64_t>(itTarget->second.maxNbFacet));
+		hasher.add(itTarget->second.maxFacetArea);
+	}
+	return hasher.getValue();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pCells The cells to set the mesh of
+/// \param pKey The key of the mesh
+/// \return true if all the cells have been set from the cache
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool SpheroidalCellMeshCache::load(const std::vector<SpheroidalCell*>& pCells, uint64_t pKey) const
+{
+	QString path = getFilePath(pKey);
+	std::vector<char> buffer;
+	{
+		std::ifstream file(path.toStdString().c_str(), std::ios::in | std::ios::binary);
+		if(!file)
+		{
+			return false;
+		}
+		file.seekg(0, std::ios::end);
+		std::streamoff size = file.tellg();
+		if(size <= 0)
+		{
+			return false;
+		}
+		buffer.resize(static_cast<size_t>(size));
+		file.seekg(0, std::ios::beg);
+		if(!file.read(&buffer[0], size))
+		{
+			return false;
+		}
+	}
+
+	// header
+	BufferReader reader(buffer);
+	char magic[sizeof(cacheMagic)];
+	uint32_t version, marker;
+	uint64_t key, nbCells;
+	if(!reader.read(magic) || memcmp(magic, cacheMagic, sizeof(cacheMagic)) != 0 ||
+		!reader.read(version) || version != cacheVersion ||
+		!reader.read(marker) || marker != endiannessMarker ||
+		!reader.read(key) || key != pKey ||
+		!reader.read(nbCells) || nbCells != pCells.size())
+	{
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::INFORMATION_MES,
+			"ignoring incompatible mesh cache " + path.toStdString(), "SpheroidalCellMeshCache");
+		return false;
+	}
+
+	// decode every record before touching any cell
+	std::map<unsigned long int, CellRecord> records;
+	for(uint64_t iCell = 0; iCell < nbCells; ++iCell)
+	{
+		uint64_t ID;
+		uint32_t nbNuclei, nbVertices, nbFacets;
+		if(!reader.read(ID) || !reader.read(nbNuclei) || !reader.hasRoomFor(nbNuclei, 4*sizeof(double)))
+		{
+			return false;
+		}
+		CellRecord& record = records[ID];
+		record.nuclei.resize(4*nbNuclei);
+		for(size_t i = 0; i < record.nuclei.size(); ++i)
+		{
+			reader.read(record.nuclei[i]);
+		}
+
+		if(!reader.read(nbVertices) || !reader.hasRoomFor(nbVertices, 3*sizeof(double)))
+		{
+			return false;
+		}
+		record.vertices.reserve(nbVertices);
+		for(uint32_t iVertex = 0; iVertex < nbVertices; ++iVertex)
+		{
+			double x, y, z;
+			reader.read(x);
+			reader.read(y);
+			reader.read(z);
+			record.vertices.push_back(Point_3(x, y, z));
+		}
+
+		if(!reader.read(nbFacets) || !reader.hasRoomFor(nbFacets, 4*sizeof(uint32_t)))
+		{
+			return false;
+		}
+		record.nbFacets = nbFacets;
+		for(uint32_t iFacet = 0; iFacet < nbFacets; ++iFacet)
+		{
+			uint32_t degree;
+			if(!reader.read(degree) || degree < 3 || !reader.hasRoomFor(degree, sizeof(uint32_t)))
+			{
+				return false;
+			}
+			record.facets.push_back(degree);
+			for(uint32_t iVertex = 0; iVertex < degree; ++iVertex)
+			{
+				uint32_t index;
+				reader.read(index);
+				if(index >= nbVertices)
+				{
+					return false;
+				}
+				record.facets.push_back(index);
+			}
+		}
+	}
+	if(!reader.isAtEnd() || records.size() != pCells.size())
+	{
+		return false;
+	}
+
+	// check the cache matches the cells
+	std::vector<std::vector<t_RoundNucleus_3*> > cellsNuclei(pCells.size());
+	for(size_t iCell = 0; iCell < pCells.size(); ++iCell)
+	{
+		std::map<unsigned long int, CellRecord>::const_iterator itRecord = records.find(pCells[iCell]->getID());
+		if(itRecord == records.end() || !getRoundNuclei(pCells[iCell], cellsNuclei[iCell]) || (4*cellsNuclei[iCell].size() != itRecord->second.nuclei.size()))
+		{
+			return false;
+		}
+	}
+
+	// set meshes
+	for(size_t iCell = 0; iCell < pCells.size(); ++iCell)
+	{
+		SpheroidalCell* cell = pCells[iCell];
+		const CellRecord& record = records[cell->getID()];
+
+		for(size_t iNucleus = 0; iNucleus < cellsNuclei[iCell].size(); ++iNucleus)
+		{
+			const double* nucleus = &record.nuclei[4*iNucleus];
+			cellsNuclei[iCell][iNucleus]->setOrigin(Point_3(nucleus[0], nucleus[1], nucleus[2]));
+			cellsNuclei[iCell][iNucleus]->setRadius(nucleus[3]);
+		}
+
+		cell->resetMesh();
+		MembraneBuilder builder(record);
+		cell->getShape()->delegate(builder);
+		if(!builder.succeeded())
+		{
+			// cells before this one are already set : the caller has to refine all of them
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES,
+				"corrupted mesh cache " + path.toStdString(), "SpheroidalCellMeshCache");
+			for(size_t iReset = 0; iReset <= iCell; ++iReset)
+			{
+				pCells[iReset]->resetMesh();
+			}
+			return false;
+		}
+		cell->computeMembraneSurfaceArea();
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pCells The cells to store the mesh of
+/// \param pKey The key of the mesh
+/// \return true if the cache file has been written
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool SpheroidalCellMeshCache::save(const std::vector<SpheroidalCell*>& pCells, uint64_t pKey) const
+{
+	std::vector<char> buffer;
+	auto write = [&buffer](const void* pData, size_t pSize)
+	{
+		const char* bytes = static_cast<const char*>(pData);
+		buffer.insert(buffer.end(), bytes, bytes + pSize);
+	};
+
+	write(cacheMagic, sizeof(cacheMagic));
+	write(&cacheVersion, sizeof(cacheVersion));
+	write(&endiannessMarker, sizeof(endiannessMarker));
+	write(&pKey, sizeof(pKey));
+	uint64_t nbCells = pCells.size();
+	write(&nbCells, sizeof(nbCells));
+
+	std::vector<t_RoundNucleus_3*> nuclei;
+	std::unordered_map<const void*, uint32_t> vertexIndexes;
+	for(std::vector<SpheroidalCell*>::const_iterator itCell = pCells.begin(); itCell != pCells.end(); ++itCell)
+	{
+		SpheroidalCell* cell = *itCell;
+		if(!getRoundNuclei(cell, nuclei))
+		{
+			return false;
+		}
+
+		uint64_t ID = cell->getID();
+		write(&ID, sizeof(ID));
+		uint32_t nbNuclei = nuclei.size();
+		write(&nbNuclei, sizeof(nbNuclei));
+		for(std::vector<t_RoundNucleus_3*>::const_iterator itNucleus = nuclei.begin(); itNucleus != nuclei.end(); ++itNucleus)
+		{
+			double nucleus[4] = {(*itNucleus)->getOrigin().x(), (*itNucleus)->getOrigin().y(), (*itNucleus)->getOrigin().z(), (*itNucleus)->getRadius()};
+			write(nucleus, sizeof(nucleus));
+		}
+
+		const Polyhedron_3* shape = cell->getShape();
+		vertexIndexes.clear();
+		uint32_t nbVertices = shape->size_of_vertices();
+		write(&nbVertices, sizeof(nbVertices));
+		for(Polyhedron_3::Vertex_const_iterator itVertex = shape->vertices_begin(); itVertex != shape->vertices_end(); ++itVertex)
+		{
+			uint32_t index = vertexIndexes.size();
+			vertexIndexes[&*itVertex] = index;
+			double point[3] = {itVertex->point().x(), itVertex->point().y(), itVertex->point().z()};
+			write(point, sizeof(point));
+		}
+
+		uint32_t nbFacets = shape->size_of_facets();
+		write(&nbFacets, sizeof(nbFacets));
+		for(Polyhedron_3::Facet_const_iterator itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet)
+		{
+			uint32_t degree = itFacet->facet_degree();
+			write(&degree, sizeof(degree));
+			Polyhedron_3::Halfedge_around_facet_const_circulator itHalfedge = itFacet->facet_begin();
+			do
+			{
+				uint32_t index = vertexIndexes[&*(itHalfedge->vertex())];
+				write(&index, sizeof(index));
+			}while(++itHalfedge != itFacet->facet_begin());
+		}
+	}
+
+	// QSaveFile writes on a temporary file then renames it so an other job never reads a partial file
+	QDir().mkpath(directory);
+	QSaveFile file(getFilePath(pKey));
+	if(!file.open(QIODevice::WriteOnly) || file.write(&buffer[0], buffer.size()) != static_cast<qint64>(buffer.size()))
+	{
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
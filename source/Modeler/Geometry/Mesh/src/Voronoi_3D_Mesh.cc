@@ -10,6 +10,7 @@ See LICENSE.md for further details
 
 #include "Agent.hh"
 #include "CellMesh.hh"
+#include "CellMeshSettings.hh"
 #include "CGAL_Utils.hh"
 #include "EngineSettings.hh"
 #include "File_Utils.hh"
@@ -22,8 +23,10 @@ See LICENSE.md for further details
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/convex_hull_3.h>
 
+#include <deque>
 #include <string>
 #include <fstream>
+#include <unordered_map>
 
 #ifndef NDEBUG
 	#define VORONOI_3D_MESH_DEBUG 0
@@ -52,7 +55,8 @@ Voronoi_3D_Mesh::Voronoi_3D_Mesh(
 	Mesh<double, Point_3, Vector_3>(MeshTypes::Weighted_Voronoi_Tesselation),
 	Delaunay_3D_SDS("Voronoi_based_Mesh_3D"),
 	maxNumberOfFacetPerCell(pMaxNbFacet),
-	deltaGain(delta)
+	deltaGain(delta),
+	removedCellsFile(REMOVED_CELLS_FILE)
 {
 	minWeight = numeric_limits<double>::max();
 	maxWeight = -1;
@@ -138,7 +142,6 @@ bool Voronoi_3D_Mesh::add(t_Cell_3* pToAdd)
 		));
 
 	// deal with weights
-	weights[pToAdd->getPosition()] = cell->getRadius();
 	if( cell->getRadius() < minWeight )
 	{
 		minWeight = cell->getRadius();
@@ -295,6 +298,9 @@ int Voronoi_3D_Mesh::exportToFileOff_divided(QString pPath, std::vector<Spheroid
 //////////////////////////////////////////////////////////////////////////////
 /// for example if a cell is at (0, 0, 0) with a radius of 10 and an other at (1, 0, 0,) with a radius of 1.
 /// The second cell will be removed.
+/// \details every vertex starts on a worklist. When a vertex is removed, only its former
+/// neighbours see their star change, so only they are put back on the worklist.
+/// Weights are stored in an array indexed by vertex, the cell radius being the weight.
 //////////////////////////////////////////////////////////////////////////////
 void Voronoi_3D_Mesh::removeConflicts()
 {
@@ -302,60 +308,140 @@ void Voronoi_3D_Mesh::removeConflicts()
  	/// \todo : remove conflict without weights : must be done, check it
 
 	assert(delaunay.is_valid());
-	// create shape
-	set<Vertex_3_handle> verticesToRemove; // we will remove all vertices which aren'Gabriel
 
-	RT_3::Finite_edges_iterator itEdge;
+	vector<Vertex_3_handle> vertices;
+	vector<double> vertexWeights;
+	vector<bool> inWorklist;
+	vector<bool> removed;
+	unordered_map<const t_SpatialableAgent_3*, size_t> vertexIndexes;
+	deque<size_t> worklist;
 
-	ofstream id_cell_file("IDCell.txt", fstream::app);
+	// index a vertex the first time it is met and put it on the worklist
+	auto indexOf = [&](Vertex_3_handle v) -> size_t
+	{
+		unordered_map<const t_SpatialableAgent_3*, size_t>::const_iterator itIndex = vertexIndexes.find(v->info());
+		if(itIndex != vertexIndexes.end())
+		{
+			return itIndex->second;
+		}
+		size_t index = vertices.size();
+		vertexIndexes.insert(make_pair(v->info(), index));
+		vertices.push_back(v);
+		vertexWeights.push_back(mConstCellToSpheroidal[v->info()]->getRadius());
+		inWorklist.push_back(true);
+		removed.push_back(false);
+		worklist.push_back(index);
+		return index;
+	};
+
+	vertices.reserve(delaunay.number_of_vertices());
+	vertexWeights.reserve(delaunay.number_of_vertices());
+	RT_3::Finite_vertices_iterator itVertex;
+	for(itVertex = delaunay.finite_vertices_begin(); itVertex != delaunay.finite_vertices_end(); ++itVertex)
+	{
+		if(itVertex->info())
+		{
+			indexOf(itVertex);
+		}
+	}
 
-	id_cell_file << " " ;
+	ofstream id_cell_file;
+	vector<Vertex_3_handle> adjacents;
+	unsigned long int nbConflict = 0;
 
-	for(itEdge = delaunay.finite_edges_begin(); itEdge != delaunay.finite_edges_end(); ++itEdge)
+	while(!worklist.empty())
 	{
-		Vertex_3_handle v1 = itEdge->first->vertex(itEdge->second);
-		Vertex_3_handle v2 = itEdge->first->vertex(itEdge->third);
-		double maxLength = max(weights[v1->point().point()], weights[v2->point().point()]);
-		RT_3::Vertex_handle vToRemove;
+		size_t iVertex = worklist.front();
+		worklist.pop_front();
+		inWorklist[iVertex] = false;
+		if(removed[iVertex])
+		{
+			continue;
+		}
+
+		Vertex_3_handle v1 = vertices[iVertex];
+		adjacents.clear();
+		delaunay.finite_adjacent_vertices(v1, back_inserter(adjacents));
 
-		// if the two points are in conflict
-		if(sqrt(CGAL::squared_distance(v1->point().point(), v2->point().point())) < maxLength)
+		vector<Vertex_3_handle>::const_iterator itAdj;
+		for(itAdj = adjacents.begin(); itAdj != adjacents.end(); ++itAdj)
 		{
+			Vertex_3_handle v2 = *itAdj;
+			// hidden points uncovered by a removal aren't linked to any agent
+			if(!v2->info())
+			{
+				continue;
+			}
+			size_t iAdj = indexOf(v2);
+			double w1 = vertexWeights[iVertex];
+			double w2 = vertexWeights[iAdj];
+
+			// if the two points are not in conflict
+			if(CGAL::squared_distance(v1->point().point(), v2->point().point()) >= max(w1, w2)*max(w1, w2))
+			{
+				continue;
+			}
+
 			// pick the vertex to remove
-			if(weights[v1->point().point()] < weights[v2->point().point()])
+			size_t iToRemove;
+			if(w1 < w2)
 			{
-				vToRemove = (REMOVE_SMALLEST_WEIGHT ? v1 : v2 );
+				iToRemove = (REMOVE_SMALLEST_WEIGHT ? iVertex : iAdj );
 			}else
-			if(weights[v1->point().point()] == weights[v2->point().point()])
+			if(w1 == w2)
 			{
 				// if same weights : remove the one with the bigest ID ( to insure repetability, need to have a rule )
-				vToRemove = (v1->info()->getID() < v2->info()->getID()) ? v2 : v1;
+				iToRemove = (v1->info()->getID() < v2->info()->getID()) ? iAdj : iVertex;
 			}else
 			{
-				vToRemove = (REMOVE_SMALLEST_WEIGHT ? v2 : v1 );
+				iToRemove = (REMOVE_SMALLEST_WEIGHT ? iAdj : iVertex );
+			}
+			Vertex_3_handle vToRemove = vertices[iToRemove];
+
+			if(!removedCellsFile.isEmpty())
+			{
+				if(!id_cell_file.is_open())
+				{
+					id_cell_file.open(removedCellsFile.toStdString().c_str(), fstream::app);
+					id_cell_file << " " ;
+				}
+				id_cell_file << vToRemove->info()->getID() << " ";
 			}
-			id_cell_file << vToRemove->info()->getID() << " ";
-			verticesToRemove.insert(vToRemove);
 
+			// the star of each neighbour of the removed vertex is going to change
+			vector<Vertex_3_handle> impacted;
+			delaunay.finite_adjacent_vertices(vToRemove, back_inserter(impacted));
+
+			removed[iToRemove] = true;
+			nbConflict++;
+			remove(mConstCellToSpheroidal[vToRemove->info()]);
+
+			vector<Vertex_3_handle>::const_iterator itImpacted;
+			for(itImpacted = impacted.begin(); itImpacted != impacted.end(); ++itImpacted)
+			{
+				if(!(*itImpacted)->info())
+				{
+					continue;
+				}
+				size_t iImpacted = indexOf(*itImpacted);
+				if(!removed[iImpacted] && !inWorklist[iImpacted])
+				{
+					inWorklist[iImpacted] = true;
+					worklist.push_back(iImpacted);
+				}
+			}
+			// the star of the current vertex changed (or it has been removed) : it is back on the worklist if needed
+			break;
 		}
 	}
 
-
-	// remove conflicting vertex ( cell )
-	int nbConflict = verticesToRemove.size();
-	set<RT_3::Vertex_handle>::iterator itVertexToRmv = verticesToRemove.begin();
-	while(itVertexToRmv != verticesToRemove.end())
+	if(VORONOI_3D_MESH_DEBUG)
 	{
-		remove(mConstCellToSpheroidal[(*itVertexToRmv)->info()]);
-		verticesToRemove.erase(itVertexToRmv++);
+		QString mess = QString::number(nbConflict) + " cell(s) removed for conflicts";
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, mess.toStdString(), "Voronoi_3DMesh");
 	}
 
 	assert(delaunay.is_valid());
-	// check if conflict remain, if it is the case, do removeConflict againt
-	if(nbConflict > 0)
-	{
-		removeConflicts();
-	}
 }
 
 #include <CGAL/Direction_3.h>
@@ -429,7 +515,8 @@ std::vector<SpheroidalCell*> Voronoi_3D_Mesh::generateMesh()
 
 	vector<SpheroidalCell*> cells = getCellsStructure();
 
-	map<SpheroidalCell*, set<const SpheroidalCell*> > neighbours = static_cast<const map<SpheroidalCell*, set<const SpheroidalCell*> > > (neighboursCell );
+	// shared read only by all the refinement threads
+	const map<SpheroidalCell*, set<const SpheroidalCell*> >& neighbours = neighboursCell;
 
 	// if not using thread
 	if(!USE_THREAD_FOR_MESH_SUBDVN)
@@ -439,74 +526,27 @@ std::vector<SpheroidalCell*> Voronoi_3D_Mesh::generateMesh()
 												getMaxNbFacetPerCell(),
 												getDeltaWin(),
 												&neighbours);
+		reffinement.setRefinementTargets(&refinementTargets);
 		for(vector<SpheroidalCell*>::iterator itCell = cells.begin(); itCell != cells.end(); ++itCell)
 		{
 			reffinement.reffineCell(*itCell);
 		}
 	}else
 	{
-		//cout << "\n\n\n using THREAD_FOR_MESH_SUBDVN : " << endl;
-		vector<Voronoi3DCellMeshSubThread*> reffinementThreads;
-		// create the reffinement threads
-		unsigned int nbThreadToCreate = (cells.size() / MIN_NB_CELL_PER_THREAD) + 1 ;
-		{
-			// create as much thread as needed
-			if(nbThreadToCreate > INITIAL_MAX_THREAD)
-			{
-				nbThreadToCreate = INITIAL_MAX_THREAD;
-			}
-
-			unsigned int threadID = 0;
-			while(reffinementThreads.size() < nbThreadToCreate)
+		const unsigned int maxNbFacet = getMaxNbFacetPerCell();
+		const double deltaWin = getDeltaWin();
+		Voronoi3DCellMeshSubThread::reffineCellsInParallel(cells,
+			[&](unsigned int threadID) -> Voronoi3DCellMeshSubThread*
 			{
 				if(VORONOI_3D_MESH_DEBUG)
 				{
-					mess = "create a new thread of ID "  + QString::number(threadID);
+					QString mess = "create a new thread of ID "  + QString::number(threadID);
 					InformationSystemManager::getInstance()->Message(InformationSystemManager::DEBUG_MES, mess.toStdString(), "Voronoi_3DMesh");
 				}
-
-				reffinementThreads.push_back(	new Voronoi3DCellMeshSubThread(	threadID,
-																				getMaxNbFacetPerCell(),
-																				getDeltaWin(),
-																				&neighbours
-																				));
-
-				threadID++;
-			}
-		}
-
-		// add cells to threads
-		{
-			vector<SpheroidalCell*>::iterator itCell;
-			int iCell = 0;
-			for(itCell = cells.begin(); itCell != cells.end(); ++itCell)
-			{
-				//IDManager::getInstance()->setID(this);
-				// itCell->forceID(iCell)
-				reffinementThreads[iCell%nbThreadToCreate]->addCell(*itCell);
-				iCell++;
-			}
-		}
-
-		// run threads.
-		vector<Voronoi3DCellMeshSubThread*>::iterator itThread;
-		for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			(*itThread)->start(MESHING_THREAD_PRIORITY);
-		}
-
-		/// wait until all threads process
-		for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			(*itThread)->wait();
-		}
-
-		//delete reffinement thread
-		for( itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
-		{
-			delete *itThread;
-			*itThread = NULL;
-		}
+				Voronoi3DCellMeshSubThread* thread = new Voronoi3DCellMeshSubThread(threadID, maxNbFacet, deltaWin, &neighbours);
+				thread->setRefinementTargets(&refinementTargets);
+				return thread;
+			});
 	}
 	neighboursCell.clear();
 
@@ -0,0 +1,53 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef CELL_REFINEMENT_QUEUE_HH
+#define CELL_REFINEMENT_QUEUE_HH
+
+#include "ParallelChunks.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+class SpheroidalCell;
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief The queue of cells shared by the refinement threads.
+/// \details threads take chunks of consecutive cells until the queue is empty.
+/// Chunks are guided (see ChunkQueue) so that the expensive cells met at the end
+/// are spread over all threads.
+//////////////////////////////////////////////////////////////////////////////
+class CellRefinementQueue
+{
+public:
+	/// \brief constructor
+	CellRefinementQueue(const std::vector<SpheroidalCell*>& pCells, unsigned int pNbWorkers);
+
+	/// \brief take the next chunk of cells [pBegin, pEnd[. Return false if no more cell to refine
+	bool takeChunk(std::size_t& pBegin, std::size_t& pEnd)	{ return chunks.takeChunk(pBegin, pEnd); }
+	/// \brief return the cell at the given index
+	SpheroidalCell* getCell(std::size_t pIndex) const	{ return cells[pIndex]; }
+	/// \brief return the number of cells
+	std::size_t size() const							{ return cells.size(); }
+
+	/// \brief notify that the refinement of a cell failed
+	void reportFailure()								{ nbFailures.fetch_add(1, std::memory_order_relaxed); }
+	/// \brief return the number of cells for which the refinement failed
+	unsigned long getNbFailures() const					{ return nbFailures.load(std::memory_order_relaxed); }
+
+	/// \brief return the number of refinement threads to use for the given number of cells
+	static unsigned int getNbThreads(std::size_t pNbCells);
+
+private:
+	const std::vector<SpheroidalCell*>& cells;		///< \brief the cells to refine, shared read only
+	ChunkQueue chunks;								///< \brief gives the chunks of cell indices
+	std::atomic<unsigned long> nbFailures;			///< \brief number of cells the refinement failed for
+};
+
+#endif // CELL_REFINEMENT_QUEUE_HH
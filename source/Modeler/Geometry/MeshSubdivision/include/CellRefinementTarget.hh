@@ -0,0 +1,35 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef CELL_REFINEMENT_TARGET_HH
+#define CELL_REFINEMENT_TARGET_HH
+
+#include <map>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief The refinement target of a single cell membrane.
+/// \details overrides the global criteria of the mesh for this cell : the subdivision
+/// stops once the membrane reaches maxNbFacet facets or once all facets are smaller
+/// than maxFacetArea, whichever comes first.
+//////////////////////////////////////////////////////////////////////////////
+struct CellRefinementTarget
+{
+	/// \brief constructor
+	CellRefinementTarget(unsigned int pMaxNbFacet = 0, double pMaxFacetArea = 0.):
+		maxNbFacet(pMaxNbFacet),
+		maxFacetArea(pMaxFacetArea)
+	{}
+
+	unsigned int maxNbFacet;		///< \brief maximal number of facets of the membrane. 0 to keep the mesh default
+	double maxFacetArea;			///< \brief facets under this area are not subdivided (mesh unit). 0 to disable
+};
+
+/// \brief refinement targets by cell ID
+typedef std::map<unsigned long int, CellRefinementTarget> CellRefinementTargets;
+
+#endif // CELL_REFINEMENT_TARGET_HH
@@ -0,0 +1,56 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef CLIPPING_PLANES_INDEX_HH
+#define CLIPPING_PLANES_INDEX_HH
+
+#include "Mesh3DSettings.hh"
+
+#include <vector>
+
+using namespace Settings::Geometry;
+using namespace Settings::Geometry::Mesh3D;
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief angular index of the planes clipping a cell sphere.
+/// \details planes have the cell center on their positive side. The negative side
+/// of a plane only contains points of the ball whose direction (from the center)
+/// lies in a cone around the plane normal. Directions are bucketed on a cube map
+/// and each bucket keeps the (ordered) planes whose cone reaches it, so a point is
+/// only tested against the few planes around it.
+//////////////////////////////////////////////////////////////////////////////
+class ClippingPlanesIndex
+{
+public:
+	/// \brief constructor
+	ClippingPlanesIndex();
+
+	/// \brief index the planes. Valid for points at a distance lower than pMaxRadius from pCenter
+	void build(const std::vector<Plane_3>& pPlanes, const Point_3& pCenter, double pMaxRadius);
+	/// \brief remove all planes
+	void clear();
+
+	/// \brief return the indexes (increasing) of the planes which may have the point on their negative side
+	const std::vector<unsigned int>& getCandidates(const Point_3& pPt) const;
+
+	/// \brief oriented side of the point. Evaluated with doubles and exactly re-checked
+	/// only when the point is too close to the plane to trust the rounding
+	static CGAL::Oriented_side orientedSide(const Plane_3& pPlane, const Point_3& pPt);
+
+private:
+	/// \brief return the bucket of the given direction
+	unsigned int getBucket(double dx, double dy, double dz) const;
+
+private:
+	Point_3 center;											///< \brief center of the cell sphere
+	double squaredMaxRadius;								///< \brief squared radius of the ball the index is valid for
+	std::vector<std::vector<unsigned int> > buckets;		///< \brief planes reaching each bucket
+	std::vector<unsigned int> allPlanes;					///< \brief all planes, for points outside the ball
+};
+
+#endif // CLIPPING_PLANES_INDEX_HH
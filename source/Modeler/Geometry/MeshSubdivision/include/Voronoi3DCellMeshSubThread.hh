@@ -10,6 +10,9 @@ See LICENSE.md for further details
 #define VORONOI_3D_CELL_MESH_SUBDIVION_THREAD_HH
 
 #include "CellMeshSettings.hh"
+#include "CellRefinementQueue.hh"
+#include "CellRefinementTarget.hh"
+#include "ClippingPlanesIndex.hh"
 #include "CPOP_Circle.hh"
 #include "CPOP_Triangle.hh"
 #include "Nucleus.hh"
@@ -17,6 +20,7 @@ See LICENSE.md for further details
 #include "SpheroidalCell.hh"
 #include "RefinementThread.hh"
 
+#include <functional>
 #include <map>
 #include <vector>
 
@@ -45,6 +49,10 @@ public:
 	virtual ~Voronoi3DCellMeshSubThread();
 	/// \brief add a spheroidal cell struct to reffine
 	void addCell(SpheroidalCell*);
+	/// \brief set the queue to take cells from. If set, cells added by addCell are ignored
+	void setQueue(CellRefinementQueue* pQueue)			{ queue = pQueue;}
+	/// \brief set the per cell refinement targets, shared read only. NULL to apply the global criteria to all cells
+	void setRefinementTargets(const CellRefinementTargets* pTargets)	{ refinementTargets = pTargets;}
 	/// \brief run of the thread.
 	void run();
 	/// \brief main function called to reffine a specific cell
@@ -55,6 +63,10 @@ public:
 	/// \brief space between cell getter
 	double getSpaceBetweenCell() const 					{ return spaceBetweenCells;}
 
+	/// \brief refine all the cells using as much threads as the hardware provides
+	static unsigned long reffineCellsInParallel(const std::vector<SpheroidalCell*>& pCells,
+		std::function<Voronoi3DCellMeshSubThread*(unsigned int)> pCreateThread);
+
 protected:
 	/// \brief generate the intersections planes for the given cell
 	bool generateIntersectionPlane(SpheroidalCell* cell);
@@ -69,25 +81,28 @@ private:
 	/// \brief update the point of the mesh according to intersections.
 	inline void adjustPointFromIntersections( Point_3& ptToCheck );
 	/// \brief evaluate if point are interesting enought to be include on the mesh.
-	inline bool ptsAreInteresting(const CPOP_Triangle*facet, std::vector<Point_3> pts);
+	inline bool ptsAreInteresting(const CPOP_Triangle*facet, const std::vector<Point_3>& pts);
 	/// \brief  return the point to add when subdivizing a facet
 	inline Point_3 getPointNewPointFromSeg(int indexVertex1, int indexVertex2, const CPOP_Triangle* triangle, Point_3 sphereCenter, double sphereRadius);
 	/// \brief compute the error due to the approximation.
 	// virtual void computeGeometryInformation();
 
 protected:
-	std::map<Point_3, int> reffinementValues;		///< \brief map each point to the plane he is part of. If -1 : not par of an intersection plane but on the theorical sphere
-	/// \brief memorise the interesting intersection plane from the voronoi cell.
+	/// \brief memorise the interesting intersection plane from the voronoi cell. The plane ID is its index.
 	/// \warning emake sur the plane has his normal on the opposite direction of the sphere center.
-	std::vector<Plane_3*> intersections; 
-	/// \brief map of plane with there given IDs
-	std::map<Plane_3*, int> intersectionIDMap;	
+	std::vector<Plane_3> intersections;
+	/// \brief angular index of the intersections, to only check the planes close to a point
+	ClippingPlanesIndex intersectionsIndex;
 
 	std::vector<SpheroidalCell*> cellsToReffine;										///< \brief all the cell to reffine.
 	/// \brief the list of neighbour and there weight.	
 	const std::map<SpheroidalCell*, std::set<const SpheroidalCell* > >* neighbourCells;	
 	/// \brief the minimal space to generate betwen each cell. Half ot his distance will be directly removed from the cells radius.
 	double spaceBetweenCells;									
+	/// \brief the queue shared with other threads, NULL if the thread refines cellsToReffine only
+	CellRefinementQueue* queue;
+	/// \brief the refinement targets overriding the global criteria for some cells. NULL if none
+	const CellRefinementTargets* refinementTargets;
 };
 
 #endif // SPHEROIDAL_3D_CELL_MESH_THREAD_HH
\ No newline at end of file
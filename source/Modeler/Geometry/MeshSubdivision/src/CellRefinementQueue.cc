@@ -0,0 +1,37 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "CellRefinementQueue.hh"
+
+#include "CellMeshSettings.hh"
+
+#include <algorithm>
+
+/// \brief the maximal number of cells in a chunk
+static const std::size_t maxChunkSize = 64;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pCells The cells to refine. Must stay alive and unchanged while the queue is used
+/// \param pNbWorkers The number of threads which will take cells from the queue
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CellRefinementQueue::CellRefinementQueue(const std::vector<SpheroidalCell*>& pCells, unsigned int pNbWorkers):
+	cells(pCells),
+	chunks(pCells.size(), maxChunkSize, std::max(1u, pNbWorkers)),
+	nbFailures(0)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pNbCells The number of cells to refine
+/// \return the number of hardware threads, without creating threads with less than MIN_NB_CELL_PER_THREAD cells
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int CellRefinementQueue::getNbThreads(std::size_t pNbCells)
+{
+	return getNbThreadsFor(pNbCells, MIN_NB_CELL_PER_THREAD);
+}
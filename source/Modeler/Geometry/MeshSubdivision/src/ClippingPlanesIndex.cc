@@ -0,0 +1,200 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "ClippingPlanesIndex.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/// \brief number of buckets along each axis of a cube map face
+static const unsigned int bucketsPerAxis = 4;
+/// \brief number of buckets of the cube map
+static const unsigned int nbBuckets = 6 * bucketsPerAxis * bucketsPerAxis;
+/// \brief angular margin added to each test (radian)
+static const double angularMargin = 1e-6;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+ClippingPlanesIndex::ClippingPlanesIndex():
+	center(CGAL::ORIGIN),
+	squaredMaxRadius(0.)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void ClippingPlanesIndex::clear()
+{
+	buckets.clear();
+	allPlanes.clear();
+	squaredMaxRadius = 0.;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param dx x coordinate of the direction
+/// \param dy y coordinate of the direction
+/// \param dz z coordinate of the direction
+/// \return the cube map bucket containing the direction
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int ClippingPlanesIndex::getBucket(double dx, double dy, double dz) const
+{
+	double ax = std::fabs(dx), ay = std::fabs(dy), az = std::fabs(dz);
+	unsigned int face;
+	double u, v, major;
+	if(ax >= ay && ax >= az)
+	{
+		face = (dx >= 0.) ? 0 : 1;
+		major = ax;	u = dy;	v = dz;
+	}else if(ay >= az)
+	{
+		face = (dy >= 0.) ? 2 : 3;
+		major = ay;	u = dx;	v = dz;
+	}else
+	{
+		face = (dz >= 0.) ? 4 : 5;
+		major = az;	u = dx;	v = dy;
+	}
+	if(major <= 0.)
+	{
+		return 0;
+	}
+
+	unsigned int iU = std::min(bucketsPerAxis - 1, static_cast<unsigned int>((u / major + 1.) * 0.5 * bucketsPerAxis));
+	unsigned int iV = std::min(bucketsPerAxis - 1, static_cast<unsigned int>((v / major + 1.) * 0.5 * bucketsPerAxis));
+	return (face * bucketsPerAxis + iU) * bucketsPerAxis + iV;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pPlanes The planes, with pCenter on their positive side
+/// \param pCenter The center of the cell sphere
+/// \param pMaxRadius The maximal distance to pCenter of the points to check
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void ClippingPlanesIndex::build(const std::vector<Plane_3>& pPlanes, const Point_3& pCenter, double pMaxRadius)
+{
+	clear();
+	center = pCenter;
+	squaredMaxRadius = pMaxRadius * pMaxRadius;
+	buckets.resize(nbBuckets);
+
+	allPlanes.resize(pPlanes.size());
+	for(unsigned int iPlane = 0; iPlane < pPlanes.size(); ++iPlane)
+	{
+		allPlanes[iPlane] = iPlane;
+	}
+
+	// cone of each plane : axis pointing to the negative side, half angle acos(distance to center / max radius)
+	std::vector<double> axes(3*pPlanes.size());
+	std::vector<double> halfAngles(pPlanes.size());
+	for(unsigned int iPlane = 0; iPlane < pPlanes.size(); ++iPlane)
+	{
+		const Plane_3& plane = pPlanes[iPlane];
+		double norm = std::sqrt(plane.a()*plane.a() + plane.b()*plane.b() + plane.c()*plane.c());
+		axes[3*iPlane] 		= -plane.a() / norm;
+		axes[3*iPlane + 1] 	= -plane.b() / norm;
+		axes[3*iPlane + 2] 	= -plane.c() / norm;
+		double distance = (plane.a()*pCenter.x() + plane.b()*pCenter.y() + plane.c()*pCenter.z() + plane.d()) / norm;
+		halfAngles[iPlane] = std::acos(std::max(-1., std::min(1., distance / pMaxRadius)));
+	}
+
+	// for each bucket : center direction and angular radius (reached on a corner), then the planes reaching it
+	for(unsigned int face = 0; face < 6; ++face)
+	{
+		for(unsigned int iU = 0; iU < bucketsPerAxis; ++iU)
+		{
+			for(unsigned int iV = 0; iV < bucketsPerAxis; ++iV)
+			{
+				double corners[4][3];
+				double bucketCenter[3];
+				double uMin = -1. + 2. * iU / bucketsPerAxis;
+				double vMin = -1. + 2. * iV / bucketsPerAxis;
+				double uMax = uMin + 2. / bucketsPerAxis;
+				double vMax = vMin + 2. / bucketsPerAxis;
+				double uv[5][2] = {{uMin, vMin}, {uMin, vMax}, {uMax, vMin}, {uMax, vMax}, {(uMin + uMax)/2., (vMin + vMax)/2.}};
+				for(unsigned int iCorner = 0; iCorner < 5; ++iCorner)
+				{
+					double sign = (face % 2 == 0) ? 1. : -1.;
+					double dir[3];
+					switch(face / 2)
+					{
+						case 0 :	dir[0] = sign;			dir[1] = uv[iCorner][0];	dir[2] = uv[iCorner][1];	break;
+						case 1 :	dir[0] = uv[iCorner][0];	dir[1] = sign;			dir[2] = uv[iCorner][1];	break;
+						default :	dir[0] = uv[iCorner][0];	dir[1] = uv[iCorner][1];	dir[2] = sign;			break;
+					}
+					double norm = std::sqrt(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+					double* target = (iCorner < 4) ? corners[iCorner] : bucketCenter;
+					target[0] = dir[0] / norm;
+					target[1] = dir[1] / norm;
+					target[2] = dir[2] / norm;
+				}
+
+				double bucketRadius = 0.;
+				for(unsigned int iCorner = 0; iCorner < 4; ++iCorner)
+				{
+					double cosAngle = corners[iCorner][0]*bucketCenter[0] + corners[iCorner][1]*bucketCenter[1] + corners[iCorner][2]*bucketCenter[2];
+					bucketRadius = std::max(bucketRadius, std::acos(std::max(-1., std::min(1., cosAngle))));
+				}
+
+				std::vector<unsigned int>& bucket = buckets[(face * bucketsPerAxis + iU) * bucketsPerAxis + iV];
+				for(unsigned int iPlane = 0; iPlane < pPlanes.size(); ++iPlane)
+				{
+					double cosAngle = axes[3*iPlane]*bucketCenter[0] + axes[3*iPlane + 1]*bucketCenter[1] + axes[3*iPlane + 2]*bucketCenter[2];
+					double angle = std::acos(std::max(-1., std::min(1., cosAngle)));
+					if(angle <= halfAngles[iPlane] + bucketRadius + angularMargin)
+					{
+						bucket.push_back(iPlane);
+					}
+				}
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pPt The point to get the candidate planes for
+/// \return the planes to test, all of them if the point is outside of the indexed ball
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+const std::vector<unsigned int>& ClippingPlanesIndex::getCandidates(const Point_3& pPt) const
+{
+	double dx = pPt.x() - center.x();
+	double dy = pPt.y() - center.y();
+	double dz = pPt.z() - center.z();
+	if(buckets.empty() || (dx*dx + dy*dy + dz*dz) > squaredMaxRadius)
+	{
+		return allPlanes;
+	}
+	return buckets[getBucket(dx, dy, dz)];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pPlane The plane
+/// \param pPt The point to locate
+/// \return the side of the plane the point is on
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CGAL::Oriented_side ClippingPlanesIndex::orientedSide(const Plane_3& pPlane, const Point_3& pPt)
+{
+	double ax = pPlane.a() * pPt.x();
+	double by = pPlane.b() * pPt.y();
+	double cz = pPlane.c() * pPt.z();
+	double value = ax + by + cz + pPlane.d();
+	// bound of the rounding error of the four terms sum
+	double errorBound = 8. * DBL_EPSILON * (std::fabs(ax) + std::fabs(by) + std::fabs(cz) + std::fabs(pPlane.d()));
+	if(value > errorBound)
+	{
+		return CGAL::ON_POSITIVE_SIDE;
+	}
+	if(value < -errorBound)
+	{
+		return CGAL::ON_NEGATIVE_SIDE;
+	}
+	// near degenerate : exact predicate
+	return pPlane.oriented_side(pPt);
+}
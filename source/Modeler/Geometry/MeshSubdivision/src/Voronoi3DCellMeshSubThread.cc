@@ -16,6 +16,12 @@ See LICENSE.md for further details
 #include <CGAL/convex_hull_3.h>
 #include <CGAL/intersections.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+
 #ifndef NDEBUG
 	#define VORONOI_3D_MESH_SUBDIVISION_DEBUG 0
 #else
@@ -50,7 +56,9 @@ Voronoi3DCellMeshSubThread::Voronoi3DCellMeshSubThread(
 	RefinementThread(pID, pMaximalNumberOfFacets, pDeltaWin),
 	cellsToReffine(pCellsToReffine),
 	neighbourCells(pNeighbourCells),
-	spaceBetweenCells(pSpaceBetweenCells)
+	spaceBetweenCells(pSpaceBetweenCells),
+	queue(NULL),
+	refinementTargets(NULL)
 {
 	// patch for refinement
 	deltaReffinement = max(minDistPts, deltaReffinement);
@@ -63,7 +71,6 @@ Voronoi3DCellMeshSubThread::Voronoi3DCellMeshSubThread(
 Voronoi3DCellMeshSubThread::~Voronoi3DCellMeshSubThread()
 {
 	clean();
-	intersectionIDMap.clear();
 	cellsToReffine.clear();
 }
 
@@ -94,6 +101,23 @@ void Voronoi3DCellMeshSubThread::run()
 	// new std::vector<SpheroidalCell*> cells;
 	// SpheroidalCellMesh::exportToFileGDML("/home/levrague/Documents/Geant4_these", cells, true);
 
+	// take cells from the shared queue until it is empty
+	if(queue)
+	{
+		std::size_t begin, end;
+		while(queue->takeChunk(begin, end))
+		{
+			for(std::size_t iCell = begin; iCell < end; ++iCell)
+			{
+				if(!reffineCell(queue->getCell(iCell)))
+				{
+					queue->reportFailure();
+				}
+			}
+		}
+		return;
+	}
+
 	// bool sucess = true;
 	/// TODO : send error if not a sucess
 	std::vector<SpheroidalCell*>::iterator itCell;
@@ -108,18 +132,58 @@ void Voronoi3DCellMeshSubThread::run()
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-///
+/// \param pCells 			The cells to reffine
+/// \param pCreateThread 	Create the refinement thread of the given ID. Threads are deleted by this function
+/// \return the number of cells for which the refinement failed
+/// \details threads take chunks of cells from a shared queue, so a thread which meets cheap cells
+/// simply takes more of them.
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void Voronoi3DCellMeshSubThread::clean()
+unsigned long Voronoi3DCellMeshSubThread::reffineCellsInParallel(
+	const std::vector<SpheroidalCell*>& pCells,
+	std::function<Voronoi3DCellMeshSubThread*(unsigned int)> pCreateThread)
 {
-	reffinementValues.clear();
-	// delete intersections
-	std::vector<Plane_3*>::iterator itPlane;
-	for(itPlane = intersections.begin(); itPlane != intersections.end(); ++itPlane)
+	unsigned int nbThreadToCreate = CellRefinementQueue::getNbThreads(pCells.size());
+	CellRefinementQueue cellsQueue(pCells, nbThreadToCreate);
+
+	std::vector<Voronoi3DCellMeshSubThread*> reffinementThreads;
+	for(unsigned int threadID = 0; threadID < nbThreadToCreate; ++threadID)
+	{
+		Voronoi3DCellMeshSubThread* thread = pCreateThread(threadID);
+		assert(thread);
+		thread->setQueue(&cellsQueue);
+		reffinementThreads.push_back(thread);
+	}
+
+	// run threads.
+	std::vector<Voronoi3DCellMeshSubThread*>::iterator itThread;
+	for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
+	{
+		(*itThread)->start(MESHING_THREAD_PRIORITY);
+	}
+
+	/// wait until all threads process
+	for(itThread = reffinementThreads.begin(); itThread != reffinementThreads.end(); ++itThread)
 	{
-		delete (*itPlane);
+		(*itThread)->wait();
+		delete *itThread;
+		*itThread = NULL;
 	}
+
+	if(cellsQueue.getNbFailures() > 0)
+	{
+		QString mess = "failed to reffine " + QString::number(cellsQueue.getNbFailures()) + " cell(s) over " + QString::number(pCells.size());
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, mess.toStdString(), "Voronoi3DCellMeshSubThread");
+	}
+	return cellsQueue.getNbFailures();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void Voronoi3DCellMeshSubThread::clean()
+{
 	intersections.clear();
+	intersectionsIndex.clear();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -141,9 +205,8 @@ bool Voronoi3DCellMeshSubThread::generateIntersectionPlane(SpheroidalCell* cell)
 	assert(cell);
 	assert(neighbourCells->find(cell) != neighbourCells->end());
 	assert( (cell->getRadius() - spaceBetweenCells/2.) > 0.  );
-	int intersectionID = 0;
 
-	std::set<const SpheroidalCell*> cellNeighbour = neighbourCells->find(cell)->second;
+	const std::set<const SpheroidalCell*>& cellNeighbour = neighbourCells->find(cell)->second;
 	std::vector<Point_3> polyInitPts;
 
 	for(std::set<const SpheroidalCell*>::iterator itNeighbour = cellNeighbour.begin(); itNeighbour != cellNeighbour.end(); ++itNeighbour)
@@ -164,19 +227,17 @@ bool Voronoi3DCellMeshSubThread::generateIntersectionPlane(SpheroidalCell* cell)
 										Sphere_3((*itNeighbour)->getOrigin(), (*itNeighbour)->getSquareRadius() + (spaceBetweenCells*spaceBetweenCells / 4.), CGAL::COUNTERCLOCKWISE),	// CGAL take the square radius in parameter
 										Sphere_3(cell->getOrigin(), cell->getSquareRadius() - (spaceBetweenCells*spaceBetweenCells / 4.), CGAL::COUNTERCLOCKWISE));
 
-			Plane_3* plane = NULL;
 			if(interPlane.oriented_side(cell->getOrigin()) == CGAL::ON_NEGATIVE_SIDE)
 			{
-				plane = new Plane_3(interPlane.opposite());
+				intersections.push_back( interPlane.opposite() );
 			}else
 			{
-				plane = new Plane_3(interPlane);
+				intersections.push_back( interPlane );
 			}
-			intersections.push_back( plane );
-			intersectionIDMap.insert(std::pair<Plane_3*, int>(plane, intersectionID));
-			intersectionID++;
 		}
 	}
+	// all the points we adjust are on (or inside) the cell sphere
+	intersectionsIndex.build(intersections, cell->getOrigin(), cell->getRadius()*(1. + 1e-9));
 
 	std::vector<Point_3> basicPoints = generateBasicCellMembraneMesh(cell);
 	polyInitPts.insert( polyInitPts.begin(), basicPoints.begin(), basicPoints.end() );
@@ -221,35 +282,97 @@ inline bool Voronoi3DCellMeshSubThread::subdivseCellMembraneMesh(SpheroidalCell*
 						"VoronoiCell_ToSpheroid_Refinement");
 	}
 
+	// the cell target, if any, replaces the global criteria
+	unsigned int maxNbFacet = RefinementThread::numberOfUnitaryEntityPerCell;
+	double minWin = deltaReffinement;
+	if(refinementTargets)
+	{
+		CellRefinementTargets::const_iterator itTarget = refinementTargets->find(cell->getID());
+		if(itTarget != refinementTargets->end())
+		{
+			if(itTarget->second.maxNbFacet > 0)
+			{
+				maxNbFacet = itTarget->second.maxNbFacet;
+			}
+			// the heap key is 16A^2 : a facet smaller than the target area is not worth subdividing
+			double maxArea = itTarget->second.maxFacetArea;
+			minWin = std::max(minWin, 16.*maxArea*maxArea);
+		}
+	}
+
 	// case we can avoid the creation of all projection.
-	if(std::distance(cell->shape_facets_begin(), cell->shape_facets_end()) >= (int)RefinementThread::numberOfUnitaryEntityPerCell)
+	if(std::distance(cell->shape_facets_begin(), cell->shape_facets_end()) >= (int)maxNbFacet)
 	{
 		return true;
 	}
 
-	// create stack of facet for raffinement.
-	std::set<CPOP_Triangle> facets;
-	for(Polyhedron_3::Facet_iterator itFacet = cell->shape_facets_begin(); itFacet != cell->shape_facets_end(); ++itFacet)
+	// facets are stored as vertex indices, refined in place. A binary heap gives the facet
+	// with the highest potential win (16A^2), the key being computed once per facet.
+	std::vector<Point_3> vertices;
+	std::vector<std::array<unsigned int, 3> > facets;
+	std::vector<bool> aliveFacets;
+	std::priority_queue<std::pair<double, std::size_t> > facetsToReffine;
+	std::size_t nbAliveFacets = 0;
+
+	auto addFacet = [&](unsigned int a, unsigned int b, unsigned int c)
 	{
-		if(itFacet->is_triangle())
+		facets.push_back({{a, b, c}});
+		aliveFacets.push_back(true);
+		nbAliveFacets++;
+		CPOP_Triangle facet(vertices[a], vertices[b], vertices[c], true);
+		facetsToReffine.push(std::make_pair(facet.get16squareA(), facets.size() - 1));
+	};
+
+	{
+		std::map<Point_3, unsigned int> vertexIndexes;
+		auto indexOf = [&](const Point_3& pt) -> unsigned int
 		{
-			Point_3 pt1 = itFacet->halfedge()->vertex()->point();
-			Point_3 pt2 = itFacet->halfedge()->next()->vertex()->point();
-			Point_3 pt3 = itFacet->halfedge()->next()->next()->vertex()->point();
+			std::map<Point_3, unsigned int>::iterator itIndex = vertexIndexes.find(pt);
+			if(itIndex != vertexIndexes.end())
+			{
+				return itIndex->second;
+			}
+			vertices.push_back(pt);
+			vertexIndexes.insert(std::make_pair(pt, (unsigned int)(vertices.size() - 1)));
+			return (unsigned int)(vertices.size() - 1);
+		};
 
-			CPOP_Triangle facet(pt1, pt2, pt3, true);  // true == can raffine
-			// will be ordered with the first win on top.
-			facets.insert(facet);
+		for(Polyhedron_3::Facet_iterator itFacet = cell->shape_facets_begin(); itFacet != cell->shape_facets_end(); ++itFacet)
+		{
+			if(itFacet->is_triangle())
+			{
+				unsigned int i1 = indexOf(itFacet->halfedge()->vertex()->point());
+				unsigned int i2 = indexOf(itFacet->halfedge()->next()->vertex()->point());
+				unsigned int i3 = indexOf(itFacet->halfedge()->next()->next()->vertex()->point());
+				addFacet(i1, i2, i3);
+			}
 		}
 	}
 
+	// an edge is shared by two facets : its new point (projection and clipping) is only computed once
+	std::unordered_map<std::uint64_t, unsigned int> edgeNewPoints;
+	const double projectionRadius = cell->getRadius() - spaceBetweenCells/2.;
+	auto getEdgeNewPoint = [&](const CPOP_Triangle& facet, const std::array<unsigned int, 3>& indexes, int i1, int i2) -> unsigned int
+	{
+		unsigned int v1 = std::min(indexes[i1], indexes[i2]);
+		unsigned int v2 = std::max(indexes[i1], indexes[i2]);
+		std::uint64_t edgeKey = (std::uint64_t(v1) << 32) | std::uint64_t(v2);
+		std::unordered_map<std::uint64_t, unsigned int>::iterator itEdge = edgeNewPoints.find(edgeKey);
+		if(itEdge != edgeNewPoints.end())
+		{
+			return itEdge->second;
+		}
+		vertices.push_back(getPointNewPointFromSeg(i1, i2, &facet, cell->getOrigin(), projectionRadius));
+		edgeNewPoints.insert(std::make_pair(edgeKey, (unsigned int)(vertices.size() - 1)));
+		return (unsigned int)(vertices.size() - 1);
+	};
+
 	/// until we need to include facet
-	while(facets.size() < RefinementThread::numberOfUnitaryEntityPerCell)
+	std::vector<Point_3> newPts(3);
+	while(nbAliveFacets < maxNbFacet && !facetsToReffine.empty())
 	{
-		CPOP_Triangle facetToReffine = *facets.begin();
 		// if reach the win is not enought or the reffinement is useless.
-		// todo : add function get potential win plutôt
-		if( (facetToReffine.get16squareA() < deltaReffinement)  || (!facetToReffine.canReffine()))
+		if(facetsToReffine.top().first < minWin)
 		{
 			if(VORONOI_3D_MESH_SUBDIVISION_DEBUG)
 			{
@@ -259,58 +382,68 @@ inline bool Voronoi3DCellMeshSubThread::subdivseCellMembraneMesh(SpheroidalCell*
 			}
 			break;
 		}
-		// remove the old facet
-		facets.erase(facets.begin());
+		std::size_t iFacet = facetsToReffine.top().second;
+		facetsToReffine.pop();
 
-		/// get the three new vertices to add. They can be  :
-		Point_3 ptToAdd1 = getPointNewPointFromSeg(0, 1, &facetToReffine, cell->getOrigin(), cell->getRadius() - spaceBetweenCells/2. );
-		Point_3 ptToAdd2 = getPointNewPointFromSeg(1, 2, &facetToReffine, cell->getOrigin(), cell->getRadius() - spaceBetweenCells/2. );
-		Point_3 ptToAdd3 = getPointNewPointFromSeg(2, 0, &facetToReffine, cell->getOrigin(), cell->getRadius() - spaceBetweenCells/2. );
+		// copy : facets can be reallocated when adding the new ones
+		const std::array<unsigned int, 3> indexes = facets[iFacet];
+		CPOP_Triangle facetToReffine(vertices[indexes[0]], vertices[indexes[1]], vertices[indexes[2]], true);
 
-		/// if error during sub division
+		/// get the three new vertices to add. They can be  :
+		unsigned int iToAdd1 = getEdgeNewPoint(facetToReffine, indexes, 0, 1);
+		unsigned int iToAdd2 = getEdgeNewPoint(facetToReffine, indexes, 1, 2);
+		unsigned int iToAdd3 = getEdgeNewPoint(facetToReffine, indexes, 2, 0);
+		const Point_3& ptToAdd1 = vertices[iToAdd1];
+		const Point_3& ptToAdd2 = vertices[iToAdd2];
+		const Point_3& ptToAdd3 = vertices[iToAdd3];
+
+		/// if error during sub division the facet is kept as is and no longer reffined
 		if(	is_nan(ptToAdd1.x()) || is_nan(ptToAdd1.y()) || is_nan(ptToAdd1.z()) ||
 			is_nan(ptToAdd2.x()) || is_nan(ptToAdd2.y()) || is_nan(ptToAdd2.z()) ||
 			is_nan(ptToAdd3.x()) || is_nan(ptToAdd3.y()) || is_nan(ptToAdd3.z()) )
 		{
-			facetToReffine.setReffinement(false);
-			facets.insert(facetToReffine);
-		}else
-		{
-
-			std::vector<Point_3> pts;
-			pts.push_back(ptToAdd3);
-			pts.push_back(ptToAdd2);
-			pts.push_back(ptToAdd1);
+			continue;
+		}
 
-			// if one the new points arn't interesting enought
-			if(!ptsAreInteresting(&facetToReffine, pts) )
-			{
-				facetToReffine.setReffinement(false);
-				facets.insert(facetToReffine);
-			}else
-			{
-				CPOP_Triangle newFacet1(facetToReffine.getA(), ptToAdd1, ptToAdd3, true);
-				facets.insert(newFacet1);
+		newPts[0] = ptToAdd3;
+		newPts[1] = ptToAdd2;
+		newPts[2] = ptToAdd1;
+		// if one the new points arn't interesting enought
+		if(!ptsAreInteresting(&facetToReffine, newPts) )
+		{
+			continue;
+		}
 
-				CPOP_Triangle newFacet2(ptToAdd1, facetToReffine.getB(), ptToAdd2, true);
-				facets.insert(newFacet2);
+		// remove the old facet
+		aliveFacets[iFacet] = false;
+		nbAliveFacets--;
 
-				CPOP_Triangle newFacet3(ptToAdd2, facetToReffine.getC(), ptToAdd3, true);
-				facets.insert(newFacet3);
+		addFacet(indexes[0], iToAdd1, iToAdd3);
+		addFacet(iToAdd1, indexes[1], iToAdd2);
+		addFacet(iToAdd2, indexes[2], iToAdd3);
+		addFacet(iToAdd1, iToAdd2, iToAdd3);
+	}
 
-				CPOP_Triangle newFacet4(ptToAdd1, ptToAdd2, ptToAdd3, true);
-				facets.insert(newFacet4);
-			}
+	/// after having generating enought facet recreate the new polyhedron from the vertices in use.
+	/// The hull is only built once, at the end of the subdivision
+	std::vector<bool> usedVertices(vertices.size(), false);
+	for(std::size_t iFacet = 0; iFacet < facets.size(); ++iFacet)
+	{
+		if(aliveFacets[iFacet])
+		{
+			usedVertices[facets[iFacet][0]] = true;
+			usedVertices[facets[iFacet][1]] = true;
+			usedVertices[facets[iFacet][2]] = true;
 		}
 	}
-
-	/// after having generating enought facet recreate the new polyhedron
-	std::set<Point_3> pts;
-	for(std::set<CPOP_Triangle>::iterator itTri = facets.begin(); itTri != facets.end(); ++itTri)
+	std::vector<Point_3> pts;
+	pts.reserve(vertices.size());
+	for(std::size_t iVertex = 0; iVertex < vertices.size(); ++iVertex)
 	{
-		pts.insert(itTri->getA());
-		pts.insert(itTri->getB());
-		pts.insert(itTri->getC());
+		if(usedVertices[iVertex])
+		{
+			pts.push_back(vertices[iVertex]);
+		}
 	}
 	CGAL::convex_hull_3(pts.begin(), pts.end(), *(cell->getShape()) );
 
@@ -322,11 +455,12 @@ inline bool Voronoi3DCellMeshSubThread::subdivseCellMembraneMesh(SpheroidalCell*
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 inline void Voronoi3DCellMeshSubThread::adjustPointFromIntersections( Point_3& ptToCheck )
 {
-	int currentLine = -1;
-
-	std::vector<Plane_3*>::const_iterator itIntersection;
-	for(itIntersection = intersections.begin(); itIntersection != intersections.end(); ++itIntersection)
+	// planes are still checked in their creation order, but only those whose negative side can contain the point
+	const std::vector<unsigned int>* candidates = &intersectionsIndex.getCandidates(ptToCheck);
+	std::vector<unsigned int>::const_iterator itCandidate = candidates->begin();
+	while(itCandidate != candidates->end())
 	{
+		const Plane_3& intersection = intersections[*itCandidate];
 		/// En : it is the equivalent of the intersection test between the segment ( medium segment point, medium segment point's projection on tte sphere)
 		/// work only because we are on a sphere and one of the segment point is already on the sphere.
 		/// This permit to deduce that the projection of the point can at mst intersect one of the plane (from the voronoi cell)
@@ -334,21 +468,24 @@ inline void Voronoi3DCellMeshSubThread::adjustPointFromIntersections( Point_3& p
 		/// Fonctionne seulement car l'on travail dans une sphère et que l'on raffine un segment dont
 		/// un de ces points est déjà situé sur la sphère.
 		/// On peut en déduire que le projeté du milieu du segment ne peut au pus intersecter un et un seul plan de la cellule de voronoi.
-		if((*itIntersection)->oriented_side(ptToCheck) == CGAL::ON_NEGATIVE_SIDE)
+		if(ClippingPlanesIndex::orientedSide(intersection, ptToCheck) == CGAL::ON_NEGATIVE_SIDE)
 		{
 			// the intersection of the segment with the plane correspond to the projection because we are on an arc sphere that we want to reffine
 			// (<=> one of the point is already set on the sphere)
-			ptToCheck = (*itIntersection)->projection(ptToCheck);
+			ptToCheck = intersection.projection(ptToCheck);
 			// remove the point if undef. CGAL issue ?
 			if(is_nan(ptToCheck.x()) || is_nan(ptToCheck.y()) || is_nan(ptToCheck.z())  )
 			{
 				return;
 			}
-			currentLine = intersectionIDMap[*itIntersection];
+			// the point moved : continue with the next planes around its new position
+			unsigned int nextPlane = *itCandidate + 1;
+			candidates = &intersectionsIndex.getCandidates(ptToCheck);
+			itCandidate = std::lower_bound(candidates->begin(), candidates->end(), nextPlane);
+			continue;
 		}
+		++itCandidate;
 	}
-	// else no interssection : on the spehroid : value = -1
-	reffinementValues.insert(std::pair<Point_3, int>(ptToCheck, currentLine));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -357,7 +494,7 @@ inline void Voronoi3DCellMeshSubThread::adjustPointFromIntersections( Point_3& p
 /// \param facet The facet we want to compare the point with
 /// \param pts to compare with the facet
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-inline bool Voronoi3DCellMeshSubThread::ptsAreInteresting(const CPOP_Triangle* facet, std::vector<Point_3> pts)
+inline bool Voronoi3DCellMeshSubThread::ptsAreInteresting(const CPOP_Triangle* facet, const std::vector<Point_3>& pts)
 {
 	// TODO : remove this function and replace by the map of point to know where they are situated.
 	Triangle_3 tri(facet->getA(), facet->getB(), facet->getC());
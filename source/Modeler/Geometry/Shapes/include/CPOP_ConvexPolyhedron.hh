@@ -0,0 +1,104 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef CPOP_CONVEX_POLYHEDRON_HH
+#define CPOP_CONVEX_POLYHEDRON_HH
+
+#ifdef WITH_GEANT_4
+
+#include "Geometry_Utils_Triangle.hh"
+
+#include "G4ThreeVector.hh"
+#include "G4VSolid.hh"
+
+#include <array>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief G4 solid for a closed convex polyhedron, defined as the intersection
+/// of the half-spaces of its facets.
+/// \details Inside, DistanceToIn and DistanceToOut are evaluated in closed form
+/// from the plane set (a single pass over the planes, no voxel traversal),
+/// which is what the navigation needs for the convex cell membranes.
+/// The triangles are only kept for the volume, the surface sampling and the
+/// visualisation. Coplanar triangles share the same plane.
+//////////////////////////////////////////////////////////////////////////////
+class CPOP_ConvexPolyhedron : public G4VSolid
+{
+public:
+	/// \brief build the solid from pNbFacets triangles (9 coordinates per facet, outward oriented).
+	/// Return NULL if the triangles don't bound a convex polyhedron
+	static CPOP_ConvexPolyhedron* create(const G4String& pName, const G4double* pFacets, size_t pNbFacets);
+	/// \brief destructor
+	virtual ~CPOP_ConvexPolyhedron();
+
+	/// \brief return kInside, kSurface or kOutside
+	EInside Inside(const G4ThreeVector& p) const;
+	/// \brief return the outward normal of the surface at (or the closest to) p
+	G4ThreeVector SurfaceNormal(const G4ThreeVector& p) const;
+	/// \brief distance along v from an outside point to the solid, kInfinity if missed
+	G4double DistanceToIn(const G4ThreeVector& p, const G4ThreeVector& v) const;
+	/// \brief underestimate of the distance from an outside point to the solid
+	G4double DistanceToIn(const G4ThreeVector& p) const;
+	/// \brief distance along v from an inside point to the surface
+	G4double DistanceToOut(const G4ThreeVector& p, const G4ThreeVector& v,
+		const G4bool calcNorm = false, G4bool* validNorm = 0, G4ThreeVector* n = 0) const;
+	/// \brief underestimate of the distance from an inside point to the surface
+	G4double DistanceToOut(const G4ThreeVector& p) const;
+
+	/// \brief axis aligned bounding box of the solid
+	void BoundingLimits(G4ThreeVector& pMin, G4ThreeVector& pMax) const;
+	/// \brief extent of the solid along pAxis once transformed, within the voxel limits
+	G4bool CalculateExtent(const EAxis pAxis, const G4VoxelLimits& pVoxelLimit,
+		const G4AffineTransform& pTransform, G4double& pMin, G4double& pMax) const;
+
+	/// \brief return the exact volume of the polyhedron
+	G4double GetCubicVolume()						{ return cubicVolume;};
+	/// \brief return the exact surface area of the polyhedron
+	G4double GetSurfaceArea()						{ return surfaceArea;};
+	/// \brief return a point uniformly distributed on the surface
+	G4ThreeVector GetPointOnSurface() const;
+
+	/// \brief return the number of distinct facet planes
+	size_t GetNumberOfPlanes() const				{ return normals.size();};
+	/// \brief return the number of triangles
+	size_t GetNumberOfTriangles() const				{ return triangles.size();};
+
+	G4GeometryType GetEntityType() const;
+	G4VSolid* Clone() const;
+	std::ostream& StreamInfo(std::ostream& os) const;
+
+	void DescribeYourselfTo(G4VGraphicsScene& scene) const;
+	G4VisExtent GetExtent() const;
+	G4Polyhedron* CreatePolyhedron() const;
+
+protected:
+	/// \brief constructor. Use create to make sure the polyhedron is convex
+	CPOP_ConvexPolyhedron(const G4String& pName, const G4double* pFacets, size_t pNbFacets);
+	/// \brief return true if the triangles bound a closed polyhedron, convex at each edge, with a positive volume
+	bool isConvex() const;
+
+private:
+	typedef Utils::Geometry::Triangle::FlatTriangle<G4double> t_Triangle;
+
+	std::vector<G4ThreeVector> normals;		///< \brief unit outward normal of each plane
+	std::vector<G4double> offsets;			///< \brief plane equation is normals[i].p + offsets[i] = 0, negative inside
+	std::vector<G4ThreeVector> vertices;	///< \brief the distinct vertices of the triangles
+	std::vector<std::array<unsigned int, 3> > triangleVertices;	///< \brief vertex indexes of each triangle
+	std::vector<t_Triangle> triangles;		///< \brief the boundary triangles
+	std::vector<G4double> cumulatedAreas;	///< \brief cumulated area of the triangles, to sample the surface
+	G4ThreeVector minExtent;				///< \brief lower corner of the bounding box
+	G4ThreeVector maxExtent;				///< \brief upper corner of the bounding box
+	G4double cubicVolume;					///< \brief volume of the polyhedron
+	G4double surfaceArea;					///< \brief area of the polyhedron
+	G4double halfTolerance;					///< \brief half of the surface tolerance
+};
+
+#endif // WITH_GEANT_4
+
+#endif // CPOP_CONVEX_POLYHEDRON_HH
@@ -0,0 +1,486 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "CPOP_ConvexPolyhedron.hh"
+
+#ifdef WITH_GEANT_4
+
+#include "G4AffineTransform.hh"
+#include "G4BoundingEnvelope.hh"
+#include "G4PolyhedronArbitrary.hh"
+#include "G4VGraphicsScene.hh"
+#include "G4VisExtent.hh"
+#include "G4VoxelLimits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <array>
+#include <map>
+
+namespace
+{
+	/// \brief a facet plane before merging the coplanar ones
+	struct FacetPlane
+	{
+		G4ThreeVector normal;
+		G4double offset;
+	};
+
+	/// \brief lexicographic order so that (almost) identical planes are consecutive
+	bool planeLess(const FacetPlane& a, const FacetPlane& b)
+	{
+		if(a.normal.x() != b.normal.x())	return a.normal.x() < b.normal.x();
+		if(a.normal.y() != b.normal.y())	return a.normal.y() < b.normal.y();
+		if(a.normal.z() != b.normal.z())	return a.normal.z() < b.normal.z();
+		return a.offset < b.offset;
+	}
+
+	/// \brief maximal difference on the normal components of two merged planes
+	const G4double normalMergingTolerance = 1e-10;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pName The name of the solid
+/// \param pFacets The triangles, 9 coordinates per facet, outward oriented
+/// \param pNbFacets The number of triangles
+//////////////////////////////////////////////////////////////////////////////
+CPOP_ConvexPolyhedron::CPOP_ConvexPolyhedron(const G4String& pName, const G4double* pFacets, size_t pNbFacets):
+	G4VSolid(pName),
+	minExtent(kInfinity, kInfinity, kInfinity),
+	maxExtent(-kInfinity, -kInfinity, -kInfinity),
+	cubicVolume(0.),
+	surfaceArea(0.),
+	halfTolerance(0.5*kCarTolerance)
+{
+	triangleVertices.reserve(pNbFacets);
+	triangles.reserve(pNbFacets);
+	cumulatedAreas.reserve(pNbFacets);
+
+	// shared vertices have exactly the same coordinates
+	std::map<std::array<G4double, 3>, unsigned int> vertexIndexes;
+	auto indexOf = [&](const G4double* pVertex) -> unsigned int
+	{
+		std::array<G4double, 3> key = {{pVertex[0], pVertex[1], pVertex[2]}};
+		std::map<std::array<G4double, 3>, unsigned int>::iterator itVertex = vertexIndexes.find(key);
+		if(itVertex == vertexIndexes.end())
+		{
+			itVertex = vertexIndexes.insert(std::make_pair(key, (unsigned int)vertices.size())).first;
+			vertices.push_back(G4ThreeVector(pVertex[0], pVertex[1], pVertex[2]));
+		}
+		return itVertex->second;
+	};
+
+	std::vector<FacetPlane> planes;
+	planes.reserve(pNbFacets);
+
+	const G4ThreeVector reference = pNbFacets > 0 ? G4ThreeVector(pFacets[0], pFacets[1], pFacets[2]) : G4ThreeVector();
+	for(size_t iFacet = 0; iFacet < pNbFacets; ++iFacet, pFacets += 9)
+	{
+		triangleVertices.push_back({{indexOf(pFacets), indexOf(pFacets + 3), indexOf(pFacets + 6)}});
+		const G4ThreeVector& p0 = vertices[triangleVertices.back()[0]];
+		const G4ThreeVector& p1 = vertices[triangleVertices.back()[1]];
+		const G4ThreeVector& p2 = vertices[triangleVertices.back()[2]];
+		triangles.push_back(Utils::Geometry::Triangle::makeFlatTriangle<G4double>(p0, p1, p2));
+
+		G4ThreeVector cross = (p1 - p0).cross(p2 - p0);
+		G4double doubleArea = cross.mag();
+		surfaceArea += 0.5*doubleArea;
+		cumulatedAreas.push_back(surfaceArea);
+		// signed volume of the tetrahedron (reference, p0, p1, p2)
+		cubicVolume += (p0 - reference).dot((p1 - reference).cross(p2 - reference))/6.;
+
+		// degenerated triangles don't define any plane
+		if(doubleArea > 0.)
+		{
+			FacetPlane plane;
+			plane.normal = cross/doubleArea;
+			plane.offset = -plane.normal.dot(p0);
+			planes.push_back(plane);
+		}
+	}
+
+	for(std::vector<G4ThreeVector>::const_iterator itVertex = vertices.begin(); itVertex != vertices.end(); ++itVertex)
+	{
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			minExtent[axis] = std::min(minExtent[axis], (*itVertex)[axis]);
+			maxExtent[axis] = std::max(maxExtent[axis], (*itVertex)[axis]);
+		}
+	}
+
+	// coplanar triangles (from the same facet of the voronoi cell) end up consecutive once sorted
+	std::sort(planes.begin(), planes.end(), planeLess);
+	normals.reserve(planes.size());
+	offsets.reserve(planes.size());
+	for(std::vector<FacetPlane>::const_iterator itPlane = planes.begin(); itPlane != planes.end(); ++itPlane)
+	{
+		if(!normals.empty() &&
+			std::fabs(normals.back().x() - itPlane->normal.x()) < normalMergingTolerance &&
+			std::fabs(normals.back().y() - itPlane->normal.y()) < normalMergingTolerance &&
+			std::fabs(normals.back().z() - itPlane->normal.z()) < normalMergingTolerance &&
+			std::fabs(offsets.back() - itPlane->offset) < 1e-3*halfTolerance)
+		{
+			continue;
+		}
+		normals.push_back(itPlane->normal);
+		offsets.push_back(itPlane->offset);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+CPOP_ConvexPolyhedron::~CPOP_ConvexPolyhedron()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pName The name of the solid
+/// \param pFacets The triangles, 9 coordinates per facet, outward oriented
+/// \param pNbFacets The number of triangles
+/// \return The solid, NULL if the triangles don't bound a convex polyhedron
+//////////////////////////////////////////////////////////////////////////////
+CPOP_ConvexPolyhedron* CPOP_ConvexPolyhedron::create(const G4String& pName, const G4double* pFacets, size_t pNbFacets)
+{
+	if(pNbFacets < 4)
+	{
+		return NULL;
+	}
+
+	CPOP_ConvexPolyhedron* solid = new CPOP_ConvexPolyhedron(pName, pFacets, pNbFacets);
+	if(!solid->isConvex())
+	{
+		delete solid;
+		return NULL;
+	}
+	return solid;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details the surface must be closed and each edge convex : the vertex
+/// opposite to an edge in the neighbouring triangle must be under the plane of the triangle.
+/// \return true if the triangles bound a convex polyhedron
+//////////////////////////////////////////////////////////////////////////////
+bool CPOP_ConvexPolyhedron::isConvex() const
+{
+	if(normals.size() < 4 || cubicVolume <= 0.)
+	{
+		return false;
+	}
+
+	// each oriented edge must be met once, and its reverse in the neighbouring triangle
+	std::map<std::pair<unsigned int, unsigned int>, size_t> edges;
+	for(size_t iTriangle = 0; iTriangle < triangleVertices.size(); ++iTriangle)
+	{
+		for(int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			std::pair<unsigned int, unsigned int> edge(triangleVertices[iTriangle][iEdge], triangleVertices[iTriangle][(iEdge + 1) % 3]);
+			if(!edges.insert(std::make_pair(edge, iTriangle)).second)
+			{
+				return false;
+			}
+		}
+	}
+
+	for(size_t iTriangle = 0; iTriangle < triangleVertices.size(); ++iTriangle)
+	{
+		const t_Triangle& tri = triangles[iTriangle];
+		G4ThreeVector origin(tri.origin[0], tri.origin[1], tri.origin[2]);
+		G4ThreeVector cross = G4ThreeVector(tri.edge1[0], tri.edge1[1], tri.edge1[2]).cross(G4ThreeVector(tri.edge2[0], tri.edge2[1], tri.edge2[2]));
+		G4double doubleArea = cross.mag();
+
+		for(int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			std::pair<unsigned int, unsigned int> reverse(triangleVertices[iTriangle][(iEdge + 1) % 3], triangleVertices[iTriangle][iEdge]);
+			std::map<std::pair<unsigned int, unsigned int>, size_t>::const_iterator itNeighbour = edges.find(reverse);
+			if(itNeighbour == edges.end())
+			{
+				return false;
+			}
+			if(doubleArea <= 0.)
+			{
+				continue;
+			}
+
+			const std::array<unsigned int, 3>& neighbour = triangleVertices[itNeighbour->second];
+			for(int iVertex = 0; iVertex < 3; ++iVertex)
+			{
+				if((cross/doubleArea).dot(vertices[neighbour[iVertex]] - origin) > halfTolerance)
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param p The point to locate
+/// \return kInside, kSurface (within half the tolerance of a plane) or kOutside
+//////////////////////////////////////////////////////////////////////////////
+EInside CPOP_ConvexPolyhedron::Inside(const G4ThreeVector& p) const
+{
+	G4double maxDist = -kInfinity;
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		G4double dist = normals[iPlane].dot(p) + offsets[iPlane];
+		if(dist > halfTolerance)
+		{
+			return kOutside;
+		}
+		maxDist = std::max(maxDist, dist);
+	}
+	return (maxDist > -halfTolerance) ? kSurface : kInside;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param p The point on the surface
+/// \return The normal of the plane(s) p is on. The one of the nearest plane if none
+//////////////////////////////////////////////////////////////////////////////
+G4ThreeVector CPOP_ConvexPolyhedron::SurfaceNormal(const G4ThreeVector& p) const
+{
+	G4ThreeVector sumNormals;
+	unsigned int nbSurfaces = 0;
+	G4double maxDist = -kInfinity;
+	size_t iNearest = 0;
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		G4double dist = normals[iPlane].dot(p) + offsets[iPlane];
+		if(std::fabs(dist) <= halfTolerance)
+		{
+			sumNormals += normals[iPlane];
+			nbSurfaces++;
+		}
+		if(dist > maxDist)
+		{
+			maxDist = dist;
+			iNearest = iPlane;
+		}
+	}
+
+	if(nbSurfaces == 0)		return normals[iNearest];
+	if(nbSurfaces == 1)		return sumNormals;
+	// edge or vertex
+	return sumNormals.unit();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details the ray enters the last of the entering planes and must do it
+/// before leaving the first of the leaving ones.
+/// \param p The starting point
+/// \param v The unit direction
+/// \return The distance to the solid along v, kInfinity if missed
+//////////////////////////////////////////////////////////////////////////////
+G4double CPOP_ConvexPolyhedron::DistanceToIn(const G4ThreeVector& p, const G4ThreeVector& v) const
+{
+	G4double tIn = -kInfinity;
+	G4double tOut = kInfinity;
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		G4double dist = normals[iPlane].dot(p) + offsets[iPlane];
+		G4double cosa = normals[iPlane].dot(v);
+		if(dist >= -halfTolerance)
+		{
+			// on the outer side of the plane and moving away or parallel
+			if(cosa >= 0.)
+			{
+				return kInfinity;
+			}
+			tIn = std::max(tIn, -dist/cosa);
+		}else if(cosa > 0.)
+		{
+			tOut = std::min(tOut, -dist/cosa);
+		}
+	}
+
+	if(tOut <= tIn + halfTolerance)
+	{
+		return kInfinity;
+	}
+	return (tIn < halfTolerance) ? 0. : tIn;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param p The outside point
+/// \return The largest distance to the planes, which can not exceed the distance to the solid
+//////////////////////////////////////////////////////////////////////////////
+G4double CPOP_ConvexPolyhedron::DistanceToIn(const G4ThreeVector& p) const
+{
+	G4double maxDist = -kInfinity;
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		maxDist = std::max(maxDist, normals[iPlane].dot(p) + offsets[iPlane]);
+	}
+	return (maxDist > 0.) ? maxDist : 0.;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param p The inside point
+/// \param v The unit direction
+/// \param calcNorm True if the exit normal must be computed
+/// \param validNorm Set to true if the solid lies behind the exit surface (always true for convex solids)
+/// \param n The exit normal
+/// \return The distance to the surface along v
+//////////////////////////////////////////////////////////////////////////////
+G4double CPOP_ConvexPolyhedron::DistanceToOut(const G4ThreeVector& p, const G4ThreeVector& v,
+	const G4bool calcNorm, G4bool* validNorm, G4ThreeVector* n) const
+{
+	G4double tOut = kInfinity;
+	size_t iExit = normals.size();
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		G4double cosa = normals[iPlane].dot(v);
+		if(cosa <= 0.)
+		{
+			continue;
+		}
+		G4double dist = normals[iPlane].dot(p) + offsets[iPlane];
+		// on the surface and leaving
+		if(dist >= -halfTolerance)
+		{
+			tOut = 0.;
+			iExit = iPlane;
+			break;
+		}
+		G4double t = -dist/cosa;
+		if(t < tOut)
+		{
+			tOut = t;
+			iExit = iPlane;
+		}
+	}
+
+	if(calcNorm)
+	{
+		*validNorm = (iExit < normals.size());
+		if(*validNorm)
+		{
+			*n = normals[iExit];
+		}
+	}
+	return tOut;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param p The inside point
+/// \return The distance to the nearest plane, which is the distance to the surface for a convex solid
+//////////////////////////////////////////////////////////////////////////////
+G4double CPOP_ConvexPolyhedron::DistanceToOut(const G4ThreeVector& p) const
+{
+	G4double minDist = kInfinity;
+	for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+	{
+		minDist = std::min(minDist, -(normals[iPlane].dot(p) + offsets[iPlane]));
+	}
+	return (minDist > 0.) ? minDist : 0.;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void CPOP_ConvexPolyhedron::BoundingLimits(G4ThreeVector& pMin, G4ThreeVector& pMax) const
+{
+	pMin = minExtent;
+	pMax = maxExtent;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+G4bool CPOP_ConvexPolyhedron::CalculateExtent(const EAxis pAxis, const G4VoxelLimits& pVoxelLimit,
+	const G4AffineTransform& pTransform, G4double& pMin, G4double& pMax) const
+{
+	G4BoundingEnvelope bbox(minExtent, maxExtent);
+	return bbox.CalculateExtent(pAxis, pVoxelLimit, pTransform, pMin, pMax);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \return A point picked on a triangle chosen according to its area
+//////////////////////////////////////////////////////////////////////////////
+G4ThreeVector CPOP_ConvexPolyhedron::GetPointOnSurface() const
+{
+	G4double area = G4UniformRand()*surfaceArea;
+	size_t iTriangle = std::upper_bound(cumulatedAreas.begin(), cumulatedAreas.end(), area) - cumulatedAreas.begin();
+	iTriangle = std::min(iTriangle, triangles.size() - 1);
+
+	G4double spot[3];
+	Utils::Geometry::Triangle::getSpotOnTriangle(triangles[iTriangle], G4UniformRand(), G4UniformRand(), spot);
+	return G4ThreeVector(spot[0], spot[1], spot[2]);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+G4GeometryType CPOP_ConvexPolyhedron::GetEntityType() const
+{
+	return G4String("CPOP_ConvexPolyhedron");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+G4VSolid* CPOP_ConvexPolyhedron::Clone() const
+{
+	return new CPOP_ConvexPolyhedron(*this);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+std::ostream& CPOP_ConvexPolyhedron::StreamInfo(std::ostream& os) const
+{
+	os << "-----------------------------------------------------------\n"
+		<< "    *** Dump for solid - " << GetName() << " ***\n"
+		<< "    ===================================================\n"
+		<< " Solid type: " << GetEntityType() << "\n"
+		<< " Parameters: \n"
+		<< "   number of triangles: " << triangles.size() << "\n"
+		<< "   number of planes: " << normals.size() << "\n"
+		<< "   bounding box: " << minExtent << " " << maxExtent << "\n"
+		<< "-----------------------------------------------------------\n";
+	return os;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void CPOP_ConvexPolyhedron::DescribeYourselfTo(G4VGraphicsScene& scene) const
+{
+	scene.AddSolid(*this);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+G4VisExtent CPOP_ConvexPolyhedron::GetExtent() const
+{
+	return G4VisExtent(minExtent.x(), maxExtent.x(), minExtent.y(), maxExtent.y(), minExtent.z(), maxExtent.z());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+G4Polyhedron* CPOP_ConvexPolyhedron::CreatePolyhedron() const
+{
+	G4PolyhedronArbitrary* polyhedron = new G4PolyhedronArbitrary(vertices.size(), triangleVertices.size());
+	for(std::vector<G4ThreeVector>::const_iterator itVertex = vertices.begin(); itVertex != vertices.end(); ++itVertex)
+	{
+		polyhedron->AddVertex(*itVertex);
+	}
+	for(std::vector<std::array<unsigned int, 3> >::const_iterator itTriangle = triangleVertices.begin(); itTriangle != triangleVertices.end(); ++itTriangle)
+	{
+		// indexes start at 1
+		polyhedron->AddFacet((*itTriangle)[0] + 1, (*itTriangle)[1] + 1, (*itTriangle)[2] + 1);
+	}
+	polyhedron->SetReferences();
+	return polyhedron;
+}
+
+#endif // WITH_GEANT_4
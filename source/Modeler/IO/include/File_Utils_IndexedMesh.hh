@@ -0,0 +1,86 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef FILE_UTILS_INDEXED_MESH_HH
+#define FILE_UTILS_INDEXED_MESH_HH
+
+#include "Mesh3DSettings.hh"
+
+#include <CGAL/IO/Color.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+/// @namespace IO
+//////////////////////////////////////////////////////////////////////////////
+namespace IO
+{
+	using namespace Settings::Geometry;
+	using namespace Settings::Geometry::Mesh3D;
+
+	//////////////////////////////////////////////////////////////////////////////
+	/// \brief a triangle soup with shared vertices, built to export large meshes.
+	/// \details vertices closer than the welding tolerance are merged (exact match if
+	/// the tolerance is 0) using a hash grid, so adding a vertex is O(1).
+	/// Facets becoming degenerated by the welding are dropped.
+	//////////////////////////////////////////////////////////////////////////////
+	class IndexedMesh
+	{
+	public:
+		/// \brief constructor
+		IndexedMesh(double pWeldingTolerance = 0.);
+
+		/// \brief add a vertex and return its index, the one of an existing vertex if welded
+		uint32_t addVertex(const Point_3&);
+		/// \brief add a triangular facet
+		void addFacet(uint32_t, uint32_t, uint32_t, CGAL::IO::Color);
+		/// \brief add all the facets of a polyhedron (triangulated as a fan if needed)
+		void addPolyhedron(const Polyhedron_3&, CGAL::IO::Color);
+
+		/// \brief return the number of vertices
+		size_t getNbVertices() const				{ return vertices.size() / 3;};
+		/// \brief return the number of facets
+		size_t getNbFacets() const					{ return facets.size() / 3;};
+
+		/// \brief write the mesh to an ASCII .off file
+		bool writeOff(const std::string& pPath) const;
+		/// \brief write the mesh to a binary little endian .ply file
+		bool writeBinaryPly(const std::string& pPath) const;
+
+	private:
+		/// \brief key of a cell of the hash grid
+		struct GridKey
+		{
+			int64_t x, y, z;
+			bool operator==(const GridKey& o) const	{ return x == o.x && y == o.y && z == o.z; }
+		};
+		/// \brief hash of a grid key
+		struct GridKeyHash
+		{
+			size_t operator()(const GridKey& k) const;
+		};
+
+		/// \brief return the grid cell containing the point, shifted by the given offsets
+		GridKey getKey(const double pPoint[3], int dx = 0, int dy = 0, int dz = 0) const;
+		/// \brief return the index of a vertex matching the point on the given cell, -1 if none
+		int64_t findVertex(const GridKey&, const double pPoint[3]) const;
+
+	private:
+		double tolerance;											///< \brief welding tolerance
+		std::vector<double> vertices;								///< \brief x, y, z of each vertex
+		std::vector<uint32_t> facets;								///< \brief the three vertex indexes of each facet
+		std::vector<unsigned char> colors;							///< \brief red, green, blue of each facet
+		std::unordered_map<GridKey, uint32_t, GridKeyHash> grid;	///< \brief first vertex of each grid cell
+		std::vector<int64_t> nextInCell;							///< \brief next vertex on the same grid cell, -1 if last
+	};
+}
+
+#endif // FILE_UTILS_INDEXED_MESH_HH
@@ -0,0 +1,282 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "File_Utils_IndexedMesh.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+/// \brief size of the output buffer, flushed to the file when full
+static const size_t outputBufferSize = 1 << 20;
+
+namespace IO
+{
+	////////////////////////////////////////////////////////////////////////////////
+	/// \param pWeldingTolerance Vertices closer than this distance are merged. 0 for exact match only
+	////////////////////////////////////////////////////////////////////////////////
+	IndexedMesh::IndexedMesh(double pWeldingTolerance):
+		tolerance(std::max(0., pWeldingTolerance))
+	{
+
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///
+	////////////////////////////////////////////////////////////////////////////////
+	size_t IndexedMesh::GridKeyHash::operator()(const GridKey& k) const
+	{
+		uint64_t h = static_cast<uint64_t>(k.x) * 0x9E3779B97F4A7C15ULL;
+		h ^= static_cast<uint64_t>(k.y) + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+		h ^= static_cast<uint64_t>(k.z) + 0x94D049BB133111EBULL + (h << 6) + (h >> 2);
+		return static_cast<size_t>(h);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \details with a null tolerance the key is the exact coordinates
+	////////////////////////////////////////////////////////////////////////////////
+	IndexedMesh::GridKey IndexedMesh::getKey(const double pPoint[3], int dx, int dy, int dz) const
+	{
+		GridKey key;
+		if(tolerance == 0.)
+		{
+			// + 0. so -0. and 0. share the same bits
+			double x = pPoint[0] + 0., y = pPoint[1] + 0., z = pPoint[2] + 0.;
+			memcpy(&key.x, &x, sizeof(double));
+			memcpy(&key.y, &y, sizeof(double));
+			memcpy(&key.z, &z, sizeof(double));
+			return key;
+		}
+		key.x = static_cast<int64_t>(std::floor(pPoint[0] / tolerance)) + dx;
+		key.y = static_cast<int64_t>(std::floor(pPoint[1] / tolerance)) + dy;
+		key.z = static_cast<int64_t>(std::floor(pPoint[2] / tolerance)) + dz;
+		return key;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	///
+	////////////////////////////////////////////////////////////////////////////////
+	int64_t IndexedMesh::findVertex(const GridKey& pKey, const double pPoint[3]) const
+	{
+		std::unordered_map<GridKey, uint32_t, GridKeyHash>::const_iterator itCell = grid.find(pKey);
+		if(itCell == grid.end())
+		{
+			return -1;
+		}
+		const double squaredTolerance = tolerance * tolerance;
+		for(int64_t iVertex = itCell->second; iVertex >= 0; iVertex = nextInCell[iVertex])
+		{
+			const double* vertex = &vertices[3*iVertex];
+			double dx = vertex[0] - pPoint[0], dy = vertex[1] - pPoint[1], dz = vertex[2] - pPoint[2];
+			if((dx*dx + dy*dy + dz*dz) <= squaredTolerance)
+			{
+				return iVertex;
+			}
+		}
+		return -1;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \param pPoint The vertex to add
+	/// \return The index of the vertex
+	////////////////////////////////////////////////////////////////////////////////
+	uint32_t IndexedMesh::addVertex(const Point_3& pPoint)
+	{
+		const double point[3] = {pPoint.x(), pPoint.y(), pPoint.z()};
+		GridKey key = getKey(point);
+
+		// look for a vertex to weld with. The tolerance being the grid step, only neighbour cells can contain one
+		if(tolerance == 0.)
+		{
+			int64_t existing = findVertex(key, point);
+			if(existing >= 0)
+			{
+				return static_cast<uint32_t>(existing);
+			}
+		}else
+		{
+			for(int dx = -1; dx <= 1; ++dx)
+			{
+				for(int dy = -1; dy <= 1; ++dy)
+				{
+					for(int dz = -1; dz <= 1; ++dz)
+					{
+						int64_t existing = findVertex(getKey(point, dx, dy, dz), point);
+						if(existing >= 0)
+						{
+							return static_cast<uint32_t>(existing);
+						}
+					}
+				}
+			}
+		}
+
+		uint32_t index = static_cast<uint32_t>(getNbVertices());
+		vertices.insert(vertices.end(), point, point + 3);
+		std::pair<std::unordered_map<GridKey, uint32_t, GridKeyHash>::iterator, bool> inserted = grid.insert(std::make_pair(key, index));
+		if(inserted.second)
+		{
+			nextInCell.push_back(-1);
+		}else
+		{
+			nextInCell.push_back(inserted.first->second);
+			inserted.first->second = index;
+		}
+		return index;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \param v1 index of the first vertex
+	/// \param v2 index of the second vertex
+	/// \param v3 index of the third vertex
+	/// \param pColor The color of the facet
+	////////////////////////////////////////////////////////////////////////////////
+	void IndexedMesh::addFacet(uint32_t v1, uint32_t v2, uint32_t v3, CGAL::IO::Color pColor)
+	{
+		if(v1 == v2 || v2 == v3 || v3 == v1)
+		{
+			return;
+		}
+		facets.push_back(v1);
+		facets.push_back(v2);
+		facets.push_back(v3);
+		colors.push_back(pColor.red());
+		colors.push_back(pColor.green());
+		colors.push_back(pColor.blue());
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \param pPoly The polyhedron to add
+	/// \param pColor The color of the polyhedron facets
+	////////////////////////////////////////////////////////////////////////////////
+	void IndexedMesh::addPolyhedron(const Polyhedron_3& pPoly, CGAL::IO::Color pColor)
+	{
+		Polyhedron_3::Facet_const_iterator itFacet;
+		for(itFacet = pPoly.facets_begin(); itFacet != pPoly.facets_end(); ++itFacet)
+		{
+			Polyhedron_3::Halfedge_around_facet_const_circulator itHalfedge = itFacet->facet_begin();
+			uint32_t first = addVertex(itHalfedge->vertex()->point());
+			++itHalfedge;
+			uint32_t previous = addVertex(itHalfedge->vertex()->point());
+			for(++itHalfedge; itHalfedge != itFacet->facet_begin(); ++itHalfedge)
+			{
+				uint32_t current = addVertex(itHalfedge->vertex()->point());
+				addFacet(first, previous, current, pColor);
+				previous = current;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \details same layout as the one produced by IO::OFF : colored facets, header comment.
+	/// \param pPath The path of the .off file
+	/// \return true if success
+	////////////////////////////////////////////////////////////////////////////////
+	bool IndexedMesh::writeOff(const std::string& pPath) const
+	{
+		std::ofstream out(pPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!out)
+		{
+			return false;
+		}
+
+		std::string buffer;
+		buffer.reserve(outputBufferSize + 256);
+		char line[256];
+		auto append = [&](int pLength)
+		{
+			buffer.append(line, pLength);
+			if(buffer.size() >= outputBufferSize)
+			{
+				out.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		};
+
+		append(snprintf(line, sizeof(line), "OFF\n# cells meshes from cpop\n%lu %lu 0\n",
+			static_cast<unsigned long>(getNbVertices()), static_cast<unsigned long>(getNbFacets())));
+		for(size_t iVertex = 0; iVertex < getNbVertices(); ++iVertex)
+		{
+			const double* vertex = &vertices[3*iVertex];
+			append(snprintf(line, sizeof(line), "%g %g %g\n", vertex[0], vertex[1], vertex[2]));
+		}
+		append(snprintf(line, sizeof(line), "\n"));
+		for(size_t iFacet = 0; iFacet < getNbFacets(); ++iFacet)
+		{
+			const uint32_t* facet = &facets[3*iFacet];
+			const unsigned char* color = &colors[3*iFacet];
+			append(snprintf(line, sizeof(line), "3 %u %u %u %u %u %u\n", facet[0], facet[1], facet[2], color[0], color[1], color[2]));
+		}
+		out.write(buffer.data(), buffer.size());
+		return static_cast<bool>(out);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// \details vertices are stored as double, facets as a list of uint32 indexes with a color.
+	/// \param pPath The path of the .ply file
+	/// \return true if success
+	////////////////////////////////////////////////////////////////////////////////
+	bool IndexedMesh::writeBinaryPly(const std::string& pPath) const
+	{
+		// the data are written as is : only valid on little endian machines
+		const uint16_t endiannessCheck = 1;
+		if(*reinterpret_cast<const unsigned char*>(&endiannessCheck) != 1)
+		{
+			return false;
+		}
+
+		std::ofstream out(pPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!out)
+		{
+			return false;
+		}
+		out << "ply\n"
+			<< "format binary_little_endian 1.0\n"
+			<< "comment cells meshes from cpop\n"
+			<< "element vertex " << getNbVertices() << "\n"
+			<< "property double x\n"
+			<< "property double y\n"
+			<< "property double z\n"
+			<< "element face " << getNbFacets() << "\n"
+			<< "property list uchar uint vertex_indices\n"
+			<< "property uchar red\n"
+			<< "property uchar green\n"
+			<< "property uchar blue\n"
+			<< "end_header\n";
+
+		if(!vertices.empty())
+		{
+			out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(double));
+		}
+
+		// one record per facet : 1 + 3*4 + 3 bytes
+		const size_t recordSize = 1 + 3*sizeof(uint32_t) + 3;
+		std::vector<char> buffer;
+		buffer.reserve(outputBufferSize + recordSize);
+		for(size_t iFacet = 0; iFacet < getNbFacets(); ++iFacet)
+		{
+			char record[recordSize];
+			record[0] = 3;
+			memcpy(record + 1, &facets[3*iFacet], 3*sizeof(uint32_t));
+			memcpy(record + 1 + 3*sizeof(uint32_t), &colors[3*iFacet], 3);
+			buffer.insert(buffer.end(), record, record + recordSize);
+			if(buffer.size() >= outputBufferSize)
+			{
+				out.write(buffer.data(), buffer.size());
+				buffer.clear();
+			}
+		}
+		if(!buffer.empty())
+		{
+			out.write(buffer.data(), buffer.size());
+		}
+		return static_cast<bool>(out);
+	}
+}
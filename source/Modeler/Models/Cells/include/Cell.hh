@@ -93,6 +93,8 @@ public:
 	void addForce( Force_t* pForce)						{assert(pForce); forces.push_back(pForce);};
 	/// \brief remove and delete all forces registred
 	void removeAndDeleteForces();
+	/// \brief return the potential energy of the forces applied by the cell
+	virtual Kernel getPotentialEnergy() const;
 
 	/// \brief reset the mesh
 	virtual void resetMesh() = 0;
@@ -244,6 +246,21 @@ void Cell<Kernel, Point, Vector>::writeNuclei(QXmlStreamWriter& writer) const
 	writer.writeEndElement(); 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \return the sum of the potential energy of each force
+////////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+Kernel Cell<Kernel, Point, Vector>::getPotentialEnergy() const
+{
+	Kernel energy = Kernel();
+	typename std::vector<Force<Kernel, Point, Vector>* >::const_iterator itForce;
+	for(itForce = forces.begin(); itForce != forces.end(); ++itForce)
+	{
+		energy += (*itForce)->computeEnergy();
+	}
+	return energy;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief  the running process called at each step by
 /// the simulation manager.
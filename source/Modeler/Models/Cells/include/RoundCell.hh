@@ -36,6 +36,8 @@ public:
 
 	/// \brief origin point of the cell getter
 	inline Point getOrigin()	const		{ return Spatialable<Kernel, Point, Vector>::getPosition(); };
+	/// \brief return the volume shared with the round neighbours
+	virtual Kernel getOverlapVolume() const;
 
 	/// \brief print cell information (used also to save the cell on a .txt file)
 	virtual void writeAttributes(QXmlStreamWriter& writer) const;
@@ -118,6 +120,57 @@ void RoundCell<Kernel, Point, Vector>::setRadius(Kernel pRadius)
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////
+//			getOverlapVolume
+/// \details Cells are considered as balls of their radius (discs in 2D) and each cell
+/// of a pair counts half of the intersection.
+/// \return the volume (area in 2D) shared with the round neighbours
+////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Kernel, typename Point, typename Vector>
+Kernel RoundCell<Kernel, Point, Vector>::getOverlapVolume() const
+{
+	std::set<const SpatialableAgent<Kernel, Point, Vector>* > neighbours = SpatialDataStructureManager::getInstance()->getNeighbours(this);
+	bool lIs2D = (Cell<Kernel, Point, Vector>::getDimension() == _2D);
+	Kernel r1 = getRadius();
+	Kernel overlap = Kernel();
+
+	typename std::set<const SpatialableAgent<Kernel, Point, Vector>* >::const_iterator itNeighbour;
+	for(itNeighbour = neighbours.begin(); itNeighbour != neighbours.end(); ++itNeighbour)
+	{
+		const Round_Shape<Kernel, Point, Vector>* lShape = dynamic_cast<const Round_Shape<Kernel, Point, Vector>*> ((*itNeighbour)->getBody());
+		if(!lShape)
+		{
+			continue;
+		}
+		Kernel r2 = lShape->getRadius();
+		Kernel d = sqrt(((*itNeighbour)->getPosition() - getOrigin()).squared_length());
+		if(d >= r1 + r2)
+		{
+			continue;
+		}
+
+		Kernel lIntersection;
+		if(d <= fabs(r1 - r2))
+		{
+			// the smallest one is inside the other
+			Kernel rMin = std::min(r1, r2);
+			lIntersection = lIs2D ? M_PI * rMin * rMin : 4. / 3. * M_PI * rMin * rMin * rMin;
+		}else if(lIs2D)
+		{
+			// lens area
+			lIntersection = r1 * r1 * acos((d * d + r1 * r1 - r2 * r2) / (2. * d * r1))
+				+ r2 * r2 * acos((d * d + r2 * r2 - r1 * r1) / (2. * d * r2))
+				- 0.5 * sqrt((-d + r1 + r2) * (d + r1 - r2) * (d - r1 + r2) * (d + r1 + r2));
+		}else
+		{
+			// lens volume
+			lIntersection = M_PI * (r1 + r2 - d) * (r1 + r2 - d) * (d * d + 2. * d * (r1 + r2) - 3. * (r1 - r2) * (r1 - r2)) / (12. * d);
+		}
+		overlap += 0.5 * lIntersection;
+	}
+	return overlap;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
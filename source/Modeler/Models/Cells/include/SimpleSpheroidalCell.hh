@@ -30,7 +30,7 @@ public:
 	/// \brief set the position of the nucleus according to his type of nucleus position
 	void setNucleusCenter();	
 	/// \brief will generate the nucleus shape
-	virtual void generateNuclei(std::vector<Plane_3*>);
+	virtual void generateNuclei(const std::vector<Plane_3>&);
 	/// \brief return true if nuclei radius are coherent
 	virtual bool checkNucleiRadius() const 			{ return nucleus->getRadius() > 0;};	
 	/// \brief return the cell description
@@ -39,8 +39,6 @@ public:
 	// virtual Point_3 getSpotOnCytoplasm() const;
 	/// \brief return the round nucleus
 	RoundNucleus<double, Point_3, Vector_3>* getNucleus() const { return nucleus;}
-	/// \brief return a random point inside the cytoplasm, avoiding membrane and nucleus
-	virtual Point_3 getSpotOnCytoplasm() const;
 	
 protected:
 	/// \brief max rattio getter
@@ -14,8 +14,16 @@ See LICENSE.md for further details
 #include "CellSettings.hh"
 #include "Mesh3DSettings.hh"
 #include "MeshOutFormats.hh"
+#include "AliasTable.hh"
+#include "Geometry_Utils_Triangle.hh"
 
+#include <atomic>
 #include<map>
+#include <mutex>
+
+#if defined(WITH_GEANT_4) || defined(WITH_GDML_EXPORT)
+class G4TessellatedSolid;
+#endif
 
 using namespace Settings::Geometry;
 using namespace Settings::Geometry::Mesh3D;
@@ -45,6 +53,8 @@ public:
 	shapePtIt shape_points_end()				{ return shape->points_end(); };
 	/// \brief shape getter
 	Mesh3D::Polyhedron_3* getShape()			{ return shape; };
+	/// \brief shape getter
+	const Mesh3D::Polyhedron_3* getShape() const	{ return shape; };
 	
 	/// \brief shape facet begin getter 
 	shapeFacetIt shape_facets_begin()			{ return shape->facets_begin(); };
@@ -61,7 +71,7 @@ public:
 	/// \brief return true if the point is inside the cell
 	virtual bool hasIn(Point_3) const;
 	/// \brief will generate the nucleus shape
-	virtual void generateNuclei(vector<Plane_3*>) = 0;	
+	virtual void generateNuclei(const vector<Plane_3>&) = 0;	
 
 	/// \brief return the position of the nucleus according to his type of nucleus position
 	virtual Point_3 getNucleusCenter(eNucleusPosType nucleusPositionType) const = 0;
@@ -84,8 +94,21 @@ public:
 	double getNucleiMeshesSumVolume(MeshOutFormats::outputFormat meshType) const;
 	/// \brief return the surface represented by the mesh
 	double getMembraneMeshSurfaceArea() const 						{ return sumMembraneMeshArea;}
-	/// \brief compute the mesh surface
+	/// \brief compute the mesh surface. Tables used to pick spots are rebuilt on the next request
 	void computeMembraneSurfaceArea();
+
+	/// \brief statistics about the spots picked on the cytoplasm
+	struct CytoplasmSamplingStats
+	{
+		unsigned long nbCandidates;		///< \brief number of points picked inside the cell
+		unsigned long nbAccepted;		///< \brief number of points returned (not inside a nucleus)
+		unsigned long nbFallbacks;		///< \brief number of requests that reached the maximal number of try
+
+		/// \brief return the ratio of candidates which where not inside a nucleus
+		double getAcceptanceRate() const { return nbCandidates > 0 ? double(nbAccepted) / double(nbCandidates) : 0.; }
+	};
+	/// \brief return the cytoplasm sampling statistics since the last mesh update
+	CytoplasmSamplingStats getCytoplasmSamplingStats() const;
 	/// \brief return true if the cell own a mesh
 	virtual bool hasMesh() const ;
 
@@ -95,8 +118,16 @@ public:
 	virtual bool isIn(const BoundingBox<Point_3>*) const;	
 
 #if defined(WITH_GEANT_4) || defined(WITH_GDML_EXPORT)
+	/// \brief return the number of facets of the membrane mesh
+	size_t getNbMembraneFacets() const					{ return shape->size_of_facets();};
+	/// \brief write the membrane facets to pFacets (9 coordinates per facet, outward oriented). Thread safe
+	void writeMembraneFacets(G4double* pFacets, G4double pConvertToG4) const;
 	/// \brief convert the membrane shape to a G4 entity
-	virtual G4LogicalVolume* convertMembraneToG4(QString);
+	virtual G4LogicalVolume* convertMembraneToG4(QString, bool pConvexSolid = false);
+	/// \brief convert the membrane facets written by writeMembraneFacets to a G4 entity
+	G4LogicalVolume* convertMembraneFacetsToG4(QString, const G4double* pFacets, size_t pNbFacets, bool pConvexSolid = false);
+	/// \brief build the G4TessellatedSolid of the membrane facets written by writeMembraneFacets
+	G4TessellatedSolid* convertMembraneFacetsToG4TessellatedSolid(QString, const G4double* pFacets, size_t pNbFacets) const;
 	/// \brief convert the cell geometries (including nuclei) to G4 geometries
 	virtual G4PVPlacement* convertToG4Structure(
 			G4LogicalVolume* pMother, 
@@ -107,19 +138,45 @@ public:
 			double pDeltaWin,
 			map<const G4LogicalVolume*, const t_Cell_3* >* pCellMap = NULL,	
 			map<const G4LogicalVolume*, const t_Nucleus_3*>* pNucleiMap = NULL,
-			bool pExportNuclei = true);
+			bool pExportNuclei = true,
+			const G4double* pMembraneFacets = NULL,
+			size_t pNbMembraneFacets = 0,
+			bool pConvexSolid = false);
 #endif
 
 protected:
 	/// \brief The polyhedron representing the cell boundaries.
 	Mesh3D::Polyhedron_3* shape;	
 
-	/// \brief link sum of facet areas to facet
-	/// used to obtain uniform spot on facet. 
-	map<double, Triangle_3> areasToFacet;
-
 	double sumMembraneMeshArea;	///< \brief the membrane mesh surface ( sum of all facet surfaces )
 
+	/// \brief the membrane facets, stored contiguously. Used to obtain uniform spot on the membrane.
+	mutable vector<Utils::Geometry::Triangle::FlatTriangle<double> > membraneFacets;
+	/// \brief alias table on the membraneFacets areas
+	mutable Utils::Statistics::AliasTable membraneFacetsTable;
+	/// \brief the cell polytope split in tetrahedra (fan from the mesh vertices centroid).
+	/// used to obtain uniform spot inside the cell.
+	mutable vector<Tetrahedron_3> cellTetrahedra;
+	/// \brief alias table on the cellTetrahedra volumes
+	mutable Utils::Statistics::AliasTable cellTetrahedraTable;
+	/// \brief true when the sampling tables match the current mesh
+	mutable std::atomic<bool> samplingTablesReady;
+	/// \brief protect the lazy construction of the sampling tables
+	mutable std::mutex samplingTablesMutex;
+
+	mutable std::atomic<unsigned long> nbCytoplasmCandidates;	///< \brief number of points picked inside the cell for the cytoplasm
+	mutable std::atomic<unsigned long> nbCytoplasmAccepted;		///< \brief number of points picked on the cytoplasm
+	mutable std::atomic<unsigned long> nbCytoplasmFallbacks;	///< \brief number of cytoplasm requests which failed to avoid nuclei
+
+	/// \brief build the sampling tables if the mesh changed since the last call
+	void ensureSamplingTables() const;
+
+private:
+	/// \brief build the membrane facets table
+	void computeMembraneFacets() const;
+	/// \brief split the cell polytope in tetrahedra
+	void computeCellTetrahedra() const;
+
 };
 
 #endif // SPHEROIDAL_CELL_STRUCTURE_HH
\ No newline at end of file
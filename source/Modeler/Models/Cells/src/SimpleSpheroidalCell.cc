@@ -85,7 +85,7 @@ void SimpleSpheroidalCell::setNucleusCenter()
 //////////////////////////////////////////////////////////////////////////////////////////////////////
 /// \param intersections The plane defining the boundary
 //////////////////////////////////////////////////////////////////////////////////////////////////////
-void SimpleSpheroidalCell::generateNuclei(std::vector<Plane_3*> intersections)
+void SimpleSpheroidalCell::generateNuclei(const std::vector<Plane_3>& intersections)
 {
 	assert(getRadius() > 0.);
 	assert(nucleus->getRadius() > 0.);
@@ -98,10 +98,9 @@ void SimpleSpheroidalCell::generateNuclei(std::vector<Plane_3*> intersections)
 	double optimalRadius = nucleus->getRadius();	// the one requested
 
 	// if intersections
-	for(std::vector<Plane_3*>::const_iterator itPlane = intersections.begin(); itPlane != intersections.end(); ++itPlane)
+	for(std::vector<Plane_3>::const_iterator itPlane = intersections.begin(); itPlane != intersections.end(); ++itPlane)
 	{
-		assert(*itPlane);
-		double localRadius = sqrt( squared_distance((*itPlane)->projection(nucleus->getOrigin()), nucleus->getOrigin()) );
+		double localRadius = sqrt( squared_distance(itPlane->projection(nucleus->getOrigin()), nucleus->getOrigin()) );
 		if(localRadius < optimalRadius)
 		{
 			optimalRadius = localRadius;
@@ -130,41 +129,3 @@ void SimpleSpheroidalCell::resetMesh()
 	/// nothing to do for the nucleus mesh
 }
 
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \return The random spot requested on the cytoplasm
-/// \details here we optimize the function because we have only one nucleus and we can speed up this process.
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////
-Point_3 SimpleSpheroidalCell::getSpotOnCytoplasm() const
-{
-	//G4cout<< "\n\n\n getSpotOnCytoplasm" << G4endl;
-
-	// // pick a point on the membrane, then pick a point on the segment [MembranePoint/cellOrigin] Until we found one not on the nucleus
-	// // because shape is convex we are sure the picked point is on the cytoplsam (work until no other organ are defined)
-	// Point_3 cellMembraneSpot = getSpotOnCellMembrane();
-	// // as we are on a simple cell ( one nucleus, one cytoplasm ) we are sure that the resting space is empty.
-	// // in this case nucleus is a perfect sphere
-	// Point_3 projectedPtOnNucleus = Utils::Geometry::Sphere::getProjectionOnSphere(cellMembraneSpot, getNucleus()->getRadius(), getNucleus()->getOrigin());
-	//
-	// Vector_3 v( cellMembraneSpot - projectedPtOnNucleus);
-	// double x = RandomEngineManager::getInstance()->randd(0., 1.);
-	// Point_3 res = getPosition() + x*(v);
-	//
-	// return res;
-
-
-	Vector_3 v( getSpotOnCellMembrane() - getPosition());
-	double x = RandomEngineManager::getInstance()->randd(0., 1.);
-	Point_3 res = getPosition() + x*(v);
-
-	std::vector<Nucleus<double, Point_3, Vector_3> *>::const_iterator itNuc;
-	for(itNuc = nuclei.begin(); itNuc != nuclei.end(); ++itNuc)
-	{
-		// if point is on a nucleus, pick an other one
-		if((*itNuc)->hasIn(res))
-		{
-			return getSpotOnCytoplasm();
-		}
-	}
-	return res;
-
-}
@@ -30,6 +30,8 @@ See LICENSE.md for further details
 #include "analysis.hh"
 #include "RunAction.hh"
 
+#include <cmath>
+#include <stdexcept>
 #include <string>
 #include <fstream>
 
@@ -41,6 +43,7 @@ See LICENSE.md for further details
 	#include "UnitSystemManager.hh"
 	#include "Voronoi3DCellMeshSubThread.hh"
 #ifdef WITH_GEANT_4
+	#include "CPOP_ConvexPolyhedron.hh"
 	#include "G4TriangularFacet.hh"
 	#include "G4Orb.hh"
 	#include "G4TessellatedSolid.hh"
@@ -53,6 +56,7 @@ See LICENSE.md for further details
 
 static const int maxTry = 7;	// The maximal number of iteration we are ready to made to made to remove overlaps
 static const double stepSizeReductionPercent = 2.;	// at each iteration will reduce the size of cell each of stepSizeReductionPercent
+static const unsigned int maxCytoplasmSpotTry = 1000;	// The maximal number of points picked inside the cell to find one outside nuclei
 
 #include <iostream>
 
@@ -69,7 +73,12 @@ static const double stepSizeReductionPercent = 2.;	// at each iteration will red
 /// \param pMembraneShape the initial membrane mesh
 ///////////////////////////////////////////////////////////////////////////////
 SpheroidalCell::SpheroidalCell(const CellProperties* pCellProperties, Point_3 pOrigin, double pSpheroidRadius, double pWeight, Mesh3D::Polyhedron_3 pMembraneShape):
-	RoundCell<double, Point_3, Vector_3>(pCellProperties, pOrigin, pSpheroidRadius, pWeight)
+	RoundCell<double, Point_3, Vector_3>(pCellProperties, pOrigin, pSpheroidRadius, pWeight),
+	sumMembraneMeshArea(0.),
+	samplingTablesReady(false),
+	nbCytoplasmCandidates(0),
+	nbCytoplasmAccepted(0),
+	nbCytoplasmFallbacks(0)
 {
 	shape = new Mesh3D::Polyhedron_3(pMembraneShape);
 }
@@ -113,7 +122,14 @@ double SpheroidalCell::getCytoplasmVolume() const
 ///////////////////////////////////////////////////////////////////////////////////////////
 void SpheroidalCell::resetMesh()
 {
-	areasToFacet.clear();
+	{
+		std::lock_guard<std::mutex> lock(samplingTablesMutex);
+		samplingTablesReady = false;
+		membraneFacets.clear();
+		membraneFacetsTable.clear();
+		cellTetrahedra.clear();
+		cellTetrahedraTable.clear();
+	}
 	delete shape;
 	shape = new Mesh3D::Polyhedron_3();
 }
@@ -166,41 +182,80 @@ Point_3 SpheroidalCell::getSpotOnCellMembrane() const
 		// ==> fail because we pick a random point on a box ==> more density on the center of intersection planes
 
 		// third version : give a weight depending on triangle area.
-		// go throught all facet until surface area is reach
-		double areaToReach = RandomEngineManager::getInstance()->randd(0., sumMembraneMeshArea);
-		map<double, Triangle_3>::const_iterator itAreaFacet = areasToFacet.lower_bound(areaToReach);
+		// go throught all facet until surface area is reach (map<double, Triangle_3> lower_bound)
+		// ==> correct but walk a tree of CGAL triangles for each spot
+
+		// fourth version : same weights, the facet is picked in O(1) from an alias table
+		// over contiguous plain facets
+		ensureSamplingTables();
+		if(membraneFacetsTable.empty())
+		{
+			QString mess = "Null membrane area, unable to compute a spot on the membrane";
+			InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, mess.toStdString(), "SpheroidalCell");
+			return Point_3(0., 0., 0.);
+		}
 
-		assert(itAreaFacet != areasToFacet.end());
-		const Triangle_3* lTri = &itAreaFacet->second;
-		assert(lTri);
-		return (Utils::myCGAL::getSpotOnTriangle(lTri));
+		RandomEngineManager* rndManager = RandomEngineManager::getInstance();
+		size_t iFacet = membraneFacetsTable.sample(rndManager->randd(0., 1.));
+		double u = rndManager->randd(0., 1.);
+		double v = rndManager->randd(0., 1.);
+		double spot[3];
+		Utils::Geometry::Triangle::getSpotOnTriangle(membraneFacets[iFacet], u, v, spot);
+		return Point_3(spot[0], spot[1], spot[2]);
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 /// \return A random spot requested on the cytoplasm
+/// \details the point is picked uniformly inside the cell polytope from its tetrahedral
+/// decomposition : a tetrahedron is picked according to its volume then a point inside it.
+/// Points falling into a nucleus are picked again, at most maxCytoplasmSpotTry times.
+/// If all of them fail (nuclei filling the cell) a spot on the membrane is returned.
 ///////////////////////////////////////////////////////////////////////////////////////////
 Point_3 SpheroidalCell::getSpotOnCytoplasm() const
 {
-	// pick a point on the membrane, then pick a point on the segment [MembranePoint/cellOrigin] Until we found one not on the nucleus
-	// because shape is convex we are sure the picked point is on the cytoplasm (work until no other organ are defined)
+	ensureSamplingTables();
+	if(cellTetrahedraTable.empty())
+	{
+		QString mess = "Unvalid shape, unable to compute a spot on the cytoplasm";
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, mess.toStdString(), "SpheroidalCell");
+		return Point_3(0., 0., 0.);
+	}
 
-  //G4cout<< "\n\n\n getSpotOnCytoplasm" << G4endl;
+	for(unsigned int iTry = 0; iTry < maxCytoplasmSpotTry; ++iTry)
+	{
+		size_t iTet = cellTetrahedraTable.sample(RandomEngineManager::getInstance()->randd(0., 1.));
+		Point_3 res = Utils::myCGAL::getSpotInTetrahedron(&cellTetrahedra[iTet]);
+		nbCytoplasmCandidates.fetch_add(1, std::memory_order_relaxed);
 
-	Vector_3 v( getSpotOnCellMembrane() - getPosition());
-	double x = RandomEngineManager::getInstance()->randd(0., 1.);
-	Point_3 res = getPosition() + x*(v);
+		bool inNucleus = false;
+		std::vector<Nucleus<double, Point_3, Vector_3> *>::const_iterator itNuc;
+		for(itNuc = nuclei.begin(); itNuc != nuclei.end() && !inNucleus; ++itNuc)
+		{
+			inNucleus = (*itNuc)->hasIn(res);
+		}
 
-	std::vector<Nucleus<double, Point_3, Vector_3> *>::const_iterator itNuc;
-	for(itNuc = nuclei.begin(); itNuc != nuclei.end(); ++itNuc)
-	{
-		// if point is on a nucleus, pick an other one
-		if((*itNuc)->hasIn(res))
+		if(!inNucleus)
 		{
-			return getSpotOnCytoplasm();
+			nbCytoplasmAccepted.fetch_add(1, std::memory_order_relaxed);
+			return res;
 		}
 	}
-	return res;
+
+	nbCytoplasmFallbacks.fetch_add(1, std::memory_order_relaxed);
+	return getSpotOnCellMembrane();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// \return the number of points picked, accepted and the number of fallbacks on the membrane
+///////////////////////////////////////////////////////////////////////////////////////////
+SpheroidalCell::CytoplasmSamplingStats SpheroidalCell::getCytoplasmSamplingStats() const
+{
+	CytoplasmSamplingStats stats;
+	stats.nbCandidates 	= nbCytoplasmCandidates.load(std::memory_order_relaxed);
+	stats.nbAccepted 	= nbCytoplasmAccepted.load(std::memory_order_relaxed);
+	stats.nbFallbacks 	= nbCytoplasmFallbacks.load(std::memory_order_relaxed);
+	return stats;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
@@ -295,6 +350,13 @@ QString SpheroidalCell::getMeshStats(MeshOutFormats::outputFormat meshFormat) co
 			+ ", " 						+ QString::number( getPosition().y() )
 			+ ", "						+ QString::number( getPosition().z() )	+ "\n";
 	res += " approximated_volume : "	+ QString::number(getMeshVolume(meshFormat)) 			+ "\n";
+	CytoplasmSamplingStats samplingStats = getCytoplasmSamplingStats();
+	if(samplingStats.nbCandidates > 0)
+	{
+		res += " cytoplasm_sampling_acceptance : " + QString::number(samplingStats.getAcceptanceRate())
+			+ " (" + QString::number(samplingStats.nbAccepted) + "/" + QString::number(samplingStats.nbCandidates)
+			+ ", fallbacks : " + QString::number(samplingStats.nbFallbacks) + ")\n";
+	}
 	res += "    --- start NucleiStats --- \n";
 	std::vector<Nucleus<double, Point_3, Vector_3> *>::const_iterator itN;	/// \brief the list of nuclei owned by the cell
 	unsigned int iNuclei = 0;
@@ -323,6 +385,7 @@ double SpheroidalCell::getMeshVolume(MeshOutFormats::outputFormat meshFormat) co
 		case MeshOutFormats::GEANT_4 :
 		case MeshOutFormats::GATE :
 		case MeshOutFormats::OFF :
+		case MeshOutFormats::PLY :
 		{
 			return Utils::myCGAL::getConvexPolyhedronVolume(shape, getPosition());
 		}
@@ -337,42 +400,31 @@ double SpheroidalCell::getMeshVolume(MeshOutFormats::outputFormat meshFormat) co
 
 #if defined(WITH_GEANT_4) || defined(WITH_GDML_EXPORT)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \param pName The prefix name to give to the G4entities
-/// \return The G4LogicalVolume* representing the membrane
+/// \details only read the mesh so it can be called from several threads on different cells.
+/// \param pFacets Where to write the facets, must have room for 9*getNbMembraneFacets() values
+/// \param pConvertToG4 The conversion factor from CPOP unit to G4 unit
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-G4LogicalVolume* SpheroidalCell::convertMembraneToG4(QString pName)
+void SpheroidalCell::writeMembraneFacets(G4double* pFacets, G4double pConvertToG4) const
 {
-	G4double convertToG4 = G4double(UnitSystemManager::getInstance()->getConversionToG4());
-
-	Polyhedron_3::Vertex_iterator itVertex;
-	// define the tesselated solid
-	G4TessellatedSolid* membraneSolid = new G4TessellatedSolid(pName.toStdString());
-	membraneSolid->SetSolidClosed(false);
-
-	// add all external facets
+	Point_3 origin = getOrigin();
     Point_3 p1, p2, p3;
-	// export facets
-	Polyhedron_3::Facet_iterator itFacet;
-	for( itFacet = shape_facets_begin(); itFacet != shape_facets_end(); ++itFacet)
+	Polyhedron_3::Facet_const_iterator itFacet;
+	for( itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet)
     {
     	p1 = itFacet->halfedge()->vertex()->point();
     	p2 = itFacet->halfedge()->next()->vertex()->point();
     	p3 = itFacet->halfedge()->next()->next()->vertex()->point();
     	// we only export external facets
-    	assert(p1 != getOrigin());
-    	assert(p2 != getOrigin());
-    	assert(p3 != getOrigin());
-
-		Vector_3 v1 = p1 - getOrigin();
-		Vector_3 v2 = p2 - getOrigin();
-		Vector_3 v3 = p3 - getOrigin();
+    	assert(p1 != origin);
+    	assert(p2 != origin);
+    	assert(p3 != origin);
 
 		assert(p1 != p2);
 		assert(p2 != p3);
 		assert(p3 != p1);
 
 		// check facet orientation
-		double determinant = CGAL::determinant(v1, v2, v3);
+		double determinant = CGAL::determinant(p1 - origin, p2 - origin, p3 - origin);
 		if(determinant < 0.f)
 		{
 			Point_3 tmp = p1;
@@ -380,15 +432,88 @@ G4LogicalVolume* SpheroidalCell::convertMembraneToG4(QString pName)
 			p2 = tmp;
 		}
 
-    	G4TriangularFacet* facet = new G4TriangularFacet( 	G4ThreeVector( 	G4double(	p1.x())*convertToG4,
-    																		G4double( 	p1.y())*convertToG4,
-    																		G4double(	p1.z())*convertToG4 	),
-    														G4ThreeVector( 	G4double(	p2.x())*convertToG4,
-    																		G4double( 	p2.y())*convertToG4,
-    																		G4double(	p2.z())*convertToG4 	),
-    														G4ThreeVector( 	G4double(	p3.x())*convertToG4,
-    																		G4double( 	p3.y())*convertToG4,
-    																		G4double(	p3.z())*convertToG4 	),
+		const Point_3* points[3] = {&p1, &p2, &p3};
+		for(int iPoint = 0; iPoint < 3; ++iPoint)
+		{
+			*pFacets++ = G4double(points[iPoint]->x())*pConvertToG4;
+			*pFacets++ = G4double(points[iPoint]->y())*pConvertToG4;
+			*pFacets++ = G4double(points[iPoint]->z())*pConvertToG4;
+		}
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pName The prefix name to give to the G4entities
+/// \param pConvexSolid true if the membrane should be exported as a CPOP_ConvexPolyhedron when convex
+/// \return The G4LogicalVolume* representing the membrane
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+G4LogicalVolume* SpheroidalCell::convertMembraneToG4(QString pName, bool pConvexSolid)
+{
+	std::vector<G4double> facets(9*getNbMembraneFacets());
+	writeMembraneFacets(facets.data(), G4double(UnitSystemManager::getInstance()->getConversionToG4()));
+	return convertMembraneFacetsToG4(pName, facets.data(), getNbMembraneFacets(), pConvexSolid);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pName The prefix name to give to the G4entities
+/// \param pFacets The facets as written by writeMembraneFacets
+/// \param pNbFacets The number of facets
+/// \param pConvexSolid true if the membrane should be exported as a CPOP_ConvexPolyhedron.
+/// The navigation on it is made in closed form from the facet planes instead of going through
+/// the voxels of a G4TessellatedSolid. Falls back on a G4TessellatedSolid if the membrane isn't convex
+/// \return The G4LogicalVolume* representing the membrane
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+G4LogicalVolume* SpheroidalCell::convertMembraneFacetsToG4(QString pName, const G4double* pFacets, size_t pNbFacets, bool pConvexSolid)
+{
+	G4VSolid* membraneSolid = NULL;
+#ifdef WITH_GEANT_4
+	if(pConvexSolid)
+	{
+		membraneSolid = CPOP_ConvexPolyhedron::create(pName.toStdString(), pFacets, pNbFacets);
+	}
+#else
+	(void)pConvexSolid;
+#endif
+
+	if(!membraneSolid)
+	{
+		membraneSolid = convertMembraneFacetsToG4TessellatedSolid(pName, pFacets, pNbFacets);
+		if(!membraneSolid)
+		{
+			return NULL;
+		}
+	}
+
+	// define all facet and add them.
+	QString logicalVolName = "LV_" + pName;
+	G4Material* lCellMat = this->getCellProperties()->getCytoplasmMaterial(this->getLifeCycle());
+	if(!lCellMat)
+	{
+		lCellMat = MaterialManager::getInstance()->getDefaultMaterial();
+	}
+
+	assert(lCellMat);
+	return new G4LogicalVolume(membraneSolid, lCellMat, logicalVolName.toStdString(), 0, 0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \param pName The prefix name to give to the G4entities
+/// \param pFacets The facets as written by writeMembraneFacets
+/// \param pNbFacets The number of facets
+/// \return The G4TessellatedSolid representing the membrane, NULL if failed
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+G4TessellatedSolid* SpheroidalCell::convertMembraneFacetsToG4TessellatedSolid(QString pName, const G4double* pFacets, size_t pNbFacets) const
+{
+	// define the tesselated solid
+	G4TessellatedSolid* membraneSolid = new G4TessellatedSolid(pName.toStdString());
+	membraneSolid->SetSolidClosed(false);
+
+	// add all external facets
+	for(size_t iFacet = 0; iFacet < pNbFacets; ++iFacet, pFacets += 9)
+    {
+    	G4TriangularFacet* facet = new G4TriangularFacet( 	G4ThreeVector(pFacets[0], pFacets[1], pFacets[2]),
+    														G4ThreeVector(pFacets[3], pFacets[4], pFacets[5]),
+    														G4ThreeVector(pFacets[6], pFacets[7], pFacets[8]),
     														ABSOLUTE);
 
     	assert(facet);
@@ -409,17 +534,7 @@ G4LogicalVolume* SpheroidalCell::convertMembraneToG4(QString pName)
 		std::cout << "error during creation, cannot create a tesselated solid without facets" << std::endl;
 		return NULL;
 	}
-
-	// define all facet and add them.
-	QString logicalVolName = "LV_" + pName;
-	G4Material* lCellMat = this->getCellProperties()->getCytoplasmMaterial(this->getLifeCycle());
-	if(!lCellMat)
-	{
-		lCellMat = MaterialManager::getInstance()->getDefaultMaterial();
-	}
-
-	assert(lCellMat);
-	return new G4LogicalVolume(membraneSolid, lCellMat, logicalVolName.toStdString(), 0, 0, 0);
+	return membraneSolid;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -432,6 +547,9 @@ G4LogicalVolume* SpheroidalCell::convertMembraneToG4(QString pName)
 /// \param pCellMap			The map containing relashionship between G4LogicalVolume and cell
 /// \param pNucleiMap		The map containing relashionship between G4LogicalVolume and nucleus
 /// \param pExportNuclei true if we want to export nuclei as well to G4
+/// \param pMembraneFacets The membrane facets as written by writeMembraneFacets. If NULL they are computed from the shape
+/// \param pNbMembraneFacets The number of membrane facets
+/// \param pConvexSolid true if the membrane should be exported as a CPOP_ConvexPolyhedron when convex
 /// \return The G4Vplacement* generated for the G4ent
 //////////////////////////////////////////////////////////////////////////////////////////////////
 // TODO : appeler ca convertToG3Entity
@@ -444,13 +562,18 @@ G4PVPlacement* SpheroidalCell::convertToG4Structure(
 	double pDeltaWin,
 	map<const G4LogicalVolume*, const t_Cell_3* >* pCellMap,
 	map<const G4LogicalVolume*, const t_Nucleus_3*>* pNucleiMap,
-	bool pExportNuclei
+	bool pExportNuclei,
+	const G4double* pMembraneFacets,
+	size_t pNbMembraneFacets,
+	bool pConvexSolid
 	)
 {
 	assert(pMother);
 	assert(pNeighbourCells);
 
-	G4LogicalVolume* membraneLogicVol = convertMembraneToG4(pName);
+	G4LogicalVolume* membraneLogicVol = pMembraneFacets ?
+		convertMembraneFacetsToG4(pName, pMembraneFacets, pNbMembraneFacets, pConvexSolid) :
+		convertMembraneToG4(pName, pConvexSolid);
 
 	QString physVolName = "PV_" + pName;
 	// std::cout << '\n' << " physVolName " << printf(physVolName.toStdString().c_str()) <<'\n';
@@ -486,7 +609,7 @@ G4PVPlacement* SpheroidalCell::convertToG4Structure(
 			cellMeshSub.setSpaceBetweenCell( newStepSize);
 			cellMeshSub.reffineCell( this );
 
-			membraneLogicVol = this->convertMembraneToG4(pName);
+			membraneLogicVol = this->convertMembraneToG4(pName, pConvexSolid);
 			try
 			{
 				overlap = vpPalcement->CheckOverlaps( 1000, overlapToleranceForG4, false);
@@ -582,9 +705,6 @@ G4PVPlacement* SpheroidalCell::convertToG4Structure(
 //////////////////////////////////////////////////////////////////////////////////////////////////
 void SpheroidalCell::computeMembraneSurfaceArea()
 {
-	areasToFacet.clear();
-	// map<double, Polyhedron_3::Facet_const_iterator> areasToFacet;
-
 	// reset area
 	sumMembraneMeshArea = 0;
 
@@ -598,7 +718,117 @@ void SpheroidalCell::computeMembraneSurfaceArea()
     		itFacet->halfedge()->next()->next()->vertex()->point() );
 		// here we can't use the squared_area because we want want to pick uniformely spot on the membrane
 		sumMembraneMeshArea += sqrt(lTri.squared_area());
-		areasToFacet.insert(make_pair(sumMembraneMeshArea, lTri));
+	}
+
+	// the mesh changed : sampling tables will be rebuilt on the next spot request
+	std::lock_guard<std::mutex> lock(samplingTablesMutex);
+	samplingTablesReady = false;
+	nbCytoplasmCandidates = 0;
+	nbCytoplasmAccepted = 0;
+	nbCytoplasmFallbacks = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// \details tables are built once per mesh, by the first thread requesting a spot.
+//////////////////////////////////////////////////////////////////////////////////////////////////
+void SpheroidalCell::ensureSamplingTables() const
+{
+	if(samplingTablesReady.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(samplingTablesMutex);
+	if(samplingTablesReady.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+	computeMembraneFacets();
+	computeCellTetrahedra();
+	samplingTablesReady.store(true, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////////////////////////
+void SpheroidalCell::computeMembraneFacets() const
+{
+	membraneFacets.clear();
+	membraneFacetsTable.clear();
+
+	vector<double> areas;
+	membraneFacets.reserve(shape->size_of_facets());
+	areas.reserve(shape->size_of_facets());
+	Polyhedron_3::Facet_const_iterator itFacet;
+	for( itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet)
+	{
+		membraneFacets.push_back(Utils::Geometry::Triangle::makeFlatTriangle<double>(
+			itFacet->halfedge()->vertex()->point(),
+			itFacet->halfedge()->next()->vertex()->point(),
+			itFacet->halfedge()->next()->next()->vertex()->point() ));
+		// the alias table is invariant to the weights scale : no need to halve
+		areas.push_back(Utils::Geometry::Triangle::getDoubleArea(membraneFacets.back()));
+	}
+
+	if(membraneFacets.empty())
+	{
+		return;
+	}
+
+	try
+	{
+		membraneFacetsTable.build(areas);
+	}catch(const std::invalid_argument&)
+	{
+		membraneFacets.clear();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+/// \details the shape is convex so the fan of tetrahedra joining the centroid of its vertices
+/// to each facet is a partition of the cell.
+//////////////////////////////////////////////////////////////////////////////////////////////////
+void SpheroidalCell::computeCellTetrahedra() const
+{
+	cellTetrahedra.clear();
+	cellTetrahedraTable.clear();
+
+	if(shape->size_of_facets() < 1)
+	{
+		return;
+	}
+
+	Vector_3 sum(0., 0., 0.);
+	Polyhedron_3::Vertex_const_iterator itVertex;
+	for(itVertex = shape->vertices_begin(); itVertex != shape->vertices_end(); ++itVertex)
+	{
+		sum = sum + (itVertex->point() - CGAL::ORIGIN);
+	}
+	Point_3 apex = CGAL::ORIGIN + sum / double(shape->size_of_vertices());
+
+	vector<double> volumes;
+	cellTetrahedra.reserve(shape->size_of_facets());
+	volumes.reserve(shape->size_of_facets());
+	Polyhedron_3::Facet_const_iterator itFacet;
+	for( itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet)
+	{
+		Tetrahedron_3 lTet(
+			apex,
+			itFacet->halfedge()->vertex()->point(),
+			itFacet->halfedge()->next()->vertex()->point(),
+			itFacet->halfedge()->next()->next()->vertex()->point() );
+		cellTetrahedra.push_back(lTet);
+		volumes.push_back(std::abs(lTet.volume()));
+	}
+
+	try
+	{
+		cellTetrahedraTable.build(volumes);
+	}catch(const std::invalid_argument&)
+	{
+		// flat shape : no volume to pick spots from
+		cellTetrahedra.clear();
+		InformationSystemManager::getInstance()->Message(InformationSystemManager::CANT_PROCESS_MES, "null cell volume, unable to build the cytoplasm sampling table", "SpheroidalCell");
 	}
 }
 
@@ -280,7 +280,7 @@ bool Spheroid<Cell_type>::distribute()
 // simulateTimeAction
 /// \param pDuration The duration of the total simulation
 /// \param pTimeStep The duration for a step of the simulation
-/// \param pNbAgtToSimulate The number of agent to simulate at each step (randomly picked)
+/// \param pNbAgtToSimulate The number of agent to simulate at each step (randomly picked). All agents if not positive
 /// \param pMovement_threshold The max movement distance possible during one step
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename Cell_type>
@@ -294,7 +294,10 @@ bool Spheroid<Cell_type>::simulateTimeAction(double pDuration, double pTimeStep,
 	platform.setStepDuration(			pTimeStep);
 	platform.setDuration(				pDuration);
 	platform.setDisplacementThreshold(	pMovement_threshold);		// limit to 0.5µm hte displacement per step.
-	platform.limiteNbAgentToSimulate(	pNbAgtToSimulate);
+	if(pNbAgtToSimulate > 0)
+	{
+		platform.limiteNbAgentToSimulate(	pNbAgtToSimulate);
+	}
 
 	/// set SDS needed to simulate
 	/// add the SDS to the layer
@@ -19,13 +19,29 @@ static double default_ratio_to_stable_case = 0.75;
 
 #include <CGAL/centroid.h>
 
+#include <vector>
+
+template<typename Kernel, typename Point, typename Vector>
+class ElasticPairForces;
+
 //////////////////////////////////////////////////////////////////////////////
 /// \brief define an elastic force.
+/// \details The neighbours are cached in arrays, shared by computeForce, computeEnergy
+/// and ElasticPairForces. Without cutoff the list is the SDS neighbourhood, requested again
+/// at each SDS update.
+/// With a cutoff only the neighbours closer than the cutoff are pulled. If the SimulationManager
+/// has a neighbour list skin, the list keeps the SDS neighbours closer than cutoff + skin and is
+/// only rebuilt once agents may have moved of half the skin : the distances are checked on each
+/// evaluation. A cell becoming an SDS neighbour between two rebuilds is seen from the next one.
+/// If the force is registered on an ElasticPairForces, the contribution of each
+/// neighbour is computed by it before the step and only summed here.
 /// @author Henri Payno
 //////////////////////////////////////////////////////////////////////////////
 template<typename Kernel, typename Point, typename Vector>
 class ElasticForce : public Force<Kernel, Point, Vector>
 {
+	friend class ElasticPairForces<Kernel, Point, Vector>;
+
 public:
 	/// \brief constructor
 	ElasticForce(const Cell<Kernel, Point, Vector>* cell, Kernel pRigidityCste, Kernel pRatioToStableCase = default_ratio_to_stable_case);
@@ -34,14 +50,52 @@ public:
 	
 	/// \brief the definition of the force
 	inline Vector computeForce() const;
+	/// \brief the energy stored in the springs with the neighbours
+	Kernel computeEnergy() const;
+
+	/// \brief return the constante of rigidity
+	Kernel getRigidity() const				{ return rigidity_constante;};
+	/// \brief return the ratio used to find the length at rest
+	Kernel getRatioToStableCase() const		{ return ratioToStableCase;};
+	/// \brief return the distance over which neighbours are not pulled. Not positive if none
+	Kernel getCutoff() const				{ return cutoff;};
+	/// \brief set the distance over which neighbours are not pulled. Not positive for none
+	void setCutoff(Kernel pCutoff)			{ cutoff = pCutoff; neighbourListEpoch = 0;};
 
 protected:	
 	/// \brief compute the optimal length betwwen two cell ( as the length of the ressort at rest)
 	Kernel getOptimalLength(const SpatialableAgent<Kernel, Point, Vector>*) const;
 
 private:
+	/// \brief rebuild the neighbour list if outdated
+	bool updateNeighbourList() const;
+	/// \brief return true if a neighbour at this distance is pulled
+	inline bool isInteracting(double pDistance) const	{ return cutoff <= 0. || pDistance < cutoff;};
+	/// \brief return the position of the neighbour i of the list
+	inline Point getNeighbourPosition(size_t i) const;
+	/// \brief return the length at rest of the spring with the neighbour i of the list
+	inline Kernel getRestLength(size_t i) const;
+
 	Kernel rigidity_constante;		///< \brief The constante of rigidity
 	Kernel ratioToStableCase;		///< \brief used to find the length at rest of the elastic force.
+	Kernel cutoff;					///< \brief distance over which neighbours are not pulled. Not positive if none
+
+	/// \brief the neighbours of the cell
+	mutable std::vector<const SpatialableAgent<Kernel, Point, Vector>* > neighbours;
+	/// \brief the round shape of each neighbour, NULL if not round
+	mutable std::vector<const Round_Shape<Kernel, Point, Vector>* > neighbourShapes;
+	/// \brief the index of each neighbour on neighbourStore
+	mutable std::vector<size_t> neighbourIndexes;
+	/// \brief the state store of the cell if all neighbours are in, else NULL
+	mutable const AgentStateStore<Kernel, Point, Vector>* neighbourStore;
+	/// \brief the round shape of the cell, NULL if not round
+	mutable const Round_Shape<Kernel, Point, Vector>* cellShape;
+	/// \brief the SimulationManager epoch the list has been built on (skin epoch with a skin). 0 if never built
+	mutable unsigned long int neighbourListEpoch;
+	/// \brief the force applied by each neighbour, set by ElasticPairForces
+	mutable std::vector<Vector> pairContributions;
+	/// \brief true if pairContributions have been set for the next computeForce
+	mutable bool hasPairContributions;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -53,7 +107,12 @@ template<typename Kernel, typename Point, typename Vector>
 ElasticForce<Kernel, Point, Vector>::ElasticForce(const Cell<Kernel, Point, Vector>* pCell, Kernel pRigidityCste, Kernel pRatioToStableCase) :
 	Force<Kernel, Point, Vector>(pCell, FRCE_INTERACT_WITH_NEIGHBOURS),
 	rigidity_constante(pRigidityCste),
-	ratioToStableCase(pRatioToStableCase)
+	ratioToStableCase(pRatioToStableCase),
+	cutoff(-1.),
+	neighbourStore(NULL),
+	cellShape(NULL),
+	neighbourListEpoch(0),
+	hasPairContributions(false)
 {
 
 }
@@ -89,24 +148,117 @@ Kernel  ElasticForce<Kernel, Point, Vector>::getOptimalLength(const SpatialableA
 	return (Kernel)0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \details The list keeps the neighbours of the SDS and their shape, so each
+/// step only reads positions and radii (which change with the cell growth).
+/// With a cutoff, neighbours further than the cutoff (plus the skin) are not kept.
+/// If the cell and all its neighbours are in the same state store, positions are
+/// read from it by index.
+/// \return true if the list has been rebuilt
+///////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+bool ElasticForce<Kernel, Point, Vector>::updateNeighbourList() const
+{
+	const SimulationManager* lManager = SimulationManager::getInstance();
+	const bool lWithSkin = (cutoff > 0. && lManager->getNeighbourListSkin() > 0.);
+	const unsigned long int lEpoch = lWithSkin ? lManager->getSkinListEpoch() : lManager->getNeighbourListEpoch();
+	if(neighbourListEpoch == lEpoch)
+	{
+		return false;
+	}
+
+	std::set<const SpatialableAgent< Kernel,  Point,  Vector>* > agentToConsider = Force<Kernel, Point, Vector>::getConcernedAgent();
+	neighbours.clear();
+	const Point cellOrigin = Force<Kernel, Point, Vector>::cell->getPosition();
+	const double lListDistance = cutoff + (lWithSkin ? lManager->getNeighbourListSkin() : 0.);
+	typename std::set<const SpatialableAgent< Kernel,  Point,  Vector>* >::const_iterator itAgent;
+	for(itAgent = agentToConsider.begin(); itAgent != agentToConsider.end(); ++itAgent)
+	{
+		if(cutoff <= 0. || CGAL::squared_distance((*itAgent)->getPosition(), cellOrigin) < lListDistance*lListDistance)
+		{
+			neighbours.push_back(*itAgent);
+		}
+	}
+	neighbourShapes.resize(neighbours.size());
+	neighbourIndexes.resize(neighbours.size());
+	cellShape = dynamic_cast<const Round_Shape<Kernel, Point, Vector>*> (Force<Kernel, Point, Vector>::cell->getBody());
+	neighbourStore = Force<Kernel, Point, Vector>::cell->getStateStore();
+
+	for(size_t iNeighbour = 0; iNeighbour < neighbours.size(); ++iNeighbour)
+	{
+		assert(neighbours[iNeighbour]->getBody());
+		neighbourShapes[iNeighbour] = dynamic_cast<const Round_Shape<Kernel, Point, Vector>*> (neighbours[iNeighbour]->getBody());
+		const DynamicAgent<Kernel, Point, Vector>* lDynamic = dynamic_cast<const DynamicAgent<Kernel, Point, Vector>*> (neighbours[iNeighbour]);
+		if(lDynamic && neighbourStore && lDynamic->getStateStore() == neighbourStore)
+		{
+			neighbourIndexes[iNeighbour] = lDynamic->getStateIndex();
+		}else
+		{
+			neighbourStore = NULL;
+		}
+	}
+	neighbourListEpoch = lEpoch;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \param i The index of the neighbour on the list
+///////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+Point ElasticForce<Kernel, Point, Vector>::getNeighbourPosition(size_t i) const
+{
+	if(neighbourStore)
+	{
+		return neighbourStore->getPositions()[neighbourIndexes[i]];
+	}
+	return neighbours[i]->getPosition();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \param i The index of the neighbour on the list
+/// \return the same length as getOptimalLength, without the shape casts
+///////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+Kernel ElasticForce<Kernel, Point, Vector>::getRestLength(size_t i) const
+{
+	if(cellShape && neighbourShapes[i])
+	{
+		return (cellShape->getRadius() + neighbourShapes[i]->getRadius()) * ratioToStableCase;
+	}
+	return (Kernel)0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///
 ///////////////////////////////////////////////////////////////////////////////
 template<typename Kernel, typename Point, typename Vector>
 inline Vector ElasticForce<Kernel, Point, Vector>::computeForce() const
 {
-	std::set<const SpatialableAgent< Kernel,  Point,  Vector>* > agentToConsider = Force<Kernel, Point, Vector>::getConcernedAgent();
+	Vector force;
+	// contributions already computed pair by pair, in the order of the neighbour list
+	if(hasPairContributions)
+	{
+		hasPairContributions = false;
+		for(size_t iNeighbour = 0; iNeighbour < pairContributions.size(); ++iNeighbour)
+		{
+			force = force + pairContributions[iNeighbour];
+		}
+		return force;
+	}
+
+	updateNeighbourList();
 
 	Point cellOrigin = Force< Kernel,  Point,  Vector>::cell->getPosition();
-	// get neighbours from the SDSManager.
-	typename std::set<const SpatialableAgent< Kernel,  Point,  Vector>* >::const_iterator itNeighbour;
-	Vector force;
-	
-	for(itNeighbour = agentToConsider.begin(); itNeighbour != agentToConsider.end(); ++itNeighbour)
+
+	for(size_t iNeighbour = 0; iNeighbour < neighbours.size(); ++iNeighbour)
 	{
-		Point neighbourOrigin = (*itNeighbour)->getPosition();
-		Kernel optimalDistance = ElasticForce<Kernel, Point, Vector>::getOptimalLength(*itNeighbour);	// distance in um
+		Point neighbourOrigin = getNeighbourPosition(iNeighbour);
+		Kernel optimalDistance = getRestLength(iNeighbour);												// distance in um
 		double currentDistance = sqrt( CGAL::squared_distance( neighbourOrigin,  cellOrigin) );			// distance in um
+		if(!isInteracting(currentDistance))
+		{
+			continue;
+		}
 		/// The formula is F = -k.X with k = rigidity constante
 		Kernel hForce = -1.* rigidity_constante * (optimalDistance - currentDistance); 
 		force = force + hForce * Utils::myCGAL::normalize(Vector( neighbourOrigin - cellOrigin ));
@@ -114,4 +266,31 @@ inline Vector ElasticForce<Kernel, Point, Vector>::computeForce() const
 	return force;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \details Each cell of a pair applies its own elastic force, so each one
+/// counts half of the spring energy 1/2.k.X^2
+/// \return {The potential energy of the cell springs}
+///////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+Kernel ElasticForce<Kernel, Point, Vector>::computeEnergy() const
+{
+	updateNeighbourList();
+
+	Point cellOrigin = Force< Kernel,  Point,  Vector>::cell->getPosition();
+	Kernel energy = 0.;
+
+	for(size_t iNeighbour = 0; iNeighbour < neighbours.size(); ++iNeighbour)
+	{
+		Kernel optimalDistance = getRestLength(iNeighbour);
+		double currentDistance = sqrt( CGAL::squared_distance( getNeighbourPosition(iNeighbour),  cellOrigin) );
+		if(!isInteracting(currentDistance))
+		{
+			continue;
+		}
+		Kernel elongation = optimalDistance - currentDistance;
+		energy += 0.25 * rigidity_constante * elongation * elongation;
+	}
+	return energy;
+}
+
 #endif // ELASTIC_FORCE_HH
\ No newline at end of file
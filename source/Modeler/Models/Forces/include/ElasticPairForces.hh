@@ -0,0 +1,241 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef ELASTIC_PAIR_FORCES_HH
+#define ELASTIC_PAIR_FORCES_HH
+
+#include "Action.hh"
+#include "AgentSettings.hh"
+#include "ElasticForce.hh"
+#include "ParallelChunks.hh"
+#include "SimulationManager.hh"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#define MIN_NB_PAIR_PER_ELASTIC_THREAD 4096		///< \brief under this number of pairs per thread the evaluation isn't split
+
+//////////////////////////////////////////////////////////////////////////////
+/// \brief evaluate the elastic forces pair by pair before each simulation step.
+/// \details Two neighbour cells with the same rigidity and ratio to stable case apply
+/// opposite forces to each other : the pair is evaluated once and gives the contribution
+/// of both cells. Each contribution is written on its own slot of the cell neighbour list,
+/// so the evaluation can be split between threads, and ElasticForce::computeForce sums the
+/// slots in the same order as its own evaluation : results are the same.
+/// Neighbours without a symmetric force are evaluated from one side only.
+/// \warning forces are evaluated on the positions at the begining of the step. This is the
+/// dynamics of the per agent evaluation only with SIMULATION_VALID_AGENT_NEW_POS, where the
+/// new positions are applied at the end of the step. Without it an agent sees the neighbours
+/// already moved during the step, so it should not be scheduled.
+/// \warning scheduled as an Action::EACH_BEGIN_ITERATION on construction, until deleted.
+/// The forces registered must stay alive while it is scheduled.
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+class ElasticPairForces : public Action
+{
+	typedef ElasticForce<Kernel, Point, Vector> t_ElasticForce;
+
+	/// \brief a neighbour slot of force1 and, if symmetric, the opposite slot of force2
+	struct Pair
+	{
+		size_t force1;
+		size_t slot1;
+		size_t force2;
+		size_t slot2;
+		bool symmetric;
+	};
+
+public:
+	/// \brief constructor
+	ElasticPairForces(unsigned int pNbThreads = 0);
+	/// \brief destructor
+	virtual ~ElasticPairForces();
+
+	/// \brief evaluate the forces registered for the next step
+	virtual bool exec();
+
+	/// \brief register a force to evaluate pair by pair
+	void addForce(t_ElasticForce* pForce)			{ assert(pForce); forces.push_back(pForce); pairsOutdated = true;};
+	/// \brief forget all the forces registered
+	void clear()									{ forces.clear(); pairs.clear(); pairsOutdated = true;};
+	/// \brief return the number of pairs evaluated from both sides
+	size_t getNbSymmetricPairs() const;
+	/// \brief set the number of threads used for the evaluation. 0 to follow the hardware
+	void setNbThreads(unsigned int pNbThreads)		{ nbThreads = pNbThreads;};
+
+private:
+	/// \brief build the pairs from the neighbour lists of the forces
+	void buildPairs();
+	/// \brief evaluate the pair and write the contributions
+	inline void evaluate(const Pair&) const;
+
+	std::vector<t_ElasticForce*> forces;	///< \brief the forces registered
+	std::vector<Pair> pairs;				///< \brief the pairs to evaluate
+	bool pairsOutdated;						///< \brief true if a neighbour list changed since the pairs have been built
+	unsigned int nbThreads;					///< \brief number of threads used for the evaluation. 0 to follow the hardware
+};
+
+//////////////////////////////////////////////////////////////////////////////
+/// \param pNbThreads number of threads used for the evaluation. 0 to follow the hardware
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+ElasticPairForces<Kernel, Point, Vector>::ElasticPairForces(unsigned int pNbThreads):
+	Action(Action::EACH_BEGIN_ITERATION),
+	pairsOutdated(true),
+	nbThreads(pNbThreads)
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \warning the forces are not deleted, they belong to their cell
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+ElasticPairForces<Kernel, Point, Vector>::~ElasticPairForces()
+{
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \return the number of pairs giving the contribution of both cells
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+size_t ElasticPairForces<Kernel, Point, Vector>::getNbSymmetricPairs() const
+{
+	size_t lNbPairs = 0;
+	typename std::vector<Pair>::const_iterator itPair;
+	for(itPair = pairs.begin(); itPair != pairs.end(); ++itPair)
+	{
+		if(itPair->symmetric)
+		{
+			lNbPairs++;
+		}
+	}
+	return lNbPairs;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details A slot is paired with the slot of the opposite force if the neighbour has
+/// a force registered with the same parameters, which also lists the cell. Each slot
+/// belongs to one pair only.
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+void ElasticPairForces<Kernel, Point, Vector>::buildPairs()
+{
+	pairs.clear();
+
+	// the force of each cell. A second force on the same cell is only evaluated from its side
+	std::map<const SpatialableAgent<Kernel, Point, Vector>*, size_t> lForceOfCell;
+	for(size_t iForce = 0; iForce < forces.size(); ++iForce)
+	{
+		lForceOfCell.insert(std::make_pair(forces[iForce]->cell, iForce));
+	}
+
+	for(size_t iForce = 0; iForce < forces.size(); ++iForce)
+	{
+		const t_ElasticForce* lForce = forces[iForce];
+		bool lCanPair = (lForceOfCell[lForce->cell] == iForce);
+		for(size_t iSlot = 0; iSlot < lForce->neighbours.size(); ++iSlot)
+		{
+			Pair lPair = {iForce, iSlot, 0, 0, false};
+			typename std::map<const SpatialableAgent<Kernel, Point, Vector>*, size_t>::const_iterator itOpposite = lForceOfCell.find(lForce->neighbours[iSlot]);
+			if(lCanPair && itOpposite != lForceOfCell.end() && itOpposite->second != iForce)
+			{
+				const t_ElasticForce* lOpposite = forces[itOpposite->second];
+				if( lOpposite->getRigidity() == lForce->getRigidity() && lOpposite->getRatioToStableCase() == lForce->getRatioToStableCase() &&
+					lOpposite->getCutoff() == lForce->getCutoff())
+				{
+					typename std::vector<const SpatialableAgent<Kernel, Point, Vector>* >::const_iterator itSlot;
+					itSlot = std::find(lOpposite->neighbours.begin(), lOpposite->neighbours.end(), lForce->cell);
+					if(itSlot != lOpposite->neighbours.end())
+					{
+						// added once, from the force of lower index
+						if(itOpposite->second < iForce)
+						{
+							continue;
+						}
+						lPair.force2 = itOpposite->second;
+						lPair.slot2 = itSlot - lOpposite->neighbours.begin();
+						lPair.symmetric = true;
+					}
+				}
+			}
+			pairs.push_back(lPair);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details same formula as ElasticForce::computeForce. The opposite force
+/// is exactly the opposite contribution.
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+void ElasticPairForces<Kernel, Point, Vector>::evaluate(const Pair& pPair) const
+{
+	const t_ElasticForce* lForce = forces[pPair.force1];
+	Point cellOrigin = lForce->cell->getPosition();
+	Point neighbourOrigin = lForce->getNeighbourPosition(pPair.slot1);
+	Kernel optimalDistance = lForce->getRestLength(pPair.slot1);
+	double currentDistance = sqrt( CGAL::squared_distance( neighbourOrigin,  cellOrigin) );
+	Vector lContribution = CGAL::NULL_VECTOR;
+	if(lForce->isInteracting(currentDistance))
+	{
+		Kernel hForce = -1.* lForce->rigidity_constante * (optimalDistance - currentDistance);
+		lContribution = hForce * Utils::myCGAL::normalize(Vector( neighbourOrigin - cellOrigin ));
+	}
+
+	lForce->pairContributions[pPair.slot1] = lContribution;
+	if(pPair.symmetric)
+	{
+		forces[pPair.force2]->pairContributions[pPair.slot2] = -lContribution;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+/// \details neighbour lists are updated, then the pairs are rebuilt if the lists
+/// changed and evaluated by chunks on the threads.
+/// \return true
+//////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+bool ElasticPairForces<Kernel, Point, Vector>::exec()
+{
+	typename std::vector<t_ElasticForce*>::iterator itForce;
+	for(itForce = forces.begin(); itForce != forces.end(); ++itForce)
+	{
+		if((*itForce)->updateNeighbourList())
+		{
+			pairsOutdated = true;
+		}
+		(*itForce)->pairContributions.resize((*itForce)->neighbours.size());
+	}
+	if(pairsOutdated)
+	{
+		buildPairs();
+		pairsOutdated = false;
+	}
+
+	// each pair writes its own slots : chunks can be evaluated in parallel
+	const size_t chunkSize = 1024;
+	processChunksInParallel(pairs.size(), chunkSize, getNbThreadsFor(pairs.size(), MIN_NB_PAIR_PER_ELASTIC_THREAD, nbThreads),
+		[&](size_t pBegin, size_t pEnd, unsigned int)
+		{
+			for(size_t iPair = pBegin; iPair < pEnd; ++iPair)
+			{
+				evaluate(pairs[iPair]);
+			}
+		});
+
+	for(itForce = forces.begin(); itForce != forces.end(); ++itForce)
+	{
+		(*itForce)->hasPairContributions = true;
+	}
+	return true;
+}
+
+#endif // ELASTIC_PAIR_FORCES_HH
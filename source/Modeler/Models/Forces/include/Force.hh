@@ -32,6 +32,8 @@ public:
 	virtual ~Force();
 	/// \brief return the force for the actual set up
 	virtual Vector computeForce() const = 0;
+	/// \brief return the potential energy of the force for the actual set up
+	virtual Kernel computeEnergy() const;
 	/// \brief return all the agent needed to apply the force
 	virtual std::set<const SpatialableAgent<Kernel, Point, Vector>* > getConcernedAgent() const;
 
@@ -63,6 +65,15 @@ Force<Kernel, Point, Vector>::~Force()
 
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \return {The potential energy of the force. 0 if the force doesn't derive from a potential}
+///////////////////////////////////////////////////////////////////////////////
+template<typename Kernel, typename Point, typename Vector>
+Kernel Force<Kernel, Point, Vector>::computeEnergy() const
+{
+	return Kernel();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \return {The set of agent needed (concerned) to applyt the force}
 ///////////////////////////////////////////////////////////////////////////////
@@ -9,6 +9,7 @@ See LICENSE.md for further details
 #include "RandomForce.hh"
 #include "RandomEngineManager.hh"
 #include "CGAL_Utils.hh"
+#include "Scheduler.hh"
 
 using namespace Utils::myCGAL;
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -17,11 +18,11 @@ using namespace Utils::myCGAL;
 template<>
 Vector_2 RandomForce<double, Point_2, Vector_2>::computeForce() const
 {
-	return (intensity* normalize( 
-									Vector_2( 	RandomEngineManager::getInstance()->randd(-1., 1.), 
-												RandomEngineManager::getInstance()->randd(-1., 1.) 
-											) 
-								) );
+	// the cell stream of the step : independent of the thread running the cell
+	RandomStream lStream = RandomEngineManager::getInstance()->getStream(cell->getID(), Scheduler::getInstance()->getStepIndex());
+	double x = lStream.randd(-1., 1.);
+	double y = lStream.randd(-1., 1.);
+	return (intensity* normalize( Vector_2(x, y) ) );
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ///
@@ -29,10 +30,10 @@ Vector_2 RandomForce<double, Point_2, Vector_2>::computeForce() const
 template<>
 Vector_3 RandomForce<double, Point_3, Vector_3>::computeForce() const
 {
-	return (intensity* normalize( 
-									Vector_3( 	RandomEngineManager::getInstance()->randd(-1., 1.), 
-												RandomEngineManager::getInstance()->randd(-1., 1.),
-												RandomEngineManager::getInstance()->randd(-1., 1.) 
-											) 
-								) );
+	// the cell stream of the step : independent of the thread running the cell
+	RandomStream lStream = RandomEngineManager::getInstance()->getStream(cell->getID(), Scheduler::getInstance()->getStepIndex());
+	double x = lStream.randd(-1., 1.);
+	double y = lStream.randd(-1., 1.);
+	double z = lStream.randd(-1., 1.);
+	return (intensity* normalize( Vector_3(x, y, z) ) );
 }
\ No newline at end of file
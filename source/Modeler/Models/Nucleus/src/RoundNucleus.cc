@@ -157,6 +157,7 @@ double RoundNucleus<double, Point_3, Vector_3>::getMeshVolume(MeshOutFormats::ou
 		/// in this case we export a perfect sphere
 			return (4./3.* M_PI * (getRadius() * getRadius() * getRadius() ) );
 		case MeshOutFormats::OFF :
+		case MeshOutFormats::PLY :
 		{
 			std::vector<Point_3> lCellNucleusPoints = getShapePoints();
 			Polyhedron_3 polyNucleus;
@@ -2,12 +2,15 @@
 #define POPULATION_HH
 
 #include <ctime>
+#include <set>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
 #include "UnitSystemManager.hh"
 #include "Mesh3DSettings.hh"
 #include "CellSettings.hh"
+#include "CellRefinementTarget.hh"
 #include "RandomEngineManager.hh"
 #include "Randomize.hh"
 #include "SpheroidRegion.hh"
@@ -16,6 +19,8 @@
 
 #include "PopulationMessenger.hh"
 
+class SpheroidalCellMesh;
+
 namespace cpop {
 
 class Population
@@ -42,6 +47,21 @@ public:
     std::string population_file() const;
     void setPopulation_file(const std::string &population_file);
 
+    std::string mesh_cache_directory() const;
+    void setMesh_cache_directory(const std::string &mesh_cache_directory);
+
+    void setRefinement_target_for_region(const std::string& region_name, unsigned int number_max_facet, double max_facet_area);
+    void setRefinement_target_for_cell(int cell_id, unsigned int number_max_facet, double max_facet_area);
+
+    bool convex_cell_solid() const;
+    void setConvex_cell_solid(bool convex_cell_solid);
+
+    std::string mesh_validation_file() const;
+    void setMesh_validation_file(const std::string &mesh_validation_file);
+
+    std::string removed_cells_file() const;
+    void setRemoved_cells_file(const std::string &removed_cells_file);
+
     const std::vector<const Settings::nCell::t_Cell_3 *>& cells() const;
 
     double internal_layer_ratio() const;
@@ -84,6 +104,9 @@ public:
 
 private:
 
+    /// \brief Set on the mesh the refinement target of each agent, from its cell ID or its region
+    void applyRefinementTargets(SpheroidalCellMesh* mesh, const std::set<Settings::nAgent::t_SpatialableAgent_3*>& agents) const;
+
     //Conversion helpers
     /// \brief Convert factor between CPOP default unit and G4 default unit
     double conversionFrmCPOPToG4 = UnitSystemManager::getInstance()->getConversionToG4();
@@ -106,6 +129,18 @@ private:
     double delta_reffinement_ = -1;
     /// \brief File containing the population
     std::string population_file_ = "";
+    /// \brief Directory of the binary cell mesh cache. Empty means no cache
+    std::string mesh_cache_directory_ = "";
+    /// \brief Membrane refinement target of the cells of each region, areas in G4 unit. Overrides numberFacet and deltaRef
+    std::unordered_map<std::string, CellRefinementTarget> region_refinement_target_;
+    /// \brief Membrane refinement target by cell ID, areas in G4 unit. Takes precedence over the region one
+    std::unordered_map<unsigned long int, CellRefinementTarget> cell_refinement_target_;
+    /// \brief Export the convex cell membranes as CPOP_ConvexPolyhedron instead of G4TessellatedSolid
+    bool convex_cell_solid_ = false;
+    /// \brief File of the cell mesh validation report. Empty means no validation
+    std::string mesh_validation_file_ = "";
+    /// \brief File where the IDs of the cells removed for conflicts during the meshing are appended. Empty means no file
+    std::string removed_cells_file_;
 
     // Regions
     /// \brief Region container : necrosis, intermediary and external regions
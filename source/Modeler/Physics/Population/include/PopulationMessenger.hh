@@ -6,7 +6,9 @@
 #include "G4UIcmdWithAString.hh"
 #include "G4UIcmdWithAnInteger.hh"
 #include "G4UIcmdWithADouble.hh"
+#include "G4UIcmdWithABool.hh"
 #include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcommand.hh"
 
 #include "MessengerBase.hh"
 
@@ -35,6 +37,18 @@ private:
     std::unique_ptr<G4UIcmdWithAnInteger> number_facet_cmd_;
     /// \brief Set delta refinement
     std::unique_ptr<G4UIcmdWithADouble> delta_ref_cmd_;
+    /// \brief Set the directory of the cell mesh cache
+    std::unique_ptr<G4UIcmdWithAString> mesh_cache_cmd_;
+    /// \brief Set the membrane refinement target of the cells of a region
+    std::unique_ptr<G4UIcommand> refinement_region_cmd_;
+    /// \brief Set the membrane refinement target of a cell
+    std::unique_ptr<G4UIcommand> refinement_cell_cmd_;
+    /// \brief Export the convex cell membranes as convex polyhedra
+    std::unique_ptr<G4UIcmdWithABool> convex_cell_solid_cmd_;
+    /// \brief Set the file of the cell mesh validation report
+    std::unique_ptr<G4UIcmdWithAString> mesh_validation_cmd_;
+    /// \brief Set the file where the IDs of the cells removed during the meshing are appended
+    std::unique_ptr<G4UIcmdWithAString> removed_cells_cmd_;
     /// \brief Set internal layer ratio
     std::unique_ptr<G4UIcmdWithADouble> internal_ratio_cmd_;
     /// \brief Set intermediary layer ratio
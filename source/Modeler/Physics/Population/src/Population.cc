@@ -5,6 +5,7 @@
 #include "EnvironmentSettings.hh"
 #include "MeshFactory.hh"
 #include "SpheroidalCellMesh.hh"
+#include "CellMeshSettings.hh"
 #include "CPOP_Loader.hh"
 #include "CGAL_Utils.hh"
 
@@ -17,7 +18,8 @@
 namespace cpop {
 
 Population::Population()
-    :messenger_(std::make_unique<PopulationMessenger>(this))
+    :removed_cells_file_(REMOVED_CELLS_FILE.toStdString()),
+      messenger_(std::make_unique<PopulationMessenger>(this))
 {
 
 }
@@ -87,6 +89,62 @@ void Population::setPopulation_file(const std::string &population_file)
     population_file_ = population_file;
 }
 
+std::string Population::mesh_cache_directory() const
+{
+    return mesh_cache_directory_;
+}
+
+void Population::setMesh_cache_directory(const std::string &mesh_cache_directory)
+{
+    mesh_cache_directory_ = mesh_cache_directory;
+}
+
+void Population::setRefinement_target_for_region(const std::string &region_name, unsigned int number_max_facet, double max_facet_area)
+{
+    if (max_facet_area < 0)
+        throw std::runtime_error("Maximal facet area should be positive. Current value : " + to_string(max_facet_area));
+
+    region_refinement_target_.insert_or_assign(region_name, CellRefinementTarget(number_max_facet, max_facet_area));
+}
+
+void Population::setRefinement_target_for_cell(int cell_id, unsigned int number_max_facet, double max_facet_area)
+{
+    if (max_facet_area < 0)
+        throw std::runtime_error("Maximal facet area should be positive. Current value : " + to_string(max_facet_area));
+
+    cell_refinement_target_.insert_or_assign(static_cast<unsigned long int>(cell_id), CellRefinementTarget(number_max_facet, max_facet_area));
+}
+
+bool Population::convex_cell_solid() const
+{
+    return convex_cell_solid_;
+}
+
+void Population::setConvex_cell_solid(bool convex_cell_solid)
+{
+    convex_cell_solid_ = convex_cell_solid;
+}
+
+std::string Population::mesh_validation_file() const
+{
+    return mesh_validation_file_;
+}
+
+void Population::setMesh_validation_file(const std::string &mesh_validation_file)
+{
+    mesh_validation_file_ = mesh_validation_file;
+}
+
+std::string Population::removed_cells_file() const
+{
+    return removed_cells_file_;
+}
+
+void Population::setRemoved_cells_file(const std::string &removed_cells_file)
+{
+    removed_cells_file_ = removed_cells_file;
+}
+
 G4int Population::calculateNumberOfCells_InXML_File()
 //VictorLevrague
 {
@@ -186,6 +244,18 @@ void Population::loadPopulation()
     // define a mesh
     int error;                        //< error value when create_3DMesh is executed
     voronoi_mesh_ = MeshFactory::getInstance()->create_3DMesh(&error,  dynamic_cast<t_SimulatedSubEnv_3*>( env->getFirstChild() ), MeshTypes::Round_Cell_Tesselation, number_max_facet_poly(), delta_reffinement());
+    if(!mesh_cache_directory().empty())
+    {
+        // the meshes only depend on the population file and the meshing parameters, so jobs on the same population share them
+        uint64_t population_key = SpheroidalCellMeshCache::hashFile(population_file());
+        if(population_key != 0)
+            dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->setMeshCache(QString::fromStdString(mesh_cache_directory()), population_key);
+    }
+    applyRefinementTargets(dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_), spaAgts);
+    dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->setConvexMembraneSolid(convex_cell_solid());
+    dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->setValidationReportFile(QString::fromStdString(mesh_validation_file()));
+    dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->setRemovedCellsFile(QString::fromStdString(removed_cells_file()));
+    dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->setVerboseLevel(verbose_level());
     dynamic_cast<SpheroidalCellMesh*>(voronoi_mesh_)->generateMesh();
 
     std::ofstream masses_cell_file;
@@ -223,6 +293,65 @@ void Population::loadPopulation()
 
 }
 
+void Population::applyRefinementTargets(SpheroidalCellMesh *mesh, const std::set<t_SpatialableAgent_3 *> &agents) const
+{
+    mesh->clearRefinementTargets();
+    if (region_refinement_target_.empty() && cell_refinement_target_.empty())
+        return;
+
+    // the mesh works in CPOP unit
+    double areaConversion = conversionFrmG4ToCPOP*conversionFrmG4ToCPOP;
+
+    // the target of a cell takes precedence over the one of its region
+    std::vector<const t_Cell_3*> cells_without_target;
+    for (const t_SpatialableAgent_3* agent : agents) {
+        auto found_cell = cell_refinement_target_.find(agent->getID());
+        if (found_cell != cell_refinement_target_.end()) {
+            const CellRefinementTarget& target = found_cell->second;
+            mesh->setRefinementTarget(agent->getID(), CellRefinementTarget(target.maxNbFacet, target.maxFacetArea*areaConversion));
+        } else if (const t_Cell_3* cell = dynamic_cast<const t_Cell_3*>(agent)) {
+            cells_without_target.push_back(cell);
+        }
+    }
+
+    if (!region_refinement_target_.empty()) {
+        if (internal_layer_ratio_ < 0 || internal_layer_ratio_ > 1)
+            throw std::runtime_error("InternalLayerRatio should be in [0;1]. Current value : " + to_string(internal_layer_ratio_));
+
+        if (intermediary_layer_ratio_ < 0 || intermediary_layer_ratio_ > 1)
+            throw std::runtime_error("IntermediaryLayerRatio should be in [0;1]. Current value : " + to_string(intermediary_layer_ratio_));
+
+        // regions are only created after the meshing : build them the same way defineRegion will
+        double nearest, farthest;
+        Utils::getNearestAndFarthestPoints(spheroid_centroid_, agents.begin(), agents.end(), nearest, farthest);
+        double spheroidRadius = farthest*conversionFrmCPOPToG4;
+        double internalLayerRadius = spheroidRadius*internal_layer_ratio_;
+        double intermediaryLayerRadius = spheroidRadius*intermediary_layer_ratio_;
+
+        std::vector<SpheroidRegion> regions;
+        regions.reserve(3);
+        regions.emplace_back("Necrosis"    , spheroid_centroid_, 0, internalLayerRadius, cells_without_target.begin(), cells_without_target.end());
+        regions.emplace_back("Intermediary", spheroid_centroid_, internalLayerRadius, intermediaryLayerRadius, cells_without_target.begin(), cells_without_target.end());
+        regions.emplace_back("External"    , spheroid_centroid_, intermediaryLayerRadius, spheroidRadius, cells_without_target.begin(), cells_without_target.end());
+
+        // a cell on the boundary of two regions belongs to the inner one
+        std::set<const t_Cell_3*> assigned_cells;
+        for (const SpheroidRegion& region : regions) {
+            auto found_region = region_refinement_target_.find(region.name());
+            for (const t_Cell_3* cell : region.cells_in_region()) {
+                if (!assigned_cells.insert(cell).second || found_region == region_refinement_target_.end())
+                    continue;
+
+                const CellRefinementTarget& target = found_region->second;
+                mesh->setRefinementTarget(cell->getID(), CellRefinementTarget(target.maxNbFacet, target.maxFacetArea*areaConversion));
+            }
+        }
+    }
+
+    if (verbose_level() > 0)
+        std::cout << "Membrane refinement targets set for " << mesh->getRefinementTargets().size() << " cells" << std::endl;
+}
+
 void Population::printPopulationInfo()
 {
     zz::fs::Path path = "./" + population_file();
@@ -1,6 +1,11 @@
 #include "PopulationMessenger.hh"
 #include "Population.hh"
 
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <stdexcept>
+
 
 
 namespace cpop {
@@ -47,6 +52,54 @@ void PopulationMessenger::BuildCommands(G4String base)
     delta_ref_cmd_->SetRange("DeltaRef >= 0");
     delta_ref_cmd_->AvailableForStates(G4State_PreInit);
 
+    cmd_name = cmd_base + "/meshCache";
+    mesh_cache_cmd_ = std::make_unique<G4UIcmdWithAString>(cmd_name, this);
+    mesh_cache_cmd_->SetGuidance("Set the directory where cell meshes are cached. Jobs on the same population and meshing parameters reuse them");
+    mesh_cache_cmd_->SetParameterName("MeshCache", false);
+    mesh_cache_cmd_->AvailableForStates(G4State_PreInit);
+
+    cmd_name = cmd_base + "/refinementForRegion";
+    refinement_region_cmd_ = std::make_unique<G4UIcommand>(cmd_name, this);
+    refinement_region_cmd_->SetGuidance("Override the membrane refinement of the cells of a region (Necrosis, Intermediary or External)");
+    refinement_region_cmd_->SetGuidance("NumberFacet replaces numberFacet (0 to keep it), facets smaller than MaxFacetArea (um2) are not subdivided (0 to disable)");
+    G4UIparameter* region = new G4UIparameter("Region", 's', false);
+    region->SetParameterCandidates("Necrosis Intermediary External");
+    refinement_region_cmd_->SetParameter(region);
+    refinement_region_cmd_->SetParameter(new G4UIparameter("NumberFacet", 'i', false));
+    refinement_region_cmd_->SetParameter(new G4UIparameter("MaxFacetArea", 'd', false));
+    refinement_region_cmd_->AvailableForStates(G4State_PreInit);
+
+    cmd_name = cmd_base + "/refinementForCell";
+    refinement_cell_cmd_ = std::make_unique<G4UIcommand>(cmd_name, this);
+    refinement_cell_cmd_->SetGuidance("Override the membrane refinement of the cell with the given ID. Takes precedence over refinementForRegion");
+    refinement_cell_cmd_->SetGuidance("NumberFacet replaces numberFacet (0 to keep it), facets smaller than MaxFacetArea (um2) are not subdivided (0 to disable)");
+    refinement_cell_cmd_->SetParameter(new G4UIparameter("CellID", 'i', false));
+    refinement_cell_cmd_->SetParameter(new G4UIparameter("NumberFacet", 'i', false));
+    refinement_cell_cmd_->SetParameter(new G4UIparameter("MaxFacetArea", 'd', false));
+    refinement_cell_cmd_->AvailableForStates(G4State_PreInit);
+
+    cmd_name = cmd_base + "/convexCellSolid";
+    convex_cell_solid_cmd_ = std::make_unique<G4UIcmdWithABool>(cmd_name, this);
+    convex_cell_solid_cmd_->SetGuidance("Export the convex cell membranes as convex polyhedra (navigation from the facet planes) instead of G4TessellatedSolid");
+    convex_cell_solid_cmd_->SetGuidance("Non convex membranes are still exported as G4TessellatedSolid");
+    convex_cell_solid_cmd_->SetParameterName("ConvexCellSolid", true);
+    convex_cell_solid_cmd_->SetDefaultValue(true);
+    convex_cell_solid_cmd_->AvailableForStates(G4State_PreInit);
+
+    cmd_name = cmd_base + "/meshValidation";
+    mesh_validation_cmd_ = std::make_unique<G4UIcmdWithAString>(cmd_name, this);
+    mesh_validation_cmd_->SetGuidance("Check the cell meshes (closure, orientation, facet angles, nuclei containment, overlaps between neighbours) before the transport");
+    mesh_validation_cmd_->SetGuidance("The report and its histograms are written in the given file");
+    mesh_validation_cmd_->SetParameterName("MeshValidationFile", false);
+    mesh_validation_cmd_->AvailableForStates(G4State_PreInit);
+
+    cmd_name = cmd_base + "/removedCellsFile";
+    removed_cells_cmd_ = std::make_unique<G4UIcmdWithAString>(cmd_name, this);
+    removed_cells_cmd_->SetGuidance("Set the file where the IDs of the cells removed for conflicts during the meshing are appended (default IDCell.txt)");
+    removed_cells_cmd_->SetGuidance("Use none to write no file");
+    removed_cells_cmd_->SetParameterName("RemovedCellsFile", false);
+    removed_cells_cmd_->AvailableForStates(G4State_PreInit);
+
     cmd_name = cmd_base + "/internalRatio";
     internal_ratio_cmd_ = std::make_unique<G4UIcmdWithADouble>(cmd_name,this);
     internal_ratio_cmd_->SetGuidance("Set internal layer ratio");
@@ -105,6 +158,36 @@ void PopulationMessenger::SetNewValue(G4UIcommand *command, G4String newValue)
         population_->setNumber_max_facet_poly(number_facet_cmd_->GetNewIntValue(newValue));
     } else if (command == delta_ref_cmd_.get()) {
         population_->setDelta_reffinement(delta_ref_cmd_->GetNewDoubleValue(newValue));
+    } else if (command == mesh_cache_cmd_.get()) {
+        population_->setMesh_cache_directory(newValue.data());
+    } else if (command == refinement_region_cmd_.get()) {
+        std::string region_name;
+        int number_facet;
+        double max_facet_area;
+
+        std::istringstream is(newValue.data());
+        is >> region_name >> number_facet >> max_facet_area;
+
+        if (number_facet < 0)
+            throw std::runtime_error("NumberFacet should be positive. Current value : " + std::to_string(number_facet));
+        population_->setRefinement_target_for_region(region_name, number_facet, max_facet_area*um*um);
+    } else if (command == refinement_cell_cmd_.get()) {
+        int cell_id;
+        int number_facet;
+        double max_facet_area;
+
+        std::istringstream is(newValue.data());
+        is >> cell_id >> number_facet >> max_facet_area;
+
+        if (number_facet < 0)
+            throw std::runtime_error("NumberFacet should be positive. Current value : " + std::to_string(number_facet));
+        population_->setRefinement_target_for_cell(cell_id, number_facet, max_facet_area*um*um);
+    } else if (command == convex_cell_solid_cmd_.get()) {
+        population_->setConvex_cell_solid(convex_cell_solid_cmd_->GetNewBoolValue(newValue));
+    } else if (command == mesh_validation_cmd_.get()) {
+        population_->setMesh_validation_file(newValue.data());
+    } else if (command == removed_cells_cmd_.get()) {
+        population_->setRemoved_cells_file(newValue == "none" ? "" : newValue.data());
     } else if (command == internal_ratio_cmd_.get()) {
         population_->setInternal_layer_ratio(internal_ratio_cmd_->GetNewDoubleValue(newValue));
     } else if (command == intermediary_ratio_cmd_.get()) {
@@ -40,7 +40,7 @@ public:
 
     bool HasLeft() const { return already_generated_ < totalSecondary(); }
     void addDistributedSource(int inc = 1) { number_nano_ += inc; }
-    void AddParticlePosition(OrganellesWeight& organelle_weight)
+    void AddParticlePosition(const OrganellesWeight& organelle_weight)
     { auto organelle = organelle_weight.getRandomOrganelle();
 
     Point_3 pos = Utils::myCGAL::to_G4(cell_->getSpotOnOrganelle(organelle));
@@ -57,6 +57,8 @@ public:
       // G4cout<< "position in cell z: " << position_in_cell_[0].getZ() << G4endl;
       return position_in_cell_;}
 
+    const G4ThreeVector& FrontPosition() const { return position_in_cell_.front(); }
+
     /// \brief Position in cell
     std::vector<G4ThreeVector> position_in_cell_;
 
@@ -83,6 +85,7 @@ public:
     DistributedSource(const std::string& name, const Population& population);
 
     std::vector<G4ThreeVector> GetPosition() override;
+    G4ThreeVector GetPrimaryPosition() override;
     int getID_OfCell();
     void Update() override;
     bool HasLeft() override;
@@ -112,6 +115,12 @@ public:
     void setNumber_source_external(int number_nanoparticle_external);
 
     void setOrganelle_weight(double pCellMembrane, double pNucleoplasm, double pNuclearMembrane, double pCytoplasm );
+    /// \brief Override the organelle weights for the cells of the given region
+    void setOrganelle_weight_for_region(const std::string& region_name, double pCellMembrane, double pNucleoplasm, double pNuclearMembrane, double pCytoplasm );
+    /// \brief Override the organelle weights for the cell with the given ID
+    void setOrganelle_weight_for_cell(int cell_id, double pCellMembrane, double pNucleoplasm, double pNuclearMembrane, double pCytoplasm );
+    /// \brief Return the organelle weights to use for the cell : cell override, then region override, then default weights
+    const OrganellesWeight& organelle_weight(const Settings::nCell::t_Cell_3* cell, const std::string& region_name) const;
 
     std::vector<double> getOrganelle_weight();
 
@@ -175,6 +184,10 @@ private:
     std::unordered_map<const Settings::nCell::t_Cell_3*, NanoInfo>::iterator current_cell_;
     /// \brief Secondary distribution in a cell
     std::unique_ptr<OrganellesWeight> organelle_weight_;
+    /// \brief Secondary distribution in the cells of a region, overriding organelle_weight_
+    std::unordered_map<std::string, OrganellesWeight> region_organelle_weight_;
+    /// \brief Secondary distribution in a given cell, overriding region and default ones
+    std::unordered_map<unsigned long int, OrganellesWeight> cell_organelle_weight_;
     /// \brief Cell labeling percentage, in necrosis region
     double cell_labeling_percentage_necrosis_;
     /// \brief Cell labeling percentage, in intermediary region
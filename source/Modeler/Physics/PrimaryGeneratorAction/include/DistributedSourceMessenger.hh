@@ -37,6 +37,10 @@ private:
     std::unique_ptr<G4UIcmdWith3Vector> nano_per_region_cmd_;
     /// \brief Define the secondaries repartition in a cell
     std::unique_ptr<G4UIcommand> pos_in_cell_cmd_;
+    /// \brief Override the secondaries repartition for the cells of a region
+    std::unique_ptr<G4UIcommand> pos_in_cell_region_cmd_;
+    /// \brief Override the secondaries repartition for one cell
+    std::unique_ptr<G4UIcommand> pos_in_cell_cell_cmd_;
     /// \brief Maximum number of sources per cell to be generated, in each region
     std::unique_ptr<G4UIcmdWith3Vector> max_sources_per_cell_cmd_;
     /// \brief Percentage of labeled cells, in each region
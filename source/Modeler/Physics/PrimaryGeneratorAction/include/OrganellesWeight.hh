@@ -4,60 +4,46 @@
 #include "RandomEngineManager.hh"
 #include "Randomize.hh"
 
-#include <map>
+#include "AliasTable.hh"
 #include "ECellComposition.hh"
 
+#include <array>
 #include <assert.h>
 
 using namespace CellComposition;
 using namespace std;
 //////////////////////////////////////////////////////////////////////////////
 /// \brief the ratio of each organelles.
+/// The organelle is picked in O(1) from an alias table built once at construction.
 struct OrganellesWeight
 {
-	map<double, Organelle> organelleRatios;
+	/// \brief organelle corresponding to each entry of the alias table
+	array<Organelle, 4> organelles;
+	/// \brief alias table on the organelle weights
+	Utils::Statistics::AliasTable organelleTable;
 
 	OrganellesWeight(
 			double pCellMembrane,
 			double pNucleoplasm,
 			double pNuclearMembrane,
-			double pCytoplasm )
+			double pCytoplasm ):
+		organelles{{_CELL_MEMBRANE, _NUCLEOPLASM, _CYTOPLASM, _NUCLEAR_MEMBRANE}},
+		organelleTable({pCellMembrane, pNucleoplasm, pCytoplasm, pNuclearMembrane})
 	{
-		double lSum = pCellMembrane + pNucleoplasm + pNuclearMembrane + pCytoplasm;
-		double weight = pCellMembrane;
-			//G4cout << "/n/n/n weight CELL_MEMBRANE Ratios : " <<  weight/lSum << G4endl;
-    	organelleRatios.insert(make_pair(weight/lSum, _CELL_MEMBRANE ) );
-    	weight += pNucleoplasm;
-			//G4cout << "/n/n/n weight NUCLEOPLASM Ratios : " <<  weight/lSum << G4endl;
-    	organelleRatios.insert(make_pair(weight/lSum, _NUCLEOPLASM ) );
-    	weight += pCytoplasm;
-			//G4cout << "/n/n/n weight CYTOPLASM  Ratios : " <<  weight/lSum << G4endl;
-    	organelleRatios.insert(make_pair(weight/lSum, _CYTOPLASM ) );
-    	weight += pNuclearMembrane;
-			//G4cout << "/n/n/n weight NUCLEAR_MEMBRANE Ratios : " <<  weight/lSum << G4endl;
-    	organelleRatios.insert(make_pair(weight/lSum, _NUCLEAR_MEMBRANE ) );
-
 
 	}
 
-	/// \brief return the organelle corresponding to the given probability
+	/// \brief return the organelle corresponding to the given uniform random number
 	Organelle getOrganelle(double pProba) const
 	{
 		assert(pProba >= 0);
 		assert(pProba <= 1);
-		map<double, Organelle>::const_iterator itOrg = organelleRatios.lower_bound(pProba);
-		assert(itOrg != organelleRatios.end());
-		return itOrg->second;
+		return organelles[organelleTable.sample(pProba)];
 	}
 
     /// \brief return a random organelle using a uniform distribution
     Organelle getRandomOrganelle() const {
-        map<double, Organelle>::const_iterator itOrg;
-        do {
-            itOrg = organelleRatios.lower_bound(G4UniformRand());
-        } while(itOrg == organelleRatios.end());
-
-        return itOrg->second;
+        return organelles[organelleTable.sample(G4UniformRand())];
     }
 
 };
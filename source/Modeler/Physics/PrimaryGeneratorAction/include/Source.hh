@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <random>
+#include <vector>
 
 #include "G4ThreeVector.hh"
 
@@ -45,6 +46,8 @@ public:
     // Not const to let the user change object state (eg keep track of what has been generated)
     /// \brief Generate a random position (in G4 unit)
     virtual std::vector<G4ThreeVector> GetPosition() = 0;
+    /// \brief Generate the position of the next primary (in G4 unit), without allocation when the source allows it
+    virtual G4ThreeVector GetPrimaryPosition() { return GetPosition().front(); }
     /// \brief Called at the end of GeneratePrimaries
     virtual void Update() = 0;
     /// \brief Tell if the source has generated all its particles
@@ -53,8 +56,10 @@ public:
     int line_number_positions_directions_file = 1;
 
 protected:
-    /// \brief Generate uniformely a 3D point on the unit sphere using G.Marsaglia method
+    /// \brief Generate uniformely a 3D point on the unit sphere (exact inversion, no rejection)
     G4ThreeVector randSphere() const;
+    /// \brief Return the point of the unit sphere matching the two given uniform random numbers
+    static G4ThreeVector isotropicDirection(G4double u, G4double v);
 
     const Population *population() const;
 
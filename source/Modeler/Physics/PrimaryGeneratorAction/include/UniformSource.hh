@@ -17,6 +17,7 @@ public:
     void setTotal_particle(int total_particle);
 
     std::vector<G4ThreeVector> GetPosition() override;
+    G4ThreeVector GetPrimaryPosition() override;
     void Update() override;
     bool HasLeft() override;
 
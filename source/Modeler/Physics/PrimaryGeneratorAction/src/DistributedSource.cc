@@ -31,6 +31,11 @@ std::vector<G4ThreeVector> DistributedSource::GetPosition()
     return getPositionInCell();
 }
 
+G4ThreeVector DistributedSource::GetPrimaryPosition()
+{
+    return current_cell_->second.FrontPosition();
+}
+
 void DistributedSource::Update()
 {
     current_cell_->second.Update();
@@ -166,7 +171,7 @@ void DistributedSource::distribute(int number_nano, const SpheroidRegion &region
           if (this->population()->verbose_level() > 0)
               std::cout << " Inserting nanoparticle in cell with id " << selected_cell->getID()  <<'\n';
 
-          cell_nano_.insert({selected_cell, {selected_cell, 1, number_particles_per_source_, *organelle_weight_} });
+          cell_nano_.insert({selected_cell, {selected_cell, 1, number_particles_per_source_, organelle_weight(selected_cell, region.name())} });
           nb_nano_per_cell[indexCell] +=1 ;
         }
         else
@@ -175,7 +180,7 @@ void DistributedSource::distribute(int number_nano, const SpheroidRegion &region
               std::cout << "  Adding nanoparticle to cell with id  " << selected_cell->getID() << '\n';
           already_selected->second.addDistributedSource();
           if (only_one_position_for_all_particles_on_a_cell == 0)
-          {already_selected->second.AddParticlePosition(*organelle_weight_);}
+          {already_selected->second.AddParticlePosition(organelle_weight(selected_cell, region.name()));}
           nb_nano_per_cell[indexCell] +=1 ;
         }
       }
@@ -195,7 +200,7 @@ void DistributedSource::distribute(int number_nano, const SpheroidRegion &region
           if (this->population()->verbose_level() > 0)
               std::cout << "  Inserting nanoparticle in cell with id " << selected_cell->getID()  <<'\n';
 
-          cell_nano_.insert({selected_cell, {selected_cell, 1, number_particles_per_source_, *organelle_weight_} });
+          cell_nano_.insert({selected_cell, {selected_cell, 1, number_particles_per_source_, organelle_weight(selected_cell, region.name())} });
           nb_nano_per_cell[indexCell] +=1 ;
         }
         else
@@ -204,7 +209,7 @@ void DistributedSource::distribute(int number_nano, const SpheroidRegion &region
               std::cout << "  Adding nanoparticle to cell with id  " << selected_cell->getID() << '\n';
           already_selected->second.addDistributedSource();
           if (only_one_position_for_all_particles_on_a_cell == 0)
-          {already_selected->second.AddParticlePosition(*organelle_weight_);}
+          {already_selected->second.AddParticlePosition(organelle_weight(selected_cell, region.name()));}
           nb_nano_per_cell[indexCell] +=1 ;
         }
 
@@ -251,6 +256,34 @@ void DistributedSource::setOrganelle_weight(double pCellMembrane, double pNucleo
     organelle_weight_ = std::make_unique<OrganellesWeight>(pCellMembrane, pNucleoplasm, pNuclearMembrane, pCytoplasm);
 }
 
+void DistributedSource::setOrganelle_weight_for_region(const std::string &region_name, double pCellMembrane, double pNucleoplasm, double pNuclearMembrane, double pCytoplasm)
+{
+    region_organelle_weight_.insert_or_assign(region_name, OrganellesWeight(pCellMembrane, pNucleoplasm, pNuclearMembrane, pCytoplasm));
+}
+
+void DistributedSource::setOrganelle_weight_for_cell(int cell_id, double pCellMembrane, double pNucleoplasm, double pNuclearMembrane, double pCytoplasm)
+{
+    cell_organelle_weight_.insert_or_assign(static_cast<unsigned long int>(cell_id), OrganellesWeight(pCellMembrane, pNucleoplasm, pNuclearMembrane, pCytoplasm));
+}
+
+const OrganellesWeight &DistributedSource::organelle_weight(const Settings::nCell::t_Cell_3 *cell, const std::string &region_name) const
+{
+    if (!cell_organelle_weight_.empty()) {
+        auto it_cell = cell_organelle_weight_.find(cell->getID());
+        if (it_cell != cell_organelle_weight_.end())
+            return it_cell->second;
+    }
+
+    auto it_region = region_organelle_weight_.find(region_name);
+    if (it_region != region_organelle_weight_.end())
+        return it_region->second;
+
+    if (!organelle_weight_)
+        throw std::runtime_error("No secondaries repartition defined for the cells of region " + region_name +
+                                 ". Maybe macro command is missing : /cpop/source/<name>/distributionInCell");
+    return *organelle_weight_;
+}
+
 std::vector<double> DistributedSource::getOrganelle_weight()
 {
   organelle_weight_vector = {emission_in_membrane_, emission_in_nucleus_, emission_in_nucleus_membrane_, emission_cytoplasm_};
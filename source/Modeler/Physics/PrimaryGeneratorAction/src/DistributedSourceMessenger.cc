@@ -51,6 +51,28 @@ void DistributedSourceMessenger::BuildCommands(G4String base)
     pos_in_cell_cmd_->SetParameter(cytoplasm);
     pos_in_cell_cmd_->AvailableForStates(G4State_PreInit, G4State_Idle);
 
+    cmd_base = base + "/distributionInCellForRegion";
+    pos_in_cell_region_cmd_ = std::make_unique<G4UIcommand>(cmd_base, this);
+    pos_in_cell_region_cmd_->SetGuidance("Override the secondaries repartition in the cells of a region (Necrosis, Intermediary or External)");
+    G4UIparameter* region = new G4UIparameter("Region", 's', false);
+    region->SetParameterCandidates("Necrosis Intermediary External");
+    pos_in_cell_region_cmd_->SetParameter(region);
+    pos_in_cell_region_cmd_->SetParameter(new G4UIparameter("CellMembrane", 'd', false));
+    pos_in_cell_region_cmd_->SetParameter(new G4UIparameter("Nucleoplasm", 'd', false));
+    pos_in_cell_region_cmd_->SetParameter(new G4UIparameter("NucleusMembrane", 'd', false));
+    pos_in_cell_region_cmd_->SetParameter(new G4UIparameter("Cytoplasm", 'd', false));
+    pos_in_cell_region_cmd_->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    cmd_base = base + "/distributionInCellForCell";
+    pos_in_cell_cell_cmd_ = std::make_unique<G4UIcommand>(cmd_base, this);
+    pos_in_cell_cell_cmd_->SetGuidance("Override the secondaries repartition in the cell with the given ID");
+    pos_in_cell_cell_cmd_->SetParameter(new G4UIparameter("CellID", 'i', false));
+    pos_in_cell_cell_cmd_->SetParameter(new G4UIparameter("CellMembrane", 'd', false));
+    pos_in_cell_cell_cmd_->SetParameter(new G4UIparameter("Nucleoplasm", 'd', false));
+    pos_in_cell_cell_cmd_->SetParameter(new G4UIparameter("NucleusMembrane", 'd', false));
+    pos_in_cell_cell_cmd_->SetParameter(new G4UIparameter("Cytoplasm", 'd', false));
+    pos_in_cell_cell_cmd_->AvailableForStates(G4State_PreInit, G4State_Idle);
+
     cmd_base = base + "/maxSourcesPerCell";
     max_sources_per_cell_cmd_ = std::make_unique<G4UIcmdWith3Vector>(cmd_base, this);
     max_sources_per_cell_cmd_->SetGuidance("Set the maximum number of sources that can be attached to a cell");
@@ -111,6 +133,30 @@ void DistributedSourceMessenger::SetNewValue(G4UIcommand *command, G4String newV
 
         source_->setOrganelle_weight(cell_membrane, nucleoplasm, nucleo_membrane, cytoplasm);
     }
+    else if (command == pos_in_cell_region_cmd_.get()) {
+        std::string region_name;
+        double cell_membrane;
+        double nucleoplasm;
+        double nucleo_membrane;
+        double cytoplasm;
+
+        std::istringstream is(newValue.data());
+        is >> region_name >> cell_membrane >> nucleoplasm >> nucleo_membrane >> cytoplasm;
+
+        source_->setOrganelle_weight_for_region(region_name, cell_membrane, nucleoplasm, nucleo_membrane, cytoplasm);
+    }
+    else if (command == pos_in_cell_cell_cmd_.get()) {
+        int cell_id;
+        double cell_membrane;
+        double nucleoplasm;
+        double nucleo_membrane;
+        double cytoplasm;
+
+        std::istringstream is(newValue.data());
+        is >> cell_id >> cell_membrane >> nucleoplasm >> nucleo_membrane >> cytoplasm;
+
+        source_->setOrganelle_weight_for_cell(cell_id, cell_membrane, nucleoplasm, nucleo_membrane, cytoplasm);
+    }
     else if (command == max_sources_per_cell_cmd_.get()) {
       G4ThreeVector vec = max_sources_per_cell_cmd_->GetNew3VectorValue(newValue);
       source_->setMax_number_source_per_cell_necrosis(vec.x());
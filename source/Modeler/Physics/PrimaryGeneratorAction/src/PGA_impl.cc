@@ -79,7 +79,7 @@ void PGA_impl::GeneratePrimaries(G4Event *event)
     // Generate an energy
     particleEnergy = source->GetEnergy();
     // Generate a position
-    G4_particle_position = (source->GetPosition()).front();
+    G4_particle_position = source->GetPrimaryPosition();
 
     //TODO : debug the (source->GetPosition()) call when multiple sources are used in one simulation
     //(source->GetPosition()) value is well attributed in DistributedSource GetPosition(), but the call is PGA_impl.cc fails.
@@ -6,7 +6,11 @@
 #include "Population.hh"
 
 #include "G4IonTable.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
 
+#include <algorithm>
+#include <cmath>
 
 namespace cpop {
 
@@ -65,14 +69,18 @@ G4ThreeVector Source::GetMomentum() const
 
 G4ThreeVector Source::randSphere() const
 {
-    G4double v1, v2, S;
-    do {
-      v1 = 2.*G4UniformRand() - 1.;
-      v2 = 2.*G4UniformRand() - 1.;
-      S = v1*v1 + v2*v2;
-    } while (S > 1.);
-    G4double k = std::sqrt(1. - S);
-    return G4ThreeVector(2*v1*k, 2*v2*k, 1 - 2*S);
+    G4double u = G4UniformRand();
+    G4double v = G4UniformRand();
+    return isotropicDirection(u, v);
+}
+
+G4ThreeVector Source::isotropicDirection(G4double u, G4double v)
+{
+    // cos(theta) is uniform on [-1, 1] for an isotropic distribution
+    G4double cos_theta = 1. - 2.*u;
+    G4double sin_theta = std::sqrt(std::max(0., 1. - cos_theta*cos_theta));
+    G4double phi = CLHEP::twopi*v;
+    return G4ThreeVector(sin_theta*std::cos(phi), sin_theta*std::sin(phi), cos_theta);
 }
 
 const Population *Source::population() const
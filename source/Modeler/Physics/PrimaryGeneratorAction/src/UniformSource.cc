@@ -3,6 +3,8 @@
 #include "Population.hh"
 #include "Randomize.hh"
 
+#include <cmath>
+
 namespace cpop {
 
 UniformSource::UniformSource(const string &name, const Population &population)
@@ -23,6 +25,13 @@ void UniformSource::setTotal_particle(int total_particle)
 }
 
 std::vector<G4ThreeVector> UniformSource::GetPosition()
+{
+    std::vector<G4ThreeVector> position = {GetPrimaryPosition()};
+
+    return position;
+}
+
+G4ThreeVector UniformSource::GetPrimaryPosition()
 {
     G4double spheroid_radius = this->population()->spheroid_radius();
 
@@ -30,16 +39,11 @@ std::vector<G4ThreeVector> UniformSource::GetPosition()
     G4ThreeVector spheroid_centroid(center.x(), center.y(), center.z());
 
     //Get a random point on the unit sphere surface
-    G4ThreeVector position_0 = this->randSphere();
+    G4ThreeVector position = this->randSphere();
     // Generate a random radius in [0, spheroid_radius]
-    G4double radius = std::pow(G4UniformRand(), 1.0/3.0) * spheroid_radius;
+    G4double radius = std::cbrt(G4UniformRand()) * spheroid_radius;
     // Scale and translate position
-    position_0 *= radius;
-    position_0 += spheroid_centroid;
-
-    std::vector<G4ThreeVector> position = {position_0};
-
-    return position;
+    return position*radius + spheroid_centroid;
 }
 
 void UniformSource::Update()
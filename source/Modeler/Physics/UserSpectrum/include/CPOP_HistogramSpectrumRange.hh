@@ -10,7 +10,7 @@ class CPOP_HistogramSpectrumRange : public CPOP_SpectrumRange
 {
 public:
 	/// \brief constructor
-	CPOP_HistogramSpectrumRange(pair<G4float, G4double> pLowBound, pair<G4float, G4double> pLighBound);
+	CPOP_HistogramSpectrumRange(pair<G4double, G4double> pLowBound, pair<G4double, G4double> pHighBound);
 	/// \brief destructor
 	~CPOP_HistogramSpectrumRange();
 
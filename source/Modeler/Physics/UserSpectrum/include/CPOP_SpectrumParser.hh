@@ -0,0 +1,68 @@
+#ifndef CPOP_SPECTRUM_PARSER_HH
+#define CPOP_SPECTRUM_PARSER_HH
+
+#include "globals.hh"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// \brief error raised when a spectrum file is malformed. The message is prefixed by
+/// "source:line:column:" so the faulty entry can be found directly in the file.
+/////////////////////////////////////////////////////////////////////////////////////////
+class CPOP_SpectrumParseError : public std::runtime_error
+{
+public:
+	CPOP_SpectrumParseError(const string& pSource, size_t pLine, size_t pColumn, const string& pMessage);
+
+	const string& source() const	{ return sourceName; }
+	size_t line() const				{ return lineNumber; }
+	size_t column() const			{ return columnNumber; }
+
+private:
+	string sourceName;
+	size_t lineNumber;
+	size_t columnNumber;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// \brief raw content of a spectrum file, energies are expressed in G4 units (MeV)
+/////////////////////////////////////////////////////////////////////////////////////////
+struct CPOP_SpectrumData
+{
+	/// \brief 1 : discrete, 2 : histogram, 3 : interpolated
+	G4int mode = 0;
+	/// \brief lower energy of the first bin (histogram spectrum)
+	G4double emin = 0.;
+	/// \brief energies, strictly increasing for histogram and interpolated spectrums
+	vector<G4double> energies;
+	/// \brief probability (discrete) or probability density (histogram, interpolated) of each energy
+	vector<G4double> probas;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// \brief single pass parser of the CPOP spectrum format :
+///
+///		# comment
+///		<number of lines> <mode> <emin>
+///		<energy> <proba>
+///		...
+///
+/// '#' starts a comment running to the end of the line, blank lines are ignored.
+/// Energies (and emin) can be followed by a unit (eV, keV, MeV, GeV), MeV otherwise.
+/// A number of lines set to 0 means "read until the end of the file", which is handy
+/// for large tabulated spectrums (ICRP-107 like).
+/////////////////////////////////////////////////////////////////////////////////////////
+class CPOP_SpectrumParser
+{
+public:
+	/// \brief parse the given file. Throw CPOP_SpectrumParseError if malformed
+	static CPOP_SpectrumData parseFile(const string& pFile);
+	/// \brief parse the given content. pSource is only used for diagnostics
+	static CPOP_SpectrumData parseString(const string& pContent, const string& pSource = "<string>");
+};
+
+#endif // CPOP_SPECTRUM_PARSER_HH
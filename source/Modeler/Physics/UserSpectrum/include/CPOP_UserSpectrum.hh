@@ -3,35 +3,52 @@
 
 #include "globals.hh"
 #include "CPOP_SpectrumRange.hh"
-#include <map>
+#include "CPOP_SpectrumParser.hh"
+#include <vector>
 
 using namespace std;
 
 /////////////////////////////////////////////////////////////////////////////
-///
+/// \brief energy spectrum defined by the user. File format is described
+/// in CPOP_SpectrumParser. Throw at construction if the spectrum is malformed.
 /////////////////////////////////////////////////////////////////////////////
 class CPOP_UserSpectrum
 {
 public:
 		CPOP_UserSpectrum(G4String file_to_read);
+		CPOP_UserSpectrum(const CPOP_SpectrumData& data, const string& source = "<data>");
 		~CPOP_UserSpectrum();
+
+		CPOP_UserSpectrum(const CPOP_UserSpectrum&) = delete;
+		CPOP_UserSpectrum& operator=(const CPOP_UserSpectrum&) = delete;
+
 		G4double GetEnergy() const;
 		G4double GetEnergy(G4double, G4double) const;
 
+		G4int getMode() const						{ return mode; }
+		/// \brief return the total probability read, before normalization
+		G4double getTotalProbability() const		{ return sum_proba; }
+		/// \brief return true if the total probability read was 1
+		bool isNormalized() const					{ return normalized; }
+		size_t getNbRanges() const					{ return spectrumRanges.size(); }
+		const CPOP_SpectrumRange* getRange(size_t i) const	{ return spectrumRanges[i]; }
+
 private:
-	void uniformProbabilities(G4double ratio);
+	/// \brief create the spectrum ranges from the parsed data
+	void buildRanges(const CPOP_SpectrumData& data);
+	/// \brief normalize ranges and make sure they are contiguous on [0, 1]. Warn if the spectrum was not normalized
+	void normalizeRanges(const string& source);
+	/// \brief return the index of the range containing the given probability
+	size_t findRange(G4double proba) const;
 
 private:
-		//void Construct(G4String file_to_read);
 		G4int mode;
-		G4float emin_spectrum;
-		G4int   dim_spectrum;
-		G4float sum_proba;
-		G4float* tab_proba;
-		G4float* tab_sumproba;
-		G4float* tab_energy;
-		/// \brief map linking th ehigher proba 
-		map<G4double, CPOP_SpectrumRange*> mapToSpectrumRanges;
+		G4double sum_proba;
+		bool normalized;
+		/// \brief spectrum ranges, ordered by probability
+		vector<CPOP_SpectrumRange*> spectrumRanges;
+		/// \brief probability high bound of each range (same order as spectrumRanges)
+		vector<G4double> probaHighBounds;
 };
 
 #endif // CPOP_USER_SPECTRUM_H
@@ -4,7 +4,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-CPOP_HistogramSpectrumRange::CPOP_HistogramSpectrumRange(pair<G4float, G4double> pLowBound, pair<G4float, G4double> pHighBound):
+CPOP_HistogramSpectrumRange::CPOP_HistogramSpectrumRange(pair<G4double, G4double> pLowBound, pair<G4double, G4double> pHighBound):
 	CPOP_SpectrumRange(pLowBound.first, pHighBound.first)
 {
 	energyLowBound = pLowBound.second;
@@ -0,0 +1,315 @@
+#include "CPOP_SpectrumParser.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static string formatParseError(const string& pSource, size_t pLine, size_t pColumn, const string& pMessage)
+{
+	ostringstream oss;
+	oss << pSource << ":" << pLine << ":" << pColumn << ": " << pMessage;
+	return oss.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPOP_SpectrumParseError::CPOP_SpectrumParseError(const string& pSource, size_t pLine, size_t pColumn, const string& pMessage):
+	std::runtime_error(formatParseError(pSource, pLine, pColumn, pMessage)),
+	sourceName(pSource),
+	lineNumber(pLine),
+	columnNumber(pColumn)
+{
+
+}
+
+namespace
+{
+	/// \brief a whitespace separated token of the current line
+	struct Token
+	{
+		const char* begin;
+		const char* end;
+		size_t column;
+	};
+
+	/// \brief state of the parser on the current record
+	struct RecordReader
+	{
+		const string& source;
+		size_t line;
+		const vector<Token>& tokens;
+		size_t current;
+
+		[[noreturn]] void fail(size_t pColumn, const string& pMessage) const
+		{
+			throw CPOP_SpectrumParseError(source, line, pColumn, pMessage);
+		}
+
+		/// \brief column just after the last token, used to report missing values
+		size_t endColumn() const
+		{
+			if(tokens.empty()) return 1;
+			return tokens.back().column + (tokens.back().end - tokens.back().begin);
+		}
+
+		/// \brief read a number. pSuffix receives any character attached after the number
+		G4double readNumber(const char* pWhat, string& pSuffix)
+		{
+			if(current >= tokens.size())
+			{
+				fail(endColumn(), string("missing ") + pWhat);
+			}
+
+			const Token& tok = tokens[current++];
+			// the buffer is null terminated and tokens end on a blank, a comment or the end of line
+			// so strtod can not run past the token
+			char* numberEnd = nullptr;
+			errno = 0;
+			G4double value = strtod(tok.begin, &numberEnd);
+			if(numberEnd == tok.begin || numberEnd > tok.end)
+			{
+				fail(tok.column, string("expected ") + pWhat + ", found '" + string(tok.begin, tok.end) + "'");
+			}
+			if(errno == ERANGE || !std::isfinite(value))
+			{
+				fail(tok.column, string(pWhat) + " is out of range : '" + string(tok.begin, tok.end) + "'");
+			}
+			pSuffix.assign(static_cast<const char*>(numberEnd), tok.end);
+			return value;
+		}
+
+		/// \brief read a number which must be a strict integer
+		G4int readInteger(const char* pWhat)
+		{
+			size_t column = current < tokens.size() ? tokens[current].column : endColumn();
+			string suffix;
+			G4double value = readNumber(pWhat, suffix);
+			if(!suffix.empty() || value != std::floor(value) || std::fabs(value) > 2147483647.)
+			{
+				fail(column, string(pWhat) + " should be an integer");
+			}
+			return static_cast<G4int>(value);
+		}
+
+		/// \brief read an energy, with an optional unit either attached or as next token
+		G4double readEnergy(const char* pWhat)
+		{
+			size_t column = current < tokens.size() ? tokens[current].column : endColumn();
+			string unit;
+			G4double value = readNumber(pWhat, unit);
+			size_t unitColumn = column;
+			if(unit.empty() && current < tokens.size() && isalpha(static_cast<unsigned char>(*tokens[current].begin)))
+			{
+				unit.assign(tokens[current].begin, tokens[current].end);
+				unitColumn = tokens[current].column;
+				++current;
+			}
+
+			if(unit.empty() || unit == "MeV")	return value*MeV;
+			if(unit == "keV")					return value*keV;
+			if(unit == "eV")					return value*eV;
+			if(unit == "GeV")					return value*GeV;
+			fail(unitColumn, "unknown energy unit '" + unit + "' (expected eV, keV, MeV or GeV)");
+		}
+
+		/// \brief read a probability which must be a positive number
+		G4double readProba(const char* pWhat)
+		{
+			size_t column = current < tokens.size() ? tokens[current].column : endColumn();
+			string suffix;
+			G4double value = readNumber(pWhat, suffix);
+			if(!suffix.empty())
+			{
+				fail(column, string("unexpected characters after ") + pWhat + " : '" + suffix + "'");
+			}
+			if(value < 0.)
+			{
+				fail(column, string(pWhat) + " can't be negative");
+			}
+			return value;
+		}
+
+		/// \brief make sure the whole record has been consumed
+		void checkEnd() const
+		{
+			if(current < tokens.size())
+			{
+				fail(tokens[current].column, "unexpected value '" + string(tokens[current].begin, tokens[current].end) + "'");
+			}
+		}
+	};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPOP_SpectrumData CPOP_SpectrumParser::parseFile(const string& pFile)
+{
+	ifstream file(pFile, ios::in | ios::binary);
+	if(!file)
+	{
+		throw std::runtime_error("failed to open spectrum file : " + pFile);
+	}
+
+	// read the whole file at once, large spectrums are then parsed without any further IO
+	string content;
+	file.seekg(0, ios::end);
+	streamoff size = file.tellg();
+	if(size > 0)
+	{
+		content.resize(static_cast<size_t>(size));
+		file.seekg(0, ios::beg);
+		file.read(&content[0], size);
+	}
+	if(file.bad())
+	{
+		throw std::runtime_error("failed to read spectrum file : " + pFile);
+	}
+
+	return parseString(content, pFile);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPOP_SpectrumData CPOP_SpectrumParser::parseString(const string& pContent, const string& pSource)
+{
+	CPOP_SpectrumData data;
+
+	G4int nbExpected = -1;			// -1 until the header has been read, 0 for "until end of file"
+	size_t headerLine = 0;
+	G4double sumProba = 0.;
+
+	vector<Token> tokens;
+	const char* cursor = pContent.c_str();
+	const char* end = cursor + pContent.size();
+	size_t line = 0;
+
+	while(cursor < end)
+	{
+		++line;
+		const char* lineBegin = cursor;
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		if(lineEnd == nullptr) lineEnd = end;
+		cursor = lineEnd + 1;
+
+		// split the line, stopping on comments
+		tokens.clear();
+		const char* c = lineBegin;
+		while(c < lineEnd && *c != '#')
+		{
+			if(*c == ' ' || *c == '\t' || *c == '\r' || *c == '\v' || *c == '\f')
+			{
+				++c;
+				continue;
+			}
+			Token tok{c, c, static_cast<size_t>(c - lineBegin) + 1};
+			while(c < lineEnd && *c != '#' && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\v' && *c != '\f')
+			{
+				++c;
+			}
+			tok.end = c;
+			tokens.push_back(tok);
+		}
+
+		if(tokens.empty())
+		{
+			continue;
+		}
+
+		RecordReader reader{pSource, line, tokens, 0};
+
+		// header
+		if(nbExpected < 0)
+		{
+			nbExpected = reader.readInteger("number of lines");
+			if(nbExpected < 0)
+			{
+				reader.fail(tokens[0].column, "number of lines can't be negative");
+			}
+			size_t modeColumn = reader.current < tokens.size() ? tokens[reader.current].column : reader.endColumn();
+			data.mode = reader.readInteger("spectrum mode");
+			if(data.mode < 1 || data.mode > 3)
+			{
+				reader.fail(modeColumn, "unknown spectrum mode " + to_string(data.mode) + " (expected 1 : discrete, 2 : histogram or 3 : interpolated)");
+			}
+			data.emin = reader.readEnergy("minimal energy");
+			reader.checkEnd();
+
+			headerLine = line;
+			if(nbExpected > 0)
+			{
+				data.energies.reserve(nbExpected);
+				data.probas.reserve(nbExpected);
+			}
+			continue;
+		}
+
+		if(nbExpected > 0 && static_cast<G4int>(data.energies.size()) == nbExpected)
+		{
+			reader.fail(tokens[0].column, "more entries than the " + to_string(nbExpected) + " announced at line " + to_string(headerLine));
+		}
+
+		G4double energy = reader.readEnergy("energy");
+		G4double proba = reader.readProba("probability");
+		reader.checkEnd();
+
+		if(energy < 0.)
+		{
+			reader.fail(tokens[0].column, "energy can't be negative");
+		}
+		// histogram and interpolated ranges are built between consecutive energies : they must not overlap
+		if(data.mode != 1 && !data.energies.empty() && energy <= data.energies.back())
+		{
+			reader.fail(tokens[0].column, "energies must be strictly increasing (overlapping range)");
+		}
+		if(data.mode == 2 && data.energies.empty() && energy <= data.emin)
+		{
+			reader.fail(tokens[0].column, "first energy of an histogram must be greater than the minimal energy");
+		}
+
+		data.energies.push_back(energy);
+		data.probas.push_back(proba);
+		sumProba += proba;
+	}
+
+	// position of the end of file, used to report missing entries
+	size_t eofColumn = 1;
+	if(!pContent.empty() && pContent.back() != '\n')
+	{
+		size_t lastLineBreak = pContent.rfind('\n');
+		eofColumn = pContent.size() - (lastLineBreak == string::npos ? 0 : lastLineBreak + 1) + 1;
+	}else
+	{
+		++line;
+	}
+
+	if(nbExpected < 0)
+	{
+		throw CPOP_SpectrumParseError(pSource, line, eofColumn, "missing spectrum header");
+	}
+	if(nbExpected > 0 && static_cast<G4int>(data.energies.size()) != nbExpected)
+	{
+		throw CPOP_SpectrumParseError(pSource, line, eofColumn,
+			"expected " + to_string(nbExpected) + " entries, found " + to_string(data.energies.size()));
+	}
+	if(data.energies.empty() || (data.mode == 3 && data.energies.size() < 2))
+	{
+		throw CPOP_SpectrumParseError(pSource, line, eofColumn, "not enough entries to define a spectrum");
+	}
+	if(sumProba <= 0.)
+	{
+		throw CPOP_SpectrumParseError(pSource, headerLine, 1, "all probabilities are null");
+	}
+
+	return data;
+}
@@ -1,194 +1,190 @@
 #include "CPOP_UserSpectrum.hh"
+#include "G4Exception.hh"
 #include "Randomize.hh"
 
 #include "CPOP_DiscreteSpectrumRange.hh"
 #include "CPOP_HistogramSpectrumRange.hh"
 #include "CPOP_InterpolatedSpectrumRange.hh"
 
-#include <set>
+#include <algorithm>
+#include <stdexcept>
+
+/// \brief relative tolerance on the total probability of a normalized spectrum
+static const G4double NORMALIZATION_TOLERANCE = 1e-6;
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-CPOP_UserSpectrum::CPOP_UserSpectrum(G4String file_to_read){
-	G4int nline;
-	G4double proba_read;
-	G4double previous_proba;
-	G4double energy_read;
+CPOP_UserSpectrum::CPOP_UserSpectrum(G4String file_to_read):
+	CPOP_UserSpectrum(CPOP_SpectrumParser::parseFile(file_to_read), file_to_read)
+{
 
-	// Read energy and proba
-	FILE *file;
-	file=fopen(file_to_read,"r");
-	if(file == NULL)
-	{
-		std::cout << "failed to open file : " << file_to_read << std::endl;
-	}
-	int nbByteRead = fscanf(file,"%i %i %f",&dim_spectrum,&mode,&emin_spectrum);
+}
 
-	if(nbByteRead < 0 )
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPOP_UserSpectrum::CPOP_UserSpectrum(const CPOP_SpectrumData& data, const string& source):
+	mode(data.mode),
+	sum_proba(0.),
+	normalized(false)
+{
+	try
 	{
-		std::cout << "fail to read the given spectrum\n";
-		exit(0);
-	}
-
-	switch(mode)
+		buildRanges(data);
+		normalizeRanges(source);
+	}catch(...)
 	{
-		case 1:
-		{
-                        //G4cout << "Discrete spectrum" << G4endl;
-			break;
-		}
-		case 2:
-		{
-                        //G4cout << "Histogram spectrum" << G4endl;
-			break;
-		}
-		case 3:
-		{
-                        //G4cout << "Interpolated spectrum" << G4endl;
-			break;
-		}
-		default:
+		for(auto range : spectrumRanges)
 		{
-                        //G4cout << "Mode not recognized, check spectrum file!" << G4endl;
-			exit(1);
+			delete range;
 		}
+		throw;
 	}
+}
 
-	sum_proba = 0.;
-	previous_proba = -1.;
-	G4double previous_sum_proba = 0.;
-	G4double previousEnergy = 0.;
-	set<CPOP_SpectrumRange*> spectrumRanges;
-
-	G4double probaLowBound = 0.; 	// used for case 2 only ( histogram )
-	G4double probaHighBound = 0.;	// used for case 2 only ( histogram )
-
-	G4double previousEnergy2 = -1.; 	// used for casz 3 only ( Interpolaed ). Is the previous previous energy
-
-	for(nline=0;nline<dim_spectrum;nline++)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CPOP_UserSpectrum::~CPOP_UserSpectrum()
+{
+	for(auto range : spectrumRanges)
 	{
-		nbByteRead = fscanf(file,"%lf %lf",&energy_read,&proba_read);
-		// if probability is null
-		if(proba_read <= 0.)
-		{
-			continue;
-		}
+		delete range;
+	}
+	spectrumRanges.clear();
+}
 
-		if(nbByteRead < 0 )
-		{
-			std::cout << "fail to rad the given spectrum\n";
-			exit(0);
-		}
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief each range covers [sum_proba, sum_proba + weight]. Ranges with a null weight can never be picked
+/// and are not created.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void CPOP_UserSpectrum::buildRanges(const CPOP_SpectrumData& data)
+{
+	const vector<G4double>& energies = data.energies;
+	const vector<G4double>& probas = data.probas;
+	spectrumRanges.reserve(energies.size());
 
+	sum_proba = 0.;
+	for(size_t i = 0; i < energies.size(); ++i)
+	{
 		switch(mode)
 		{
 			// case Discrete spectrum
 			case 1:
 			{
+				if(probas[i] <= 0.)
+				{
+					break;
+				}
 				// discrete case : lowEnergyBound and high energy bound are the same
-				spectrumRanges.insert( new CPOP_DiscreteSpectrumRange(make_pair(sum_proba, energy_read), make_pair(sum_proba+proba_read, energy_read)) );
-				sum_proba += proba_read;
+				spectrumRanges.push_back(new CPOP_DiscreteSpectrumRange(make_pair(sum_proba, energies[i]), make_pair(sum_proba + probas[i], energies[i])));
+				sum_proba += probas[i];
 				break;
 			}
-			// case histogram spectrum
+			// case histogram spectrum : probas[i] is the density on ]energies[i-1], energies[i]]
 			case 2:
 			{
-				G4double lowEnergyBound;
-
-				// store the first element differently
-				if(nline == 0)
-				{
-					lowEnergyBound = emin_spectrum;
-
-					probaLowBound = 0.;
-					probaHighBound = proba_read*(energy_read - emin_spectrum);
-				}else
+				G4double lowEnergyBound = (i == 0) ? data.emin : energies[i-1];
+				G4double weight = probas[i]*(energies[i] - lowEnergyBound);
+				if(weight <= 0.)
 				{
-					lowEnergyBound = previousEnergy;
-
-					probaLowBound = probaHighBound;
-					probaHighBound += (energy_read - previousEnergy)*proba_read;
+					break;
 				}
-				// cout << "@creation : probas : " << probaLowBound << "-" << probaHighBound << ", energies : " << lowEnergyBound << "-" << energy_read << endl;
-				spectrumRanges.insert( new CPOP_HistogramSpectrumRange(make_pair(probaLowBound, lowEnergyBound), make_pair(probaHighBound, energy_read)));
-				sum_proba = probaHighBound;
+				spectrumRanges.push_back(new CPOP_HistogramSpectrumRange(make_pair(sum_proba, lowEnergyBound), make_pair(sum_proba + weight, energies[i])));
+				sum_proba += weight;
 				break;
 			}
-			// case interpolated spectrum
+			// case interpolated spectrum : the density is linear between two consecutive energies
 			case 3:
 			{
-				// the first range comporte himself as an histogramSpectrumRange
-				if(nline > 0)
+				if(i == 0)
+				{
+					break;
+				}
+				G4double lA = energies[i-1];
+				G4double lB = energies[i];
+				G4double weight = 0.5*(lB - lA)*(probas[i-1] + probas[i]);
+				if(weight <= 0.)
 				{
-					previous_sum_proba = sum_proba;
-					sum_proba += (energy_read - previousEnergy)*previous_proba-0.5*(energy_read - previousEnergy)*(previous_proba - proba_read);
-
-					// if same probabilities
-					if(proba_read == previous_proba)
-					{
-						// if no previousEnergy2 setted yet :
-						if(nline == 1)
-						{
-							spectrumRanges.insert( new CPOP_HistogramSpectrumRange(make_pair(0., emin_spectrum), make_pair(sum_proba, previousEnergy)));
-						}else
-						{
-							spectrumRanges.insert(new CPOP_HistogramSpectrumRange(make_pair(previous_sum_proba, previousEnergy2), make_pair(sum_proba, previousEnergy)));
-						}
-					}else
-					{
-						G4double lAlpha = (proba_read - previous_proba) / (energy_read - previousEnergy) ;
-						G4double lBeta = proba_read - energy_read*lAlpha;
-						G4double lA = previousEnergy;
-						G4double lB = energy_read;
-						G4double lGamma = (lAlpha/2.)*(lB*lB-lA*lA)+lBeta*(lB-lA) ;
-						spectrumRanges.insert( new CPOP_InterpolatedSpectrumRange(make_pair(previous_sum_proba, sum_proba), lAlpha, lBeta, lGamma, lA, lB));
-					}
+					break;
 				}
-				previousEnergy2 = previousEnergy;
+
+				// if same probabilities the density is flat on [lA, lB]
+				if(probas[i] == probas[i-1])
+				{
+					spectrumRanges.push_back(new CPOP_HistogramSpectrumRange(make_pair(sum_proba, lA), make_pair(sum_proba + weight, lB)));
+				}else
+				{
+					G4double lAlpha = (probas[i] - probas[i-1]) / (lB - lA);
+					G4double lBeta = probas[i] - lB*lAlpha;
+					G4double lGamma = (lAlpha/2.)*(lB*lB-lA*lA)+lBeta*(lB-lA);
+					spectrumRanges.push_back(new CPOP_InterpolatedSpectrumRange(make_pair(sum_proba, sum_proba + weight), lAlpha, lBeta, lGamma, lA, lB));
+				}
+				sum_proba += weight;
 				break;
 			}
+			default:
+			{
+				throw std::invalid_argument("CPOP_UserSpectrum: unknown spectrum mode " + to_string(mode));
+			}
 		}
-		previousEnergy = energy_read;
-		previous_proba = proba_read;
 	}
+}
 
-	fclose(file);
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \details a spectrum whose total probability differs from 1 is still used, divided by
+/// its total probability, but a warning is raised.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void CPOP_UserSpectrum::normalizeRanges(const string& source)
+{
+	if(spectrumRanges.empty() || !(sum_proba > 0.))
+	{
+		throw std::runtime_error(source + ": spectrum has a null total probability");
+	}
 
-	// uniformize proba
+	normalized = std::abs(sum_proba - 1.) <= NORMALIZATION_TOLERANCE;
+	if(!normalized)
 	{
-		set<CPOP_SpectrumRange*>::iterator itSpec;
-		for(itSpec = spectrumRanges.begin(); itSpec != spectrumRanges.end(); ++itSpec)
-		{
-			(*itSpec)->setProbaLowBound( (*itSpec)->getProbaLowBound()/sum_proba);
-			(*itSpec)->setProbaHighBound((*itSpec)->getProbaHighBound()/sum_proba);
-		}
+		G4ExceptionDescription description;
+		description << source << ": spectrum is not normalized (total probability = " << sum_proba
+			<< "), probabilities are divided by the total probability";
+		G4Exception("CPOP_UserSpectrum::normalizeRanges", "UserSpectrum001", JustWarning, description);
 	}
 
-	// create the map stored by the proba sum ( high bound )
+	probaHighBounds.clear();
+	probaHighBounds.reserve(spectrumRanges.size());
+
+	G4double previousHighBound = 0.;
+	for(size_t i = 0; i < spectrumRanges.size(); ++i)
 	{
+		CPOP_SpectrumRange* range = spectrumRanges[i];
+		G4double lowBound = range->getProbaLowBound()/sum_proba;
+		G4double highBound = range->getProbaHighBound()/sum_proba;
 
-		set<CPOP_SpectrumRange*>::iterator itSpec;
-		for(itSpec = spectrumRanges.begin(); itSpec != spectrumRanges.end(); ++itSpec)
+		// ranges are created back to back : any gap or overlap would make us sample garbage
+		if(std::abs(lowBound - previousHighBound) > 1e-9 || highBound < lowBound)
 		{
-			mapToSpectrumRanges.insert(make_pair(
-				(*itSpec)->getProbaHighBound(),
-				(*itSpec)
-				));
+			throw std::runtime_error(source + ": spectrum ranges are not contiguous (range " + to_string(i) + ")");
 		}
+
+		range->setProbaLowBound(previousHighBound);
+		range->setProbaHighBound(highBound);
+		probaHighBounds.push_back(highBound);
+		previousHighBound = highBound;
 	}
+
+	// make sure any probability in [0, 1] finds a range
+	probaHighBounds.back() = 1.;
+	spectrumRanges.back()->setProbaHighBound(1.);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-CPOP_UserSpectrum::~CPOP_UserSpectrum()
+size_t CPOP_UserSpectrum::findRange(G4double proba) const
 {
-	map<G4double, CPOP_SpectrumRange*>::iterator itSpec;
-	for(itSpec = mapToSpectrumRanges.begin(); itSpec != mapToSpectrumRanges.end(); ++itSpec)
-	{
-		delete itSpec->second;
-	}
-	mapToSpectrumRanges.clear();
+	return std::lower_bound(probaHighBounds.begin(), probaHighBounds.end(), proba) - probaHighBounds.begin();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -197,17 +193,14 @@ CPOP_UserSpectrum::~CPOP_UserSpectrum()
 G4double CPOP_UserSpectrum::GetEnergy() const
 {
 	G4double my_rndm=G4UniformRand();
-
-	map<G4double, CPOP_SpectrumRange*>::const_iterator itRange = mapToSpectrumRanges.lower_bound(my_rndm);
-    while (itRange == mapToSpectrumRanges.end())
+	size_t iRange = findRange(my_rndm);
+	while(iRange == spectrumRanges.size())
 	{
-        my_rndm = G4UniformRand();
-        itRange = mapToSpectrumRanges.lower_bound(my_rndm);
+		my_rndm = G4UniformRand();
+		iRange = findRange(my_rndm);
 	}
 
-	// G4cout<< "\n Energie tirée 1 = " << itRange->second->computeEnergy() <<  "\n" << G4endl;
-
-	return itRange->second->computeEnergy();
+	return spectrumRanges[iRange]->computeEnergy();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -215,14 +208,12 @@ G4double CPOP_UserSpectrum::GetEnergy() const
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 G4double CPOP_UserSpectrum::GetEnergy(G4double my_rndm, G4double secondRnd) const
 {
-	map<G4double, CPOP_SpectrumRange*>::const_iterator itRange = mapToSpectrumRanges.lower_bound(my_rndm);
-	if(itRange == mapToSpectrumRanges.end())
+	size_t iRange = findRange(my_rndm);
+	if(iRange == spectrumRanges.size())
 	{
-                //G4cout << "CPOP_UserSpectrum::GetEnergy, havn't found energy for the shooted probability : ! " << my_rndm << G4endl;
+		//G4cout << "CPOP_UserSpectrum::GetEnergy, havn't found energy for the shooted probability : ! " << my_rndm << G4endl;
 		return 0.;
 	}
 
-	// G4cout<< "\n Energie tirée 2 \n" << itRange->second->GetEnergy(secondRnd) << G4endl;
-
-	return itRange->second->GetEnergy(secondRnd);
+	return spectrumRanges[iRange]->GetEnergy(secondRnd);
 }
@@ -21,6 +21,7 @@ extern unsigned int NUCLEUS_SPHERE_NB_POINT; // = 8;// MIN_SPHERE_NB_POINT;
 static const unsigned int MIN_NB_CELL_PER_THREAD= 600;							///<\brief number of cell each thread contains	
 static const unsigned int MIN_DISC_POINT 		= 8;							///< \brief the number of points a cell mesh discribed by a disc must contained
 static const bool REMOVE_SMALLEST_WEIGHT	 	= false;						///< \brief the polity of removal for conflict cells on Delaunay triangulation
+static const QString REMOVED_CELLS_FILE			= "IDCell.txt";					///< \brief default file where the IDs of cells removed for conflicts are appended. Empty to disable
 static const QString cellNamePrefix				= "cell_";
 static const QString nucleusNamePrefix			= "nucleus_";
 static const bool USE_THREAD_FOR_MESH_SUBDVN 	= true;							/// \brief do we want to use thread for subdivision. To optimize must be set to true, but for some profiler must be set to false.
@@ -13,8 +13,12 @@ See LICENSE.md for further details
 #include "MeshOutFormats.hh"
 
 #include <iostream>
+#include <map>
+#include <set>
 #include <vector>
 
+class SpheroidalCell;
+
 using namespace std;
 using namespace Settings::nCell;
 
@@ -32,6 +36,92 @@ namespace Statistics
     void writeCellStatsHeader(MeshOutFormats::outputFormat pFormat, ofstream* pOut);
     /// \brief create header fot the cell nuclei statistic file
     void writeCellNucleiStatsHeader(MeshOutFormats::outputFormat pFormat, ofstream* pOut);
+
+    //////////////////////////////////////////////////////////////////////////////
+    /// \brief histogram with regular bins over [min, max]. Values out of the range
+    /// are counted on the first or the last bin
+    //////////////////////////////////////////////////////////////////////////////
+    class MeshHistogram
+    {
+    public:
+        /// \brief constructor
+        MeshHistogram(double pMin = 0., double pMax = 1., unsigned int pNbBins = 10);
+
+        /// \brief count the given value
+        void add(double pValue);
+        /// \brief add the counts of an other histogram with the same bins
+        void merge(const MeshHistogram&);
+        /// \brief number of values counted
+        unsigned long int getNbValues() const                   { return nbValues;};
+        /// \brief count of each bin
+        const vector<unsigned long int>& getCounts() const      { return counts;};
+        /// \brief lower bound of the given bin
+        double getBinMin(unsigned int pBin) const               { return min + pBin*(max - min)/counts.size();};
+        /// \brief write the bins as "binMin binMax count" lines
+        void write(ostream&) const;
+
+    private:
+        double min;                             ///< \brief lower bound of the first bin
+        double max;                             ///< \brief upper bound of the last bin
+        vector<unsigned long int> counts;       ///< \brief count of each bin
+        unsigned long int nbValues;             ///< \brief number of values counted
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    /// \brief thresholds of the mesh validation
+    //////////////////////////////////////////////////////////////////////////////
+    struct MeshValidationSettings
+    {
+        /// \brief facets with a smaller angle (degree) are reported
+        double minFacetAngle;
+        /// \brief facets with a smaller angle (degree) are degenerated
+        double degenerateFacetAngle;
+        /// \brief depth (cpop unit) under which a membrane edge can go inside a neighbour or a nucleus outside of its cell
+        double overlapTolerance;
+        /// \brief number of threads used, 0 to follow the hardware
+        unsigned int nbThreads;
+
+        MeshValidationSettings():
+            minFacetAngle(5.),
+            degenerateFacetAngle(1e-3),
+            overlapTolerance(1e-6),
+            nbThreads(0)
+        {}
+    };
+
+    //////////////////////////////////////////////////////////////////////////////
+    /// \brief result of the validation of the cell meshes
+    //////////////////////////////////////////////////////////////////////////////
+    struct MeshValidationReport
+    {
+        unsigned long int nbCells;                      ///< \brief number of cells checked
+        unsigned long int nbCellsWithoutMesh;           ///< \brief cells without membrane mesh
+        unsigned long int nbOpenMeshes;                 ///< \brief membranes with border edges (not closed)
+        unsigned long int nbBadlyOrientedMeshes;        ///< \brief membranes whose facets don't all face away from the cell origin
+        unsigned long int nbDegenerateFacets;           ///< \brief facets with a null angle
+        unsigned long int nbCellsWithSmallAngles;       ///< \brief membranes with at least one facet angle under MeshValidationSettings::minFacetAngle
+        unsigned long int nbNucleiOutOfCell;            ///< \brief nuclei crossing their cell membrane
+        unsigned long int nbOverlappingPairs;           ///< \brief neighbour cells with a membrane edge inside the other membrane
+        vector<unsigned long int> faultyCells;          ///< \brief IDs of the cells failing at least one check, sorted
+
+        MeshHistogram minFacetAngle;                    ///< \brief smallest facet angle of each cell (degree)
+        MeshHistogram facetsPerCell;                    ///< \brief number of facets of each cell
+        MeshHistogram nucleusVolumeRatio;               ///< \brief nuclei volume / membrane volume of each cell
+
+        MeshValidationReport();
+
+        /// \brief return true if no cell failed any check
+        bool isValid() const                            { return faultyCells.empty();};
+        /// \brief add the results of an other report
+        void merge(const MeshValidationReport&);
+        /// \brief write the summary and the histograms
+        void write(ostream&) const;
+    };
+
+    /// \brief check closure, orientation, facet angles, nuclei containment and neighbour overlaps of the cell meshes, in parallel
+    MeshValidationReport validateCellMeshes(const vector<SpheroidalCell*>& pCells,
+        const map<SpheroidalCell*, set<const SpheroidalCell*> >* pNeighbours = NULL,
+        const MeshValidationSettings& pSettings = MeshValidationSettings());
 }
 
 #endif // UTILS_HH
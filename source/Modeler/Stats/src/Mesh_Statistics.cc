@@ -10,10 +10,15 @@ See LICENSE.md for further details
 
 #include "InformationSystemManager.hh"
 #include "IDManager.hh"
+#include "ParallelChunks.hh"
 #include "SimpleSpheroidalCell.hh"
 #include "StatsDataEmitter.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>	// needed to call the << operator on ofstream 
+#include <iterator>
+#include <limits>
 
 namespace Statistics
 {
@@ -118,4 +123,439 @@ namespace Statistics
     	*pOut  << "### file generated by cpop for cell Nuclei meshes statistics. Unit is micro meter. Mesh format is : " << getFormatName(pFormat).toStdString() << "### \n";
     }
 
-}
\ No newline at end of file
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pMin lower bound of the first bin
+    /// \param pMax upper bound of the last bin
+    /// \param pNbBins number of bins
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    MeshHistogram::MeshHistogram(double pMin, double pMax, unsigned int pNbBins):
+        min(pMin),
+        max(pMax),
+        counts(std::max(pNbBins, 1u), 0),
+        nbValues(0)
+    {
+        assert(pMax > pMin);
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pValue the value to count
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void MeshHistogram::add(double pValue)
+    {
+        double bin = std::floor((pValue - min) / (max - min) * counts.size());
+        size_t iBin = bin <= 0. ? 0 : std::min(static_cast<size_t>(bin), counts.size() - 1);
+        ++counts[iBin];
+        ++nbValues;
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pOther the histogram to add, must have the same bins
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void MeshHistogram::merge(const MeshHistogram& pOther)
+    {
+        assert(pOther.counts.size() == counts.size());
+        for(size_t iBin = 0; iBin < counts.size(); ++iBin)
+        {
+            counts[iBin] += pOther.counts[iBin];
+        }
+        nbValues += pOther.nbValues;
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pOut where to write the bins
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void MeshHistogram::write(ostream& pOut) const
+    {
+        for(unsigned int iBin = 0; iBin < counts.size(); ++iBin)
+        {
+            pOut << getBinMin(iBin) << "\t" << getBinMin(iBin + 1) << "\t" << counts[iBin] << endl;
+        }
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ///
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    MeshValidationReport::MeshValidationReport():
+        nbCells(0),
+        nbCellsWithoutMesh(0),
+        nbOpenMeshes(0),
+        nbBadlyOrientedMeshes(0),
+        nbDegenerateFacets(0),
+        nbCellsWithSmallAngles(0),
+        nbNucleiOutOfCell(0),
+        nbOverlappingPairs(0),
+        minFacetAngle(0., 60., 12),
+        facetsPerCell(0., 1000., 20),
+        nucleusVolumeRatio(0., 1., 20)
+    {
+
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pOther the report to add
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void MeshValidationReport::merge(const MeshValidationReport& pOther)
+    {
+        nbCells                 += pOther.nbCells;
+        nbCellsWithoutMesh      += pOther.nbCellsWithoutMesh;
+        nbOpenMeshes            += pOther.nbOpenMeshes;
+        nbBadlyOrientedMeshes   += pOther.nbBadlyOrientedMeshes;
+        nbDegenerateFacets      += pOther.nbDegenerateFacets;
+        nbCellsWithSmallAngles  += pOther.nbCellsWithSmallAngles;
+        nbNucleiOutOfCell       += pOther.nbNucleiOutOfCell;
+        nbOverlappingPairs      += pOther.nbOverlappingPairs;
+
+        vector<unsigned long int> lFaulty;
+        std::set_union(faultyCells.begin(), faultyCells.end(), pOther.faultyCells.begin(), pOther.faultyCells.end(), std::back_inserter(lFaulty));
+        faultyCells.swap(lFaulty);
+
+        minFacetAngle.merge(pOther.minFacetAngle);
+        facetsPerCell.merge(pOther.facetsPerCell);
+        nucleusVolumeRatio.merge(pOther.nucleusVolumeRatio);
+    }
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pOut where to write the report
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    void MeshValidationReport::write(ostream& pOut) const
+    {
+        pOut    << "### file generated by cpop for cell meshes validation. Unit is micro meter ###" << endl
+                << "cells\t"                    << nbCells                  << endl
+                << "cellsWithoutMesh\t"         << nbCellsWithoutMesh       << endl
+                << "openMeshes\t"               << nbOpenMeshes             << endl
+                << "badlyOrientedMeshes\t"      << nbBadlyOrientedMeshes    << endl
+                << "degenerateFacets\t"         << nbDegenerateFacets       << endl
+                << "cellsWithSmallAngles\t"     << nbCellsWithSmallAngles   << endl
+                << "nucleiOutOfCell\t"          << nbNucleiOutOfCell        << endl
+                << "overlappingPairs\t"         << nbOverlappingPairs       << endl;
+
+        pOut << "### faulty cells" << endl;
+        for(vector<unsigned long int>::const_iterator itID = faultyCells.begin(); itID != faultyCells.end(); ++itID)
+        {
+            pOut << *itID << endl;
+        }
+
+        pOut << "### minimal facet angle (degree) : binMin binMax count" << endl;
+        minFacetAngle.write(pOut);
+        pOut << "### number of facets per cell : binMin binMax count" << endl;
+        facetsPerCell.write(pOut);
+        pOut << "### nuclei volume / cell volume : binMin binMax count" << endl;
+        nucleusVolumeRatio.write(pOut);
+    }
+
+    /// \brief outward facet planes of a membrane : normals[i].p + offsets[i] <= 0 inside
+    struct MembranePlanes
+    {
+        vector<Vector_3> normals;
+        vector<double> offsets;
+        /// \brief sphere bounding the membrane vertices
+        Point_3 center;
+        double squareRadius;
+
+        MembranePlanes():
+            center(CGAL::ORIGIN),
+            squareRadius(0.)
+        {}
+
+        /// \brief return the largest signed distance from the point to the planes, negative inside
+        double getMaxDistance(const Point_3& pPoint) const
+        {
+            double maxDistance = -std::numeric_limits<double>::max();
+            for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+            {
+                maxDistance = std::max(maxDistance, normals[iPlane]*(pPoint - CGAL::ORIGIN) + offsets[iPlane]);
+            }
+            return maxDistance;
+        }
+
+        /// \brief return true if a part of the segment goes deeper than pTolerance inside the planes
+        /// \details Cyrus-Beck clipping of the segment by the half spaces, moved inward of the tolerance
+        bool isCrossedBy(const Point_3& pStart, const Point_3& pEnd, double pTolerance) const
+        {
+            const Vector_3 direction = pEnd - pStart;
+            const double squareLength = direction.squared_length();
+            if(normals.empty() || squareLength == 0.)
+            {
+                return false;
+            }
+
+            // the segment must go through the bounding sphere
+            double tClosest = std::min(1., std::max(0., ((center - pStart)*direction) / squareLength));
+            if(CGAL::squared_distance(pStart + tClosest*direction, center) >= squareRadius)
+            {
+                return false;
+            }
+
+            double tMin = 0., tMax = 1.;
+            for(size_t iPlane = 0; iPlane < normals.size(); ++iPlane)
+            {
+                double startDistance = normals[iPlane]*(pStart - CGAL::ORIGIN) + offsets[iPlane] + pTolerance;
+                double slope = normals[iPlane]*direction;
+                if(slope == 0.)
+                {
+                    if(startDistance >= 0.)
+                    {
+                        return false;
+                    }
+                }else if(slope > 0.)
+                {
+                    tMax = std::min(tMax, -startDistance / slope);
+                }else
+                {
+                    tMin = std::max(tMin, -startDistance / slope);
+                }
+
+                if(tMin >= tMax)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// \brief return true if an edge of the mesh goes deeper than pTolerance inside the planes
+        bool isCrossedBy(const Polyhedron_3* pShape, double pTolerance) const
+        {
+            Polyhedron_3::Edge_const_iterator itEdge;
+            for(itEdge = pShape->edges_begin(); itEdge != pShape->edges_end(); ++itEdge)
+            {
+                if(isCrossedBy(itEdge->vertex()->point(), itEdge->opposite()->vertex()->point(), pTolerance))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /// \param pCells The cells to check
+    /// \param pNeighbours The neighbourhood of the cells, used to look for overlaps. NULL to skip this check
+    /// \param pSettings The thresholds of the checks
+    /// \return The number of faulty meshes for each check, the IDs of the faulty cells and the histograms
+    /// \details overlaps are detected by clipping the edges of each membrane by the facet planes of
+    /// its neighbour, in both directions. Two convex membranes overlap if and only if an edge of one
+    /// of them crosses the other, so the check is exact for convex membranes. For a non convex membrane
+    /// the planes bound a smaller volume : overlaps can be missed but never wrongly reported.
+	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    MeshValidationReport validateCellMeshes(const vector<SpheroidalCell*>& pCells,
+        const map<SpheroidalCell*, set<const SpheroidalCell*> >* pNeighbours,
+        const MeshValidationSettings& pSettings)
+    {
+        const double radianToDegree = 180. / M_PI;
+        const size_t chunkSize = 16;
+        const unsigned int nbThreads = getNbThreadsFor(pCells.size(), chunkSize, pSettings.nbThreads);
+
+        vector<MembranePlanes> planes(pCells.size());
+        vector<MeshValidationReport> reports(nbThreads);
+        vector<set<unsigned long int> > faultyCells(nbThreads);
+
+        /// \brief first pass : each membrane on its own
+        processChunksInParallel(pCells.size(), chunkSize, nbThreads, [&](size_t pBegin, size_t pEnd, unsigned int pThreadID)
+        {
+            MeshValidationReport& report = reports[pThreadID];
+            for(size_t iCell = pBegin; iCell < pEnd; ++iCell)
+            {
+                const SpheroidalCell* cell = pCells[iCell];
+                assert(cell);
+                ++report.nbCells;
+                if(!cell->hasMesh())
+                {
+                    ++report.nbCellsWithoutMesh;
+                    faultyCells[pThreadID].insert(cell->getID());
+                    continue;
+                }
+
+                const Polyhedron_3* shape = cell->getShape();
+                const Point_3 origin = cell->getOrigin();
+                bool faulty = false;
+
+                MembranePlanes& cellPlanes = planes[iCell];
+                cellPlanes.center = origin;
+                Polyhedron_3::Point_const_iterator itPoint;
+                for(itPoint = shape->points_begin(); itPoint != shape->points_end(); ++itPoint)
+                {
+                    cellPlanes.squareRadius = std::max(cellPlanes.squareRadius, CGAL::squared_distance(*itPoint, origin));
+                }
+
+                if(!shape->is_closed())
+                {
+                    ++report.nbOpenMeshes;
+                    faulty = true;
+                }
+
+                // every facet must be seen from the cell origin with the same orientation
+                unsigned int nbDirect = 0, nbIndirect = 0;
+                double minAngle = 180.;
+                Polyhedron_3::Facet_const_iterator itFacet;
+                for(itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet)
+                {
+                    Point_3 p1 = itFacet->halfedge()->vertex()->point();
+                    Point_3 p2 = itFacet->halfedge()->next()->vertex()->point();
+                    Point_3 p3 = itFacet->halfedge()->next()->next()->vertex()->point();
+
+                    double determinant = CGAL::determinant(p1 - origin, p2 - origin, p3 - origin);
+                    if(determinant > 0.)
+                    {
+                        ++nbDirect;
+                    }else if(determinant < 0.)
+                    {
+                        ++nbIndirect;
+                        std::swap(p1, p2);
+                    }
+
+                    const Point_3* points[3] = {&p1, &p2, &p3};
+                    double facetMinAngle = 180.;
+                    for(int iPoint = 0; iPoint < 3; ++iPoint)
+                    {
+                        Vector_3 u = *points[(iPoint + 1) % 3] - *points[iPoint];
+                        Vector_3 v = *points[(iPoint + 2) % 3] - *points[iPoint];
+                        double angle = std::atan2(std::sqrt(CGAL::cross_product(u, v).squared_length()), u*v) * radianToDegree;
+                        facetMinAngle = std::min(facetMinAngle, angle);
+                    }
+                    minAngle = std::min(minAngle, facetMinAngle);
+
+                    if(facetMinAngle < pSettings.degenerateFacetAngle)
+                    {
+                        ++report.nbDegenerateFacets;
+                        faulty = true;
+                        continue;
+                    }
+
+                    Vector_3 normal = CGAL::cross_product(p2 - p1, p3 - p1);
+                    normal = normal / std::sqrt(normal.squared_length());
+                    cellPlanes.normals.push_back(normal);
+                    cellPlanes.offsets.push_back(-(normal*(p1 - CGAL::ORIGIN)));
+                }
+
+                if( (nbDirect > 0 && nbIndirect > 0) || (nbDirect + nbIndirect < shape->size_of_facets()) )
+                {
+                    ++report.nbBadlyOrientedMeshes;
+                    faulty = true;
+                }
+
+                report.minFacetAngle.add(minAngle);
+                report.facetsPerCell.add(shape->size_of_facets());
+                if(minAngle < pSettings.minFacetAngle)
+                {
+                    ++report.nbCellsWithSmallAngles;
+                    faulty = true;
+                }
+
+                // nuclei must stay inside the membrane
+                double cellVolume = std::fabs(cell->getMeshVolume(MeshOutFormats::GEANT_4));
+                double nucleiVolume = 0.;
+                vector<t_Nucleus_3*> nuclei = cell->getNuclei();
+                for(vector<t_Nucleus_3*>::const_iterator itNucleus = nuclei.begin(); itNucleus != nuclei.end(); ++itNucleus)
+                {
+                    nucleiVolume += (*itNucleus)->getMeshVolume(MeshOutFormats::GEANT_4);
+
+                    double maxDistance;
+                    const t_RoundNucleus_3* roundNucleus = dynamic_cast<const t_RoundNucleus_3*>(*itNucleus);
+                    if(roundNucleus)
+                    {
+                        maxDistance = cellPlanes.getMaxDistance(roundNucleus->getOrigin()) + roundNucleus->getRadius();
+                    }else
+                    {
+                        maxDistance = -std::numeric_limits<double>::max();
+                        vector<Point_3> nucleusPoints = (*itNucleus)->getShapePoints();
+                        for(vector<Point_3>::const_iterator itPt = nucleusPoints.begin(); itPt != nucleusPoints.end(); ++itPt)
+                        {
+                            maxDistance = std::max(maxDistance, cellPlanes.getMaxDistance(*itPt));
+                        }
+                    }
+
+                    if(maxDistance > pSettings.overlapTolerance)
+                    {
+                        ++report.nbNucleiOutOfCell;
+                        faulty = true;
+                    }
+                }
+                if(cellVolume > 0.)
+                {
+                    report.nucleusVolumeRatio.add(nucleiVolume / cellVolume);
+                }
+
+                if(faulty)
+                {
+                    faultyCells[pThreadID].insert(cell->getID());
+                }
+            }
+        });
+
+        /// \brief second pass : overlaps between neighbours
+        vector<set<pair<const SpheroidalCell*, const SpheroidalCell*> > > overlappingPairs(nbThreads);
+        if(pNeighbours)
+        {
+            map<const SpheroidalCell*, size_t> cellIndexes;
+            for(size_t iCell = 0; iCell < pCells.size(); ++iCell)
+            {
+                cellIndexes[pCells[iCell]] = iCell;
+            }
+
+            processChunksInParallel(pCells.size(), chunkSize, nbThreads, [&](size_t pBegin, size_t pEnd, unsigned int pThreadID)
+            {
+                for(size_t iCell = pBegin; iCell < pEnd; ++iCell)
+                {
+                    SpheroidalCell* cell = pCells[iCell];
+                    map<SpheroidalCell*, set<const SpheroidalCell*> >::const_iterator itNeighbours = pNeighbours->find(cell);
+                    if(!cell->hasMesh() || itNeighbours == pNeighbours->end())
+                    {
+                        continue;
+                    }
+
+                    for(set<const SpheroidalCell*>::const_iterator itNeighbour = itNeighbours->second.begin(); itNeighbour != itNeighbours->second.end(); ++itNeighbour)
+                    {
+                        map<const SpheroidalCell*, size_t>::const_iterator itIndex = cellIndexes.find(*itNeighbour);
+                        if(itIndex == cellIndexes.end() || !(*itNeighbour)->hasMesh())
+                        {
+                            continue;
+                        }
+
+                        const SpheroidalCell* first = std::min<const SpheroidalCell*>(cell, *itNeighbour);
+                        const SpheroidalCell* second = std::max<const SpheroidalCell*>(cell, *itNeighbour);
+                        if(overlappingPairs[pThreadID].count(make_pair(first, second)) > 0)
+                        {
+                            continue;
+                        }
+
+                        const MembranePlanes& cellPlanes = planes[iCell];
+                        const MembranePlanes& neighbourPlanes = planes[itIndex->second];
+                        const double radiusSum = std::sqrt(cellPlanes.squareRadius) + std::sqrt(neighbourPlanes.squareRadius);
+                        if(CGAL::squared_distance(cellPlanes.center, neighbourPlanes.center) >= radiusSum*radiusSum)
+                        {
+                            continue;
+                        }
+
+                        if( neighbourPlanes.isCrossedBy(cell->getShape(), pSettings.overlapTolerance) ||
+                            cellPlanes.isCrossedBy((*itNeighbour)->getShape(), pSettings.overlapTolerance))
+                        {
+                            overlappingPairs[pThreadID].insert(make_pair(first, second));
+                        }
+                    }
+                }
+            });
+        }
+
+        MeshValidationReport report;
+        for(unsigned int iThread = 0; iThread < nbThreads; ++iThread)
+        {
+            report.merge(reports[iThread]);
+            if(iThread > 0)
+            {
+                faultyCells[0].insert(faultyCells[iThread].begin(), faultyCells[iThread].end());
+                overlappingPairs[0].insert(overlappingPairs[iThread].begin(), overlappingPairs[iThread].end());
+            }
+        }
+        report.nbOverlappingPairs = overlappingPairs[0].size();
+        set<pair<const SpheroidalCell*, const SpheroidalCell*> >::const_iterator itPair;
+        for(itPair = overlappingPairs[0].begin(); itPair != overlappingPairs[0].end(); ++itPair)
+        {
+            faultyCells[0].insert(itPair->first->getID());
+            faultyCells[0].insert(itPair->second->getID());
+        }
+        report.faultyCells.assign(faultyCells[0].begin(), faultyCells[0].end());
+        return report;
+    }
+}
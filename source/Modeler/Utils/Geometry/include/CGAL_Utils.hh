@@ -75,6 +75,8 @@ double getSignedAngle(Vector_2 v1, Vector_2 v2);
 /// \brief return a random point set on the facet
 Point_3 getSpotOnFacet(Polyhedron_3::Facet);
 Point_3 getSpotOnTriangle(const Triangle_3* pTri);
+/// \brief return a random point uniformly distributed inside the tetrahedron
+Point_3 getSpotInTetrahedron(const Tetrahedron_3* pTet);
 
 /// \brief return the volume for a given CONVEX polyhedron
 double getConvexPolyhedronVolume(const Polyhedron_3*, Point_3);
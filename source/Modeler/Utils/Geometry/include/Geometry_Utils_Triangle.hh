@@ -0,0 +1,82 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef GEOMETRY_UTILS__TRIANGLE_HH
+#define GEOMETRY_UTILS__TRIANGLE_HH
+
+#include <cmath>
+
+//////////////////////////////////////////////////////////////////////////////
+/// @namespace Utils
+//////////////////////////////////////////////////////////////////////////////
+namespace Utils
+{
+	//////////////////////////////////////////////////////////////////////////////
+	/// @namespace Geometry
+	//////////////////////////////////////////////////////////////////////////////
+	namespace Geometry
+	{
+		//////////////////////////////////////////////////////////////////////////////
+		/// \brief geometric utils for triangles stored as plain coordinates
+		//////////////////////////////////////////////////////////////////////////////
+		namespace Triangle
+		{
+			//////////////////////////////////////////////////////////////////////////////
+			/// \brief a triangle stored as one vertex and the two edges leaving it.
+			/// Trivially copyable so it can be stored in contiguous arrays.
+			//////////////////////////////////////////////////////////////////////////////
+			template<typename Real>
+			struct FlatTriangle
+			{
+				Real origin[3];		///< \brief first vertex
+				Real edge1[3];		///< \brief second vertex - first vertex
+				Real edge2[3];		///< \brief third vertex - first vertex
+			};
+
+			/// \brief build a flat triangle from any point type providing x(), y() and z()
+			template<typename Real, typename Point>
+			FlatTriangle<Real> makeFlatTriangle(const Point& p0, const Point& p1, const Point& p2)
+			{
+				FlatTriangle<Real> tri;
+				tri.origin[0] = Real(p0.x());	tri.origin[1] = Real(p0.y());	tri.origin[2] = Real(p0.z());
+				tri.edge1[0] = Real(p1.x() - p0.x());	tri.edge1[1] = Real(p1.y() - p0.y());	tri.edge1[2] = Real(p1.z() - p0.z());
+				tri.edge2[0] = Real(p2.x() - p0.x());	tri.edge2[1] = Real(p2.y() - p0.y());	tri.edge2[2] = Real(p2.z() - p0.z());
+				return tri;
+			}
+
+			/// \brief return twice the area of the triangle
+			template<typename Real>
+			double getDoubleArea(const FlatTriangle<Real>& tri)
+			{
+				double cx = double(tri.edge1[1])*tri.edge2[2] - double(tri.edge1[2])*tri.edge2[1];
+				double cy = double(tri.edge1[2])*tri.edge2[0] - double(tri.edge1[0])*tri.edge2[2];
+				double cz = double(tri.edge1[0])*tri.edge2[1] - double(tri.edge1[1])*tri.edge2[0];
+				return std::sqrt(cx*cx + cy*cy + cz*cz);
+			}
+
+			/// \brief write in pSpot the point of the triangle corresponding to the two uniform random
+			/// numbers pU and pV in [0, 1]. Points are uniformly distributed on the triangle.
+			template<typename Real>
+			inline void getSpotOnTriangle(const FlatTriangle<Real>& tri, double pU, double pV, Real pSpot[3])
+			{
+				// the square is folded along its diagonal onto the triangle
+				if( (pU + pV) > 1.)
+				{
+					pU = 1. - pU;
+					pV = 1. - pV;
+				}
+				for(int i = 0; i < 3; ++i)
+				{
+					pSpot[i] = Real(tri.origin[i] + pU*tri.edge1[i] + pV*tri.edge2[i]);
+				}
+			}
+		}
+	}
+}
+
+#endif // GEOMETRY_UTILS__TRIANGLE_HH
@@ -254,6 +254,42 @@ Point_3 getSpotOnTriangle(const Triangle_3* pTri)
     Point_3 res	= pTri->vertex(0) + x*X + y*Y;
     return res;
 }
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// \param pTet the tetrahedron from where we want to pick a point
+/// \details the unit cube is folded onto the unit tetrahedron (Rocchini and Cignoni)
+/// so the point is uniformly distributed without any rejection.
+/////////////////////////////////////////////////////////////////////////////////////////
+Point_3 getSpotInTetrahedron(const Tetrahedron_3* pTet)
+{
+    double s 	= RandomEngineManager::getInstance()->randd(0., 1.);
+    double t 	= RandomEngineManager::getInstance()->randd(0., 1.);
+    double u 	= RandomEngineManager::getInstance()->randd(0., 1.);
+
+    // fold the cube onto the prism s + t <= 1
+    if( (s+t) > 1.)
+    {
+        s = 1. -s;
+        t = 1. -t;
+    }
+    // fold the prism onto the tetrahedron s + t + u <= 1
+    if( (t+u) > 1.)
+    {
+        double tmp = u;
+        u = 1. -s -t;
+        t = 1. -tmp;
+    }else if( (s+t+u) > 1.)
+    {
+        double tmp = u;
+        u = s +t +u -1.;
+        s = 1. -t -tmp;
+    }
+
+    Vector_3 X 	= pTet->vertex(1) - pTet->vertex(0);
+    Vector_3 Y 	= pTet->vertex(2) - pTet->vertex(0);
+    Vector_3 Z 	= pTet->vertex(3) - pTet->vertex(0);
+    return pTet->vertex(0) + s*X + t*Y + u*Z;
+}
 /////////////////////////////////////////////////////////////////////////////////////////
 /// \param pFacet the facet from where we want to pick a point
 /// \brief return a random point set on the facet
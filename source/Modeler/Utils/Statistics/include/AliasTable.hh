@@ -0,0 +1,78 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol, 
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#ifndef ALIAS_TABLE_HH
+#define ALIAS_TABLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////
+/// @namespace Utils
+//////////////////////////////////////////////////////////////////////////////
+namespace Utils
+{
+	//////////////////////////////////////////////////////////////////////////////
+	/// @namespace Statistics
+	//////////////////////////////////////////////////////////////////////////////
+	namespace Statistics
+	{
+		//////////////////////////////////////////////////////////////////////////////
+		/// \brief Walker's alias table (built with Vose's method).
+		/// Pick an index with a probability proportional to its weight in O(1),
+		/// using a single uniform random number. Entries with a null weight are never picked.
+		//////////////////////////////////////////////////////////////////////////////
+		class AliasTable
+		{
+		public:
+			/// \brief constructor. The table is empty until build is called
+			AliasTable() = default;
+			/// \brief constructor, build the table from the given weights
+			explicit AliasTable(const std::vector<double>& pWeights);
+
+			/// \brief (re)build the table. Throw std::invalid_argument if weights are negative or all null
+			void build(const std::vector<double>& pWeights);
+			/// \brief remove all entries
+			void clear()					{ entries.clear(); totalWeight = 0.; }
+
+			/// \brief return the index corresponding to the uniform random number pUniform in [0, 1[
+			std::size_t sample(double pUniform) const
+			{
+				double lScaled = pUniform * static_cast<double>(entries.size());
+				std::size_t lIndex = static_cast<std::size_t>(lScaled);
+				if(lIndex >= entries.size())
+				{
+					lIndex = entries.size() - 1;
+				}
+				const Entry& lEntry = entries[lIndex];
+				return (lScaled - static_cast<double>(lIndex) < lEntry.probability) ? lIndex : lEntry.alias;
+			}
+
+			/// \brief return the number of entries
+			std::size_t size() const		{ return entries.size(); }
+			/// \brief return true if the table has not been built
+			bool empty() const				{ return entries.empty(); }
+			/// \brief return the sum of the weights given at build time
+			double getTotalWeight() const	{ return totalWeight; }
+
+		private:
+			/// \brief one column of the table : keep index with probability, else take alias
+			struct Entry
+			{
+				double probability;
+				std::uint32_t alias;
+			};
+
+			std::vector<Entry> entries;
+			double totalWeight = 0.;
+		};
+	}
+}
+
+#endif // ALIAS_TABLE_HH
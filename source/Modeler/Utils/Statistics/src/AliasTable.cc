@@ -0,0 +1,119 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol, 
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "AliasTable.hh"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Utils
+{
+	namespace Statistics
+	{
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+		///
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+		AliasTable::AliasTable(const std::vector<double>& pWeights)
+		{
+			build(pWeights);
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/// \param pWeights The (unnormalized) weight of each index
+		//////////////////////////////////////////////////////////////////////////////////////////////////////////
+		void AliasTable::build(const std::vector<double>& pWeights)
+		{
+			if(pWeights.empty())
+			{
+				throw std::invalid_argument("AliasTable : no weight given");
+			}
+			if(pWeights.size() > std::numeric_limits<std::uint32_t>::max())
+			{
+				throw std::invalid_argument("AliasTable : too many weights");
+			}
+
+			double lSum = 0.;
+			std::size_t lAnyPositive = 0;
+			for(std::size_t i = 0; i < pWeights.size(); ++i)
+			{
+				if(!(pWeights[i] >= 0.) || !std::isfinite(pWeights[i]))
+				{
+					throw std::invalid_argument("AliasTable : weights must be positive and finite");
+				}
+				if(pWeights[i] > 0.)
+				{
+					lAnyPositive = i;
+				}
+				lSum += pWeights[i];
+			}
+			if(!(lSum > 0.))
+			{
+				throw std::invalid_argument("AliasTable : all weights are null");
+			}
+
+			const std::size_t n = pWeights.size();
+			entries.assign(n, Entry{1., 0});
+			totalWeight = lSum;
+
+			// scale weights so the mean is 1, then pair each "small" column with a "large" one
+			std::vector<double> lScaled(n);
+			std::vector<std::uint32_t> lSmall;
+			std::vector<std::uint32_t> lLarge;
+			lSmall.reserve(n);
+			lLarge.reserve(n);
+			for(std::size_t i = 0; i < n; ++i)
+			{
+				lScaled[i] = pWeights[i] * static_cast<double>(n) / lSum;
+				entries[i].alias = static_cast<std::uint32_t>(i);
+				if(lScaled[i] < 1.)
+				{
+					lSmall.push_back(static_cast<std::uint32_t>(i));
+				}else
+				{
+					lLarge.push_back(static_cast<std::uint32_t>(i));
+				}
+			}
+
+			while(!lSmall.empty() && !lLarge.empty())
+			{
+				std::uint32_t lLess = lSmall.back();
+				lSmall.pop_back();
+				std::uint32_t lMore = lLarge.back();
+
+				entries[lLess].probability = lScaled[lLess];
+				entries[lLess].alias = lMore;
+
+				lScaled[lMore] = (lScaled[lMore] + lScaled[lLess]) - 1.;
+				if(lScaled[lMore] < 1.)
+				{
+					lLarge.pop_back();
+					lSmall.push_back(lMore);
+				}
+			}
+
+			// remaining columns are full up to rounding errors
+			for(std::uint32_t i : lLarge)
+			{
+				entries[i].probability = 1.;
+			}
+			for(std::uint32_t i : lSmall)
+			{
+				// never give a full column to a null weight because of rounding errors
+				if(pWeights[i] > 0.)
+				{
+					entries[i].probability = 1.;
+				}else
+				{
+					entries[i].probability = 0.;
+					entries[i].alias = static_cast<std::uint32_t>(lAnyPositive);
+				}
+			}
+		}
+	}
+}
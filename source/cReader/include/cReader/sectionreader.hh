@@ -34,6 +34,18 @@ class SectionReader
 protected:
     T* objToFill;
 
+    /**
+     * \brief Loads an optional value associated with keyname contained in sectionName
+     *
+     * \param sectionName section name in the configuration file
+     * \param keyName key name in the sectionName part of the configuration file
+     * \param defaultValue value returned if the key is not defined
+     *
+     * \return Returns the stored value if it exists and defaultValue otherwise
+     */
+    template <typename U>
+    U loadOptional(const char* sectionName, const char* keyName, U defaultValue);
+
 public:
     /**
      * \brief SectionReader constructor
@@ -104,6 +116,17 @@ U SectionReader<T>::load(const char *sectionName, const char *keyName)
     return value.load<U>();
 }
 
+template <typename T>
+template <typename U>
+U SectionReader<T>::loadOptional(const char *sectionName, const char *keyName, U defaultValue)
+{
+    if(!check((*parser)(sectionName)[keyName])) {
+        return defaultValue;
+    }
+
+    return load<U>(sectionName, keyName);
+}
+
 }
 
 
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include "AliasTable.hh"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using Utils::Statistics::AliasTable;
+
+// sample the table with nbSample uniform random numbers and return the frequency of each index
+static std::vector<double> sampleFrequencies(const AliasTable& table, int nbSample) {
+    std::mt19937_64 engine(42);
+    std::uniform_real_distribution<double> uniform(0., 1.);
+
+    std::vector<double> frequencies(table.size(), 0.);
+    for (int i = 0; i < nbSample; ++i) {
+        std::size_t index = table.sample(uniform(engine));
+        REQUIRE(index < table.size());
+        frequencies[index] += 1.;
+    }
+    for (double& frequency : frequencies)
+        frequency /= nbSample;
+    return frequencies;
+}
+
+TEST_CASE("Alias table", "[statistics]") {
+
+    const int nbSample = 1000000;
+
+    SECTION("Sampled frequencies match the weights") {
+        std::vector<double> weights = {1., 2., 3., 4., 0.5, 10., 0.25};
+        AliasTable table(weights);
+        REQUIRE(table.size() == weights.size());
+        REQUIRE(table.getTotalWeight() == Approx(20.75));
+
+        std::vector<double> frequencies = sampleFrequencies(table, nbSample);
+        for (std::size_t i = 0; i < weights.size(); ++i) {
+            // about 5 standard deviations of the frequency estimator
+            REQUIRE(frequencies[i] == Approx(weights[i] / table.getTotalWeight()).margin(0.003));
+        }
+    }
+
+    SECTION("A single bin is always picked") {
+        AliasTable table({3.});
+        REQUIRE(table.size() == 1);
+        REQUIRE(table.sample(0.) == 0);
+        REQUIRE(table.sample(0.5) == 0);
+        REQUIRE(table.sample(1. - 1e-16) == 0);
+        // out of range values are clamped to the last bin
+        REQUIRE(table.sample(1.) == 0);
+    }
+
+    SECTION("Bins with a null weight are never picked") {
+        std::vector<double> weights = {0., 1., 0., 0., 3., 0.};
+        AliasTable table(weights);
+
+        std::vector<double> frequencies = sampleFrequencies(table, nbSample);
+        REQUIRE(frequencies[0] == 0.);
+        REQUIRE(frequencies[2] == 0.);
+        REQUIRE(frequencies[3] == 0.);
+        REQUIRE(frequencies[5] == 0.);
+        REQUIRE(frequencies[1] == Approx(0.25).margin(0.003));
+        REQUIRE(frequencies[4] == Approx(0.75).margin(0.003));
+
+        // bounds of each column
+        for (std::size_t i = 0; i < weights.size(); ++i) {
+            REQUIRE(weights[table.sample(static_cast<double>(i) / weights.size())] > 0.);
+            REQUIRE(weights[table.sample((i + 1. - 1e-12) / weights.size())] > 0.);
+        }
+    }
+
+    SECTION("Invalid weights") {
+        AliasTable table;
+        REQUIRE(table.empty());
+        REQUIRE_THROWS_AS(table.build({}), std::invalid_argument);
+        REQUIRE_THROWS_AS(table.build({0., 0.}), std::invalid_argument);
+        REQUIRE_THROWS_AS(table.build({1., -1.}), std::invalid_argument);
+        REQUIRE(table.empty());
+
+        table.build({1., 1.});
+        REQUIRE(table.size() == 2);
+        table.clear();
+        REQUIRE(table.empty());
+    }
+}
@@ -0,0 +1,197 @@
+#include "catch.hpp"
+
+#include "CPOP_ConvexPolyhedron.hh"
+
+#include "G4TessellatedSolid.hh"
+#include "G4TriangularFacet.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+// closed outward oriented triangles, 9 coordinates per facet
+typedef std::vector<G4double> Facets;
+
+static void addFacet(Facets& facets, const G4ThreeVector& a, const G4ThreeVector& b, const G4ThreeVector& c) {
+    for (const G4ThreeVector* p : {&a, &b, &c}) {
+        facets.push_back(p->x());
+        facets.push_back(p->y());
+        facets.push_back(p->z());
+    }
+}
+
+// icosahedron subdivided nbLevel times and projected on the sphere
+static Facets makeIcosphere(const G4ThreeVector& center, G4double radius, int nbLevel) {
+    const G4double t = (1. + std::sqrt(5.)) / 2.;
+    std::vector<G4ThreeVector> vertices = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+    std::vector<std::array<size_t, 3> > triangles = {
+        {{0, 11, 5}}, {{0, 5, 1}}, {{0, 1, 7}}, {{0, 7, 10}}, {{0, 10, 11}},
+        {{1, 5, 9}}, {{5, 11, 4}}, {{11, 10, 2}}, {{10, 7, 6}}, {{7, 1, 8}},
+        {{3, 9, 4}}, {{3, 4, 2}}, {{3, 2, 6}}, {{3, 6, 8}}, {{3, 8, 9}},
+        {{4, 9, 5}}, {{2, 4, 11}}, {{6, 2, 10}}, {{8, 6, 7}}, {{9, 8, 1}}};
+    for (G4ThreeVector& v : vertices)
+        v = v.unit();
+
+    for (int level = 0; level < nbLevel; ++level) {
+        std::map<std::pair<size_t, size_t>, size_t> middles;
+        auto middle = [&](size_t a, size_t b) {
+            std::pair<size_t, size_t> key(std::min(a, b), std::max(a, b));
+            auto found = middles.find(key);
+            if (found != middles.end())
+                return found->second;
+            vertices.push_back((0.5 * (vertices[a] + vertices[b])).unit());
+            middles[key] = vertices.size() - 1;
+            return vertices.size() - 1;
+        };
+
+        std::vector<std::array<size_t, 3> > subdivided;
+        for (const auto& tri : triangles) {
+            size_t a = middle(tri[0], tri[1]);
+            size_t b = middle(tri[1], tri[2]);
+            size_t c = middle(tri[2], tri[0]);
+            subdivided.push_back({{tri[0], a, c}});
+            subdivided.push_back({{tri[1], b, a}});
+            subdivided.push_back({{tri[2], c, b}});
+            subdivided.push_back({{a, b, c}});
+        }
+        triangles.swap(subdivided);
+    }
+
+    Facets facets;
+    for (const auto& tri : triangles)
+        addFacet(facets, center + radius * vertices[tri[0]], center + radius * vertices[tri[1]], center + radius * vertices[tri[2]]);
+    return facets;
+}
+
+// box made of two triangles per face
+static Facets makeBox(const G4ThreeVector& center, const G4ThreeVector& halfSize) {
+    std::array<G4ThreeVector, 8> corners;
+    for (int i = 0; i < 8; ++i)
+        corners[i] = center + G4ThreeVector((i & 1) ? halfSize.x() : -halfSize.x(),
+                                            (i & 2) ? halfSize.y() : -halfSize.y(),
+                                            (i & 4) ? halfSize.z() : -halfSize.z());
+
+    const int faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+    Facets facets;
+    for (const auto& face : faces) {
+        addFacet(facets, corners[face[0]], corners[face[1]], corners[face[2]]);
+        addFacet(facets, corners[face[0]], corners[face[2]], corners[face[3]]);
+    }
+    return facets;
+}
+
+static G4TessellatedSolid* makeTessellatedSolid(const Facets& facets) {
+    G4TessellatedSolid* solid = new G4TessellatedSolid("tessellated");
+    for (size_t i = 0; i < facets.size(); i += 9) {
+        solid->AddFacet(new G4TriangularFacet(G4ThreeVector(facets[i], facets[i + 1], facets[i + 2]),
+                                              G4ThreeVector(facets[i + 3], facets[i + 4], facets[i + 5]),
+                                              G4ThreeVector(facets[i + 6], facets[i + 7], facets[i + 8]),
+                                              ABSOLUTE));
+    }
+    solid->SetSolidClosed(true);
+    return solid;
+}
+
+// compare the navigation functions of the convex solid with the G4TessellatedSolid ones
+static void compareWithTessellated(const Facets& facets, const G4ThreeVector& center, G4double halfWidth) {
+    std::unique_ptr<CPOP_ConvexPolyhedron> convex(CPOP_ConvexPolyhedron::create("convex", facets.data(), facets.size() / 9));
+    REQUIRE(convex);
+    std::unique_ptr<G4TessellatedSolid> tessellated(makeTessellatedSolid(facets));
+
+    REQUIRE(convex->GetCubicVolume() == Approx(tessellated->GetCubicVolume()).epsilon(1e-6));
+    REQUIRE(convex->GetSurfaceArea() == Approx(tessellated->GetSurfaceArea()).epsilon(1e-6));
+
+    const G4double tolerance = 1e-6 * halfWidth;
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<G4double> position(-halfWidth, halfWidth);
+    std::uniform_real_distribution<G4double> direction(-1., 1.);
+
+    size_t nbInside = 0;
+    size_t nbHit = 0;
+    for (int i = 0; i < 20000; ++i) {
+        G4ThreeVector p = center + G4ThreeVector(position(generator), position(generator), position(generator));
+        G4ThreeVector v = G4ThreeVector(direction(generator), direction(generator), direction(generator)).unit();
+
+        EInside inside = convex->Inside(p);
+        EInside expected = tessellated->Inside(p);
+        // skip the points on the surface tolerance of one of the solids
+        if (inside == kSurface || expected == kSurface)
+            continue;
+        REQUIRE(inside == expected);
+
+        if (inside == kInside) {
+            ++nbInside;
+            REQUIRE(convex->DistanceToOut(p, v) == Approx(tessellated->DistanceToOut(p, v)).margin(tolerance));
+            REQUIRE(convex->DistanceToOut(p) <= convex->DistanceToOut(p, v) + tolerance);
+        } else {
+            G4double distance = convex->DistanceToIn(p, v);
+            G4double expectedDistance = tessellated->DistanceToIn(p, v);
+            if (expectedDistance == kInfinity) {
+                REQUIRE(distance == kInfinity);
+            } else {
+                ++nbHit;
+                REQUIRE(distance == Approx(expectedDistance).margin(tolerance));
+                REQUIRE(convex->DistanceToIn(p) <= distance + tolerance);
+            }
+        }
+    }
+    REQUIRE(nbInside > 0);
+    REQUIRE(nbHit > 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        G4ThreeVector p = convex->GetPointOnSurface();
+        REQUIRE(convex->Inside(p) == kSurface);
+        REQUIRE(convex->SurfaceNormal(p).mag() == Approx(1.));
+    }
+}
+
+TEST_CASE("Convex polyhedron solid", "[solid]") {
+
+    SECTION("Sphere") {
+        G4ThreeVector center(3 * um, -1 * um, 2 * um);
+        compareWithTessellated(makeIcosphere(center, 10 * um, 3), center, 15 * um);
+    }
+
+    SECTION("Coplanar facets share their plane") {
+        G4ThreeVector center(1 * um, 2 * um, -3 * um);
+        Facets facets = makeBox(center, G4ThreeVector(5 * um, 3 * um, 4 * um));
+        std::unique_ptr<CPOP_ConvexPolyhedron> convex(CPOP_ConvexPolyhedron::create("box", facets.data(), facets.size() / 9));
+        REQUIRE(convex);
+        REQUIRE(convex->GetNumberOfTriangles() == 12);
+        REQUIRE(convex->GetNumberOfPlanes() == 6);
+        REQUIRE(convex->GetCubicVolume() == Approx(10 * 6 * 8 * um * um * um));
+
+        compareWithTessellated(facets, center, 8 * um);
+    }
+
+    SECTION("Non convex or open meshes are rejected") {
+        Facets facets = makeIcosphere(G4ThreeVector(), 10 * um, 2);
+
+        // dent : move one vertex of the sphere toward its center everywhere it appears
+        Facets dented = facets;
+        G4ThreeVector apex(facets[0], facets[1], facets[2]);
+        for (size_t i = 0; i < dented.size(); i += 3) {
+            if (G4ThreeVector(dented[i], dented[i + 1], dented[i + 2]) == apex) {
+                dented[i] *= 0.5;
+                dented[i + 1] *= 0.5;
+                dented[i + 2] *= 0.5;
+            }
+        }
+        REQUIRE(CPOP_ConvexPolyhedron::create("dented", dented.data(), dented.size() / 9) == NULL);
+
+        // open : remove the last facet
+        REQUIRE(CPOP_ConvexPolyhedron::create("open", facets.data(), facets.size() / 9 - 1) == NULL);
+
+        // inside out : wrong orientation gives a negative volume
+        Facets reversed = facets;
+        for (size_t i = 0; i < reversed.size(); i += 9)
+            std::swap_ranges(reversed.begin() + i + 3, reversed.begin() + i + 6, reversed.begin() + i + 6);
+        REQUIRE(CPOP_ConvexPolyhedron::create("reversed", reversed.data(), reversed.size() / 9) == NULL);
+    }
+}
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+
+#include "Delaunay_3D_SDS.hh"
+#include "ElasticForce.hh"
+#include "ElasticPairForces.hh"
+#include "ForceSettings.hh"
+#include "MASPlatform.hh"
+#include "RandomEngineManager.hh"
+#include "SimpleSpheroidalCell.hh"
+#include "SpatialDataStructureManager.hh"
+
+#include "Randomize.hh"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+typedef ElasticPairForces<double, Point_3, Vector_3> t_ElasticPairForces_3;
+
+// cells on a slightly distorted 3x3x2 grid, with three different radii
+static std::vector<SimpleSpheroidalCell*> createCells() {
+    std::vector<SimpleSpheroidalCell*> cells;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            for (int k = 0; k < 2; ++k) {
+                Point_3 origin(10. * i + 0.5 * j * k, 10. * j + 0.7 * i, 10. * k + 0.3 * i * j);
+                double radius = 5. + cells.size() % 3;
+                cells.push_back(new SimpleSpheroidalCell(nullptr, origin, radius, 0.5 * radius));
+            }
+        }
+    }
+    return cells;
+}
+
+// force of the elastic springs with the SDS neighbours closer than the cutoff, at their current position
+static Vector_3 expectedForce(const Delaunay_3D_SDS& sds, const SimpleSpheroidalCell* cell, double rigidity, double ratio, double cutoff) {
+    Vector_3 force = CGAL::NULL_VECTOR;
+    for (const t_SpatialableAgent_3* neighbour : sds.getNeighbours(cell)) {
+        const SimpleSpheroidalCell* neighbourCell = dynamic_cast<const SimpleSpheroidalCell*>(neighbour);
+        REQUIRE(neighbourCell);
+        Vector_3 direction = neighbour->getPosition() - cell->getPosition();
+        double distance = std::sqrt(direction.squared_length());
+        if (distance >= cutoff)
+            continue;
+        double restLength = (cell->getRadius() + neighbourCell->getRadius()) * ratio;
+        force = force - rigidity * (restLength - distance) * direction / distance;
+    }
+    return force;
+}
+
+TEST_CASE("Elastic pair forces", "[force]") {
+
+    CLHEP::MTwistEngine defaultEngineCPOP(1234567);
+    RandomEngineManager::getInstance()->setEngine(&defaultEngineCPOP);
+
+    std::vector<SimpleSpheroidalCell*> cells = createCells();
+    Delaunay_3D_SDS sds("elastic force test");
+    for (SimpleSpheroidalCell* cell : cells)
+        REQUIRE(sds.add(cell));
+    SpatialDataStructureManager::getInstance()->makeRegistration(&sds);
+
+    // the last cell is stiffer, so its pairs are only evaluated from one side
+    std::vector<t_ElasticForce_3*> forces;
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        double rigidity = (i + 1 == cells.size()) ? 0.004 : 0.002;
+        forces.push_back(new t_ElasticForce_3(cells[i], rigidity, 0.7));
+        cells[i]->addForce(forces.back());
+    }
+
+    SECTION("Summed pair contributions equal the force of each cell") {
+        std::unique_ptr<t_ElasticPairForces_3> pairForces(new t_ElasticPairForces_3(2));
+        for (t_ElasticForce_3* force : forces)
+            pairForces->addForce(force);
+        REQUIRE(pairForces->exec());
+        REQUIRE(pairForces->getNbSymmetricPairs() > 0);
+
+        for (t_ElasticForce_3* force : forces) {
+            // the first call sums the pair contributions, the second one evaluates the cell on its own
+            Vector_3 fromPairs = force->computeForce();
+            Vector_3 fromCell = force->computeForce();
+            REQUIRE(fromCell.squared_length() > 0.);
+            REQUIRE(fromPairs.x() == Approx(fromCell.x()).margin(1e-12));
+            REQUIRE(fromPairs.y() == Approx(fromCell.y()).margin(1e-12));
+            REQUIRE(fromPairs.z() == Approx(fromCell.z()).margin(1e-12));
+        }
+    }
+
+    SECTION("Neighbours further than the cutoff are not pulled") {
+        for (t_ElasticForce_3* force : forces)
+            force->setCutoff(1.);
+        for (t_ElasticForce_3* force : forces)
+            REQUIRE(force->computeForce().squared_length() == 0.);
+    }
+
+    SECTION("Lists with a skin follow the positions until they are rebuilt") {
+        static MASPlatform platform;
+        platform.setNeighbourListSkin(4.);
+        const double cutoff = 11.;
+        for (t_ElasticForce_3* force : forces)
+            force->setCutoff(cutoff);
+
+        std::unique_ptr<t_ElasticPairForces_3> pairForces(new t_ElasticPairForces_3(2));
+        for (t_ElasticForce_3* force : forces)
+            pairForces->addForce(force);
+
+        // the neighbour moves within the skin, without SDS update : the list is kept
+        // but the distance is checked again, here going over the cutoff
+        for (const Vector_3& move : {Vector_3(0., 0., 0.), Vector_3(0., 0., 1.5)}) {
+            cells[1]->setPosition(cells[1]->getPosition() + move);
+            Vector_3 expected = expectedForce(sds, cells[0], 0.002, 0.7, cutoff);
+
+            REQUIRE(pairForces->exec());
+            Vector_3 fromPairs = forces[0]->computeForce();
+            Vector_3 fromCell = forces[0]->computeForce();
+            for (const Vector_3& force : {fromPairs, fromCell}) {
+                REQUIRE(force.x() == Approx(expected.x()).margin(1e-12));
+                REQUIRE(force.y() == Approx(expected.y()).margin(1e-12));
+                REQUIRE(force.z() == Approx(expected.z()).margin(1e-12));
+            }
+        }
+        platform.setNeighbourListSkin(-1.);
+    }
+
+    SpatialDataStructureManager::getInstance()->makeUnregistration(&sds);
+    // the forces belong to their cell
+    for (SimpleSpheroidalCell* cell : cells)
+        delete cell;
+}
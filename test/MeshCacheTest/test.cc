@@ -0,0 +1,127 @@
+#include "catch.hpp"
+
+#include "PopulationLoader.hh"
+#include "RandomEngineManager.hh"
+#include "SpheroidalCellMesh.hh"
+
+#include "Randomize.hh"
+
+#include <QDir>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+#include <vector>
+
+// mesh counting its refinements. If nbFailures is positive the refinement reports them without refining
+class CountingMesh : public SpheroidalCellMesh {
+public:
+    CountingMesh(std::set<t_Cell_3*> cells, unsigned long nbFailures)
+        : SpheroidalCellMesh(100, 0., cells), nbFailures(nbFailures), nbRefinement(0) {}
+
+    unsigned long nbFailures;
+    int nbRefinement;
+
+protected:
+    unsigned long reffineCells(const std::vector<SpheroidalCell*>& cells) override {
+        ++nbRefinement;
+        if (nbFailures > 0)
+            return nbFailures;
+        return SpheroidalCellMesh::reffineCells(cells);
+    }
+};
+
+// membrane and round nuclei of a cell, with exact coordinates
+struct CellGeometry {
+    std::vector<std::array<double, 3> > vertices;
+    std::vector<std::vector<std::size_t> > facets;  // vertex indexes starting from the smallest one, sorted
+    std::vector<std::array<double, 4> > nuclei;     // origin and radius
+};
+
+static std::map<unsigned long int, CellGeometry> getGeometries(const std::vector<SpheroidalCell*>& cells) {
+    std::map<unsigned long int, CellGeometry> geometries;
+    for (const SpheroidalCell* cell : cells) {
+        REQUIRE(cell->hasMesh());
+        CellGeometry& geometry = geometries[cell->getID()];
+        const Mesh3D::Polyhedron_3* shape = cell->getShape();
+
+        std::map<const void*, std::size_t> vertexIndexes;
+        for (auto itVertex = shape->vertices_begin(); itVertex != shape->vertices_end(); ++itVertex) {
+            vertexIndexes[&*itVertex] = geometry.vertices.size();
+            geometry.vertices.push_back({{itVertex->point().x(), itVertex->point().y(), itVertex->point().z()}});
+        }
+        for (auto itFacet = shape->facets_begin(); itFacet != shape->facets_end(); ++itFacet) {
+            std::vector<std::size_t> facet;
+            auto itHalfedge = itFacet->facet_begin();
+            do {
+                facet.push_back(vertexIndexes[&*(itHalfedge->vertex())]);
+            } while (++itHalfedge != itFacet->facet_begin());
+            std::rotate(facet.begin(), std::min_element(facet.begin(), facet.end()), facet.end());
+            geometry.facets.push_back(facet);
+        }
+        std::sort(geometry.facets.begin(), geometry.facets.end());
+
+        for (const t_Nucleus_3* nucleus : cell->getNuclei()) {
+            const t_RoundNucleus_3* roundNucleus = dynamic_cast<const t_RoundNucleus_3*>(nucleus);
+            REQUIRE(roundNucleus);
+            Point_3 origin = roundNucleus->getOrigin();
+            geometry.nuclei.push_back({{origin.x(), origin.y(), origin.z(), roundNucleus->getRadius()}});
+        }
+    }
+    return geometries;
+}
+
+static int nbCacheFiles(const QTemporaryDir& directory) {
+    return QDir(directory.path()).entryList(QDir::Files).size();
+}
+
+TEST_CASE("Mesh cache", "[mesh]") {
+
+    CLHEP::MTwistEngine defaultEngineCPOP(1234567);
+    RandomEngineManager::getInstance()->setEngine(&defaultEngineCPOP);
+
+    QTemporaryDir directory;
+    REQUIRE(directory.isValid());
+    const uint64_t populationKey = 1234;
+
+    std::set<t_Cell_3*> cells = loadCells();
+
+    SECTION("A failed refinement leaves no cache entry") {
+        CountingMesh mesh(cells, 1);
+        mesh.setMeshCache(directory.path(), populationKey);
+        mesh.generateMesh();
+
+        REQUIRE(mesh.nbRefinement == 1);
+        REQUIRE(nbCacheFiles(directory) == 0);
+    }
+
+    SECTION("A successful refinement is cached and reused") {
+        std::map<unsigned long int, CellGeometry> refined;
+        {
+            CountingMesh mesh(cells, 0);
+            mesh.setMeshCache(directory.path(), populationKey);
+            refined = getGeometries(mesh.generateMesh());
+
+            REQUIRE(mesh.nbRefinement == 1);
+            REQUIRE(nbCacheFiles(directory) == 1);
+        }
+
+        // loaded from the cache on a fresh population, so the refinement is not run
+        CountingMesh mesh(loadCells(), 1);
+        mesh.setMeshCache(directory.path(), populationKey);
+        std::map<unsigned long int, CellGeometry> reloaded = getGeometries(mesh.generateMesh());
+
+        REQUIRE(mesh.nbRefinement == 0);
+        REQUIRE(nbCacheFiles(directory) == 1);
+        REQUIRE(reloaded.size() == refined.size());
+        for (const auto& cell : refined) {
+            INFO("cell " << cell.first);
+            REQUIRE(reloaded.count(cell.first) == 1);
+            REQUIRE(reloaded[cell.first].vertices == cell.second.vertices);
+            REQUIRE(reloaded[cell.first].facets == cell.second.facets);
+            REQUIRE(reloaded[cell.first].nuclei == cell.second.nuclei);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+
+#include "Mesh_Statistics.hh"
+#include "PopulationLoader.hh"
+#include "RandomEngineManager.hh"
+#include "SpheroidalCell.hh"
+#include "SpheroidalCellMesh.hh"
+
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+static Statistics::MeshValidationSettings settingsWithThreads(unsigned int nbThreads) {
+    Statistics::MeshValidationSettings settings;
+    settings.nbThreads = nbThreads;
+    return settings;
+}
+
+static bool isFaulty(const Statistics::MeshValidationReport& report, const SpheroidalCell* cell) {
+    return std::binary_search(report.faultyCells.begin(), report.faultyCells.end(), cell->getID());
+}
+
+// move each vertex of the membrane to origin + scale * (vertex - origin) + shift
+static void transformMembrane(SpheroidalCell* cell, double scale, const Vector_3& shift = Vector_3(0., 0., 0.)) {
+    const Point_3 origin = cell->getOrigin();
+    Mesh3D::Polyhedron_3::Point_iterator itPoint;
+    for (itPoint = cell->getShape()->points_begin(); itPoint != cell->getShape()->points_end(); ++itPoint)
+        *itPoint = origin + scale * (*itPoint - origin) + shift;
+}
+
+TEST_CASE("Mesh validation", "[mesh]") {
+
+    CLHEP::MTwistEngine defaultEngineCPOP(1234567);
+    RandomEngineManager::getInstance()->setEngine(&defaultEngineCPOP);
+
+    std::set<t_Cell_3*> cells = loadCells();
+    SpheroidalCellMesh mesh(100, 0., cells);
+
+    SECTION("Cells without mesh are reported") {
+        std::vector<SpheroidalCell*> spheroidalCells;
+        for (t_Cell_3* cell : cells) {
+            SpheroidalCell* spheroidalCell = dynamic_cast<SpheroidalCell*>(cell);
+            REQUIRE(spheroidalCell);
+            REQUIRE_FALSE(spheroidalCell->hasMesh());
+            spheroidalCells.push_back(spheroidalCell);
+        }
+
+        Statistics::MeshValidationReport report = Statistics::validateCellMeshes(spheroidalCells);
+        REQUIRE(report.nbCells == spheroidalCells.size());
+        REQUIRE(report.nbCellsWithoutMesh == spheroidalCells.size());
+        REQUIRE(report.faultyCells.size() == spheroidalCells.size());
+        REQUIRE_FALSE(report.isValid());
+    }
+
+    SECTION("Generated meshes are closed and well oriented") {
+        std::vector<SpheroidalCell*> meshedCells = mesh.generateMesh();
+        REQUIRE(meshedCells.size() == cells.size());
+
+        Statistics::MeshValidationReport report = mesh.validateMeshes(meshedCells, settingsWithThreads(1));
+        REQUIRE(report.nbCells == meshedCells.size());
+        REQUIRE(report.nbCellsWithoutMesh == 0);
+        REQUIRE(report.nbOpenMeshes == 0);
+        REQUIRE(report.nbBadlyOrientedMeshes == 0);
+        REQUIRE(report.facetsPerCell.getNbValues() == meshedCells.size());
+        REQUIRE(report.minFacetAngle.getNbValues() == meshedCells.size());
+
+        // the report does not depend on the number of threads
+        Statistics::MeshValidationReport parallelReport = mesh.validateMeshes(meshedCells, settingsWithThreads(4));
+        REQUIRE(parallelReport.nbCells == report.nbCells);
+        REQUIRE(parallelReport.nbCellsWithSmallAngles == report.nbCellsWithSmallAngles);
+        REQUIRE(parallelReport.nbNucleiOutOfCell == report.nbNucleiOutOfCell);
+        REQUIRE(parallelReport.nbOverlappingPairs == report.nbOverlappingPairs);
+        REQUIRE(parallelReport.faultyCells == report.faultyCells);
+        REQUIRE(parallelReport.facetsPerCell.getCounts() == report.facetsPerCell.getCounts());
+
+        // a tolerance larger than the population makes any overlap acceptable
+        Statistics::MeshValidationSettings tolerant = settingsWithThreads(2);
+        tolerant.overlapTolerance = 1e12;
+        REQUIRE(mesh.validateMeshes(meshedCells, tolerant).nbOverlappingPairs == 0);
+    }
+
+    SECTION("Faulty meshes are detected") {
+        std::vector<SpheroidalCell*> meshedCells = mesh.generateMesh();
+        REQUIRE(meshedCells.size() >= 2);
+
+        SECTION("Flipped facets") {
+            // a vertex moved to the other side of the origin flips its facets
+            SpheroidalCell* cell = meshedCells.front();
+            Mesh3D::Polyhedron_3::Point_iterator itPoint = cell->getShape()->points_begin();
+            *itPoint = cell->getOrigin() - 0.5 * (*itPoint - cell->getOrigin());
+
+            Statistics::MeshValidationReport report = Statistics::validateCellMeshes({cell}, nullptr, settingsWithThreads(1));
+            REQUIRE(report.nbBadlyOrientedMeshes == 1);
+            REQUIRE(isFaulty(report, cell));
+        }
+
+        SECTION("Nucleus outside of its cell") {
+            SpheroidalCell* cell = meshedCells.front();
+            REQUIRE_FALSE(cell->getNuclei().empty());
+            transformMembrane(cell, 0.01);
+
+            Statistics::MeshValidationReport report = Statistics::validateCellMeshes({cell}, nullptr, settingsWithThreads(1));
+            REQUIRE(report.nbNucleiOutOfCell == cell->getNuclei().size());
+            REQUIRE(isFaulty(report, cell));
+        }
+
+        SECTION("Overlapping neighbours") {
+            // the closest pair of cells
+            SpheroidalCell* first = nullptr;
+            SpheroidalCell* second = nullptr;
+            double minSquareDistance = std::numeric_limits<double>::max();
+            for (std::size_t i = 0; i < meshedCells.size(); ++i) {
+                for (std::size_t j = i + 1; j < meshedCells.size(); ++j) {
+                    double squareDistance = CGAL::squared_distance(meshedCells[i]->getOrigin(), meshedCells[j]->getOrigin());
+                    if (squareDistance < minSquareDistance) {
+                        minSquareDistance = squareDistance;
+                        first = meshedCells[i];
+                        second = meshedCells[j];
+                    }
+                }
+            }
+            REQUIRE(first);
+            transformMembrane(first, 1., 0.5 * (second->getOrigin() - first->getOrigin()));
+
+            std::map<SpheroidalCell*, std::set<const SpheroidalCell*> > neighbours;
+            neighbours[first].insert(second);
+            neighbours[second].insert(first);
+            Statistics::MeshValidationReport report = Statistics::validateCellMeshes({first, second}, &neighbours, settingsWithThreads(2));
+            REQUIRE(report.nbOverlappingPairs == 1);
+            REQUIRE(isFaulty(report, first));
+            REQUIRE(isFaulty(report, second));
+
+            // without the neighbourhood the overlap is not looked for
+            REQUIRE(Statistics::validateCellMeshes({first, second}, nullptr, settingsWithThreads(2)).nbOverlappingPairs == 0);
+        }
+    }
+}
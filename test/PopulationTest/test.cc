@@ -243,6 +243,21 @@ TEST_CASE("Population messenger", "[Population]") {
         REQUIRE(population.number_sampling_cell_per_region() == 12);
     }
 
+    SECTION("Set removed cells file") {
+        REQUIRE(population.removed_cells_file() == "IDCell.txt");
+
+        std::string macro = "removedCellsFile.mac";
+        // Get the pointer to the User Interface manager
+        G4UImanager* UImanager = G4UImanager::GetUIpointer();
+        G4String command = "/control/execute ";
+        UImanager->ApplyCommand(command+macro);
+
+        REQUIRE(population.removed_cells_file() == "removed_cells.txt");
+
+        UImanager->ApplyCommand("/cpop/population/removedCellsFile none");
+        REQUIRE(population.removed_cells_file().empty());
+    }
+
     SECTION("Set init") {
         std::string macro = "init.mac";
         // Get the pointer to the User Interface manager
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include "RandomEngineManager.hh"
+
+#include <cstdint>
+#include <vector>
+
+// the first numbers of a stream
+static std::vector<double> draw(RandomStream stream, int nbValues) {
+    std::vector<double> values;
+    for (int i = 0; i < nbValues; ++i)
+        values.push_back(stream.randd());
+    return values;
+}
+
+TEST_CASE("Philox4x32-10", "[random]") {
+
+    // known-answer vectors of Random123 (kat_vectors, philox4x32 10)
+    SECTION("Null counter and key") {
+        const uint32_t key[2] = {0x00000000, 0x00000000};
+        const uint32_t counter[4] = {0x00000000, 0x00000000, 0x00000000, 0x00000000};
+        uint32_t block[4];
+        RandomStream::philox(key, counter, block);
+        REQUIRE(block[0] == 0x6627e8d5);
+        REQUIRE(block[1] == 0xe169c58d);
+        REQUIRE(block[2] == 0xbc57ac4c);
+        REQUIRE(block[3] == 0x9b00dbd8);
+    }
+
+    SECTION("Full counter and key") {
+        const uint32_t key[2] = {0xffffffff, 0xffffffff};
+        const uint32_t counter[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+        uint32_t block[4];
+        RandomStream::philox(key, counter, block);
+        REQUIRE(block[0] == 0x408f276d);
+        REQUIRE(block[1] == 0x41c83b0e);
+        REQUIRE(block[2] == 0xa20bc7c6);
+        REQUIRE(block[3] == 0x6d5451fd);
+    }
+
+    SECTION("Digits of pi") {
+        const uint32_t key[2] = {0xa4093822, 0x299f31d0};
+        const uint32_t counter[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+        uint32_t block[4];
+        RandomStream::philox(key, counter, block);
+        REQUIRE(block[0] == 0xd16cfe09);
+        REQUIRE(block[1] == 0x94fdcceb);
+        REQUIRE(block[2] == 0x5001e420);
+        REQUIRE(block[3] == 0x24126ea1);
+    }
+}
+
+TEST_CASE("Random streams", "[random]") {
+
+    const uint64_t seed = 1234567;
+
+    SECTION("A stream only depends on the seed, its ID and the step") {
+        REQUIRE(draw(RandomStream(seed, 42, 3), 10) == draw(RandomStream(seed, 42, 3), 10));
+        REQUIRE(draw(RandomStream(seed, 42, 3), 10) != draw(RandomStream(seed, 43, 3), 10));
+        REQUIRE(draw(RandomStream(seed, 42, 3), 10) != draw(RandomStream(seed, 42, 4), 10));
+        REQUIRE(draw(RandomStream(seed, 42, 3), 10) != draw(RandomStream(seed + 1, 42, 3), 10));
+        // the high word of the ID is part of the counter
+        REQUIRE(draw(RandomStream(seed, 42, 3), 10) != draw(RandomStream(seed, 42 + (uint64_t(1) << 32), 3), 10));
+    }
+
+    SECTION("Only the 32 low bits of the step are used") {
+        RandomEngineManager manager;
+        manager.setStreamSeed(seed);
+        const unsigned long int step = 5;
+        REQUIRE(draw(manager.getStream(42, step), 10) == draw(RandomStream(seed, 42, 5), 10));
+        if (sizeof(unsigned long int) > sizeof(uint32_t)) {
+            const unsigned long int wrappedStep = step + (static_cast<unsigned long int>(UINT32_MAX) + 1);
+            REQUIRE(draw(manager.getStream(42, wrappedStep), 10) == draw(manager.getStream(42, step), 10));
+        }
+    }
+
+    SECTION("Values are in the requested ranges") {
+        RandomStream stream(seed, 7, 0);
+        double sum = 0.;
+        const int nbValues = 100000;
+        for (int i = 0; i < nbValues; ++i) {
+            double value = stream.randd();
+            REQUIRE(value >= 0.);
+            REQUIRE(value < 1.);
+            sum += value;
+
+            int integer = stream.randi(-3, 3);
+            REQUIRE(integer >= -3);
+            REQUIRE(integer <= 3);
+
+            double ranged = stream.randd(2., 5.);
+            REQUIRE(ranged >= 2.);
+            REQUIRE(ranged < 5.);
+        }
+        REQUIRE(sum / nbValues == Approx(0.5).margin(0.005));
+    }
+}
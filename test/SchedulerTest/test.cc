@@ -0,0 +1,401 @@
+/*----------------------
+Copyright (C): Henri Payno, Axel Delsol,
+Laboratoire de Physique de Clermont UMR 6533 CNRS-UCA
+
+This software is distributed under the terms
+of the GNU Lesser General  Public Licence (LGPL)
+See LICENSE.md for further details
+----------------------*/
+#include "catch.hpp"
+
+#include "Action.hh"
+#include "ActionQueue.hh"
+#include "MASPlatform.hh"
+#include "ParallelChunks.hh"
+#include "Scheduler.hh"
+#include "StoppingRule.hh"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// action writing its tag on a shared log when executed
+class LogAction : public Action {
+public:
+    LogAction(std::vector<int>& log, int tag, ACTION_FREQUENCY frequency = PUNCTUAL_BEFORE_ITERATION, double time = 0.)
+        : Action(frequency, time), log(log), tag(tag), succeed(true), queue(nullptr), toCancel(0) {}
+
+    bool exec() override {
+        log.push_back(tag);
+        if (queue)
+            queue->cancel(toCancel);
+        return succeed;
+    }
+
+    std::vector<int>& log;
+    int tag;
+    bool succeed;
+    ActionQueue* queue;             // if set, the scheduling toCancel is cancelled on exec
+    ActionQueue::ActionID toCancel;
+};
+
+TEST_CASE("Action queue", "[Scheduler]") {
+
+    std::vector<int> log;
+    ActionQueue queue;
+
+    SECTION("Actions due at the same time keep their scheduling order") {
+        std::vector<std::unique_ptr<LogAction> > actions;
+        for (int i = 0; i < 100; ++i) {
+            actions.emplace_back(new LogAction(log, i));
+            queue.push(actions.back().get(), 1.);
+        }
+        REQUIRE(queue.size() == 100);
+
+        REQUIRE(queue.process(1.));
+        REQUIRE(log.size() == 100);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(log[i] == i);
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("Actions run by time, then by scheduling order") {
+        LogAction a(log, 0), b(log, 1), c(log, 2), d(log, 3), e(log, 4);
+        queue.push(&a, 3.);
+        queue.push(&b, 1.);
+        queue.push(&c, 2.);
+        queue.push(&d, 1.);
+        queue.push(&e, 5.);
+
+        REQUIRE(queue.process(0.5));
+        REQUIRE(log.empty());
+
+        REQUIRE(queue.process(3.));
+        REQUIRE(log == std::vector<int>({1, 3, 2, 0}));
+        REQUIRE(queue.size() == 1);
+    }
+
+    SECTION("Actions at each step run first, at each process") {
+        LogAction punctual(log, 0), each1(log, 1), each2(log, 2);
+        queue.push(&punctual, 0.);
+        queue.pushEachStep(&each1);
+        queue.pushEachStep(&each2);
+
+        REQUIRE(queue.process(0.));
+        REQUIRE(queue.process(1.));
+        REQUIRE(log == std::vector<int>({1, 2, 0, 1, 2}));
+        REQUIRE(queue.size() == 2);
+    }
+
+    SECTION("Recurring actions run once per process") {
+        LogAction recurring(log, 0), tie(log, 1);
+        queue.push(&recurring, 0.5, 1.);
+        queue.push(&tie, 1.5);
+
+        REQUIRE(queue.process(0.));
+        REQUIRE(log.empty());
+        REQUIRE(queue.process(0.5));
+        REQUIRE(log == std::vector<int>({0}));
+        // the recurring action keeps its scheduling order on ties
+        REQUIRE(queue.process(1.5));
+        REQUIRE(log == std::vector<int>({0, 0, 1}));
+        // occurrences missed during a long step are merged
+        REQUIRE(queue.process(10.));
+        REQUIRE(log == std::vector<int>({0, 0, 1, 0}));
+        REQUIRE(queue.process(10.4));
+        REQUIRE(log.size() == 4);
+        REQUIRE(queue.process(10.5));
+        REQUIRE(log.size() == 5);
+        REQUIRE(queue.size() == 1);
+    }
+
+    SECTION("Cancellation") {
+        LogAction a(log, 0), b(log, 1), c(log, 2);
+        ActionQueue::ActionID idA = queue.push(&a, 1.);
+        queue.push(&b, 1.);
+        queue.pushEachStep(&c);
+        queue.push(&c, 2., 1.);
+
+        REQUIRE(queue.cancel(idA));
+        REQUIRE_FALSE(queue.cancel(idA));
+        REQUIRE_FALSE(queue.isPending(idA));
+        REQUIRE(queue.cancel(&c) == 2);
+        REQUIRE(queue.size() == 1);
+
+        REQUIRE(queue.process(5.));
+        REQUIRE(log == std::vector<int>({1}));
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("Actions can cancel the next ones and themselves") {
+        LogAction a(log, 0), b(log, 1);
+        ActionQueue::ActionID idA = queue.pushEachStep(&a);
+        ActionQueue::ActionID idB = queue.pushEachStep(&b);
+        a.queue = &queue;
+        a.toCancel = idB;
+
+        REQUIRE(queue.process(0.));
+        REQUIRE(log == std::vector<int>({0}));
+        REQUIRE(queue.isPending(idA));
+
+        a.toCancel = idA;
+        REQUIRE(queue.process(1.));
+        REQUIRE(queue.process(2.));
+        REQUIRE(log == std::vector<int>({0, 0}));
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("Many cancellations") {
+        std::vector<std::unique_ptr<LogAction> > actions;
+        for (int i = 0; i < 1000; ++i) {
+            actions.emplace_back(new LogAction(log, i));
+            queue.cancel(queue.push(actions.back().get(), 1000. - i));
+        }
+        LogAction kept(log, -1);
+        queue.push(&kept, 0.);
+        REQUIRE(queue.size() == 1);
+
+        REQUIRE(queue.process(1000.));
+        REQUIRE(log == std::vector<int>({-1}));
+    }
+
+    SECTION("A failing action stays scheduled") {
+        LogAction a(log, 0), b(log, 1);
+        queue.push(&a, 1.);
+        queue.push(&b, 1.);
+        a.succeed = false;
+
+        REQUIRE_FALSE(queue.process(1.));
+        REQUIRE(log == std::vector<int>({0}));
+        REQUIRE(queue.size() == 2);
+
+        a.succeed = true;
+        REQUIRE(queue.process(1.));
+        REQUIRE(log == std::vector<int>({0, 0, 1}));
+    }
+}
+
+TEST_CASE("Scheduler actions", "[Scheduler]") {
+
+    Scheduler::getInstance()->init();
+    std::vector<int> log;
+
+    SECTION("Actions with the same timing are all processed, in construction order") {
+        LogAction p1(log, 1, Action::PUNCTUAL_BEFORE_ITERATION, 0.);
+        LogAction p2(log, 2, Action::PUNCTUAL_BEFORE_ITERATION, 0.);
+        LogAction each1(log, 3, Action::EACH_BEGIN_ITERATION);
+        LogAction each2(log, 4, Action::EACH_BEGIN_ITERATION);
+        LogAction p3(log, 5, Action::PUNCTUAL_BEFORE_ITERATION, 0.);
+        LogAction later(log, 6, Action::PUNCTUAL_BEFORE_ITERATION, 1.);
+        LogAction post(log, 7, Action::EACH_END_ITERATION);
+
+        REQUIRE(Scheduler::getInstance()->processPreActions());
+        REQUIRE(log == std::vector<int>({3, 4, 1, 2, 5}));
+        REQUIRE(Scheduler::getInstance()->processPostActions());
+        REQUIRE(Scheduler::getInstance()->processPreActions());
+        REQUIRE(log == std::vector<int>({3, 4, 1, 2, 5, 7, 3, 4}));
+    }
+
+    SECTION("Actions are not processed once cancelled or deleted") {
+        LogAction kept(log, 1, Action::EACH_BEGIN_ITERATION);
+        LogAction cancelled(log, 2, Action::EACH_BEGIN_ITERATION);
+        LogAction* deleted = new LogAction(log, 3, Action::EACH_BEGIN_ITERATION);
+
+        REQUIRE(Scheduler::getInstance()->cancelAction(&cancelled));
+        REQUIRE_FALSE(Scheduler::getInstance()->cancelAction(&cancelled));
+        delete deleted;
+
+        REQUIRE(Scheduler::getInstance()->processPreActions());
+        REQUIRE(log == std::vector<int>({1}));
+    }
+
+    SECTION("Punctual actions need a positive time") {
+        LogAction negative(log, 1, Action::PUNCTUAL_BEFORE_ITERATION, -1.);
+        REQUIRE_FALSE(Scheduler::getInstance()->scheduleAction(&negative));
+        REQUIRE(Scheduler::getInstance()->processPreActions());
+        REQUIRE(log.empty());
+    }
+}
+
+// metrics of a step where each agent moved of the given displacement
+static StepMetrics stepMetrics(double displacement, double energy = -1., double overlap = 0.) {
+    StepMetrics metrics;
+    metrics.nbAgents = 10;
+    metrics.meanDisplacement = displacement;
+    metrics.maxDisplacement = displacement;
+    if (energy >= 0.) {
+        metrics.elasticEnergy = energy;
+        metrics.overlapVolume = overlap;
+        metrics.hasInteractionMetrics = true;
+    }
+    return metrics;
+}
+
+TEST_CASE("Stopping rule", "[Scheduler]") {
+
+    StoppingRule rule;
+
+    SECTION("A disabled rule never stops") {
+        REQUIRE_FALSE(rule.isEnabled());
+        REQUIRE_FALSE(rule.needsInteractionMetrics());
+        for (int i = 0; i < 10; ++i)
+            REQUIRE_FALSE(rule.update(stepMetrics(0.)));
+    }
+
+    SECTION("The simulation stops after nbSteps consecutive converged steps") {
+        rule.setMaxDisplacement(0.1);
+        rule.setNbSteps(3);
+        REQUIRE(rule.isEnabled());
+
+        REQUIRE_FALSE(rule.update(stepMetrics(0.05)));
+        REQUIRE_FALSE(rule.update(stepMetrics(0.05)));
+        REQUIRE(rule.update(stepMetrics(0.05)));
+    }
+
+    SECTION("A step not converged resets the count") {
+        rule.setMeanDisplacement(0.1);
+        rule.setNbSteps(2);
+
+        REQUIRE_FALSE(rule.update(stepMetrics(0.05)));
+        REQUIRE_FALSE(rule.update(stepMetrics(0.5)));
+        REQUIRE_FALSE(rule.update(stepMetrics(0.05)));
+        REQUIRE(rule.update(stepMetrics(0.05)));
+
+        // reset forgets the converged steps
+        rule.reset();
+        REQUIRE_FALSE(rule.update(stepMetrics(0.05)));
+    }
+
+    SECTION("Interaction criteria need a previous step") {
+        rule.setEnergyChange(0.01);
+        rule.setOverlapChange(0.01);
+        REQUIRE(rule.needsInteractionMetrics());
+
+        // no previous step : never converged, even without change
+        REQUIRE_FALSE(rule.update(stepMetrics(0., 100., 10.)));
+        // relative changes under the tolerances
+        REQUIRE(rule.update(stepMetrics(0., 100.5, 10.05)));
+        // energy change over the tolerance
+        REQUIRE_FALSE(rule.update(stepMetrics(0., 110., 10.05)));
+        // overlap change over the tolerance
+        REQUIRE_FALSE(rule.update(stepMetrics(0., 110., 11.)));
+        // metrics without interactions can't be compared
+        REQUIRE_FALSE(rule.update(stepMetrics(0.)));
+        REQUIRE_FALSE(rule.update(stepMetrics(0., 110., 11.)));
+        REQUIRE(rule.update(stepMetrics(0., 110., 11.)));
+    }
+
+    SECTION("A null nbSteps stops at the first converged step") {
+        rule.setMaxDisplacement(0.1);
+        rule.setNbSteps(0);
+        REQUIRE(rule.update(stepMetrics(0.)));
+    }
+}
+
+// scheduler whose durations can be set without a platform
+class AdaptiveScheduler : public Scheduler {
+public:
+    using Scheduler::setDuration;
+    using Scheduler::setStepDuration;
+    using Scheduler::setAdaptiveStep;
+};
+
+TEST_CASE("Adaptive step duration", "[Scheduler]") {
+
+    // the displacement threshold is held by the simulation manager
+    static MASPlatform platform;
+    platform.setDisplacementThreshold(1.);
+    AdaptiveScheduler scheduler;
+    scheduler.setStepDuration(1.);
+    scheduler.setDuration(100.);
+    scheduler.setAdaptiveStep(0.1, 4., 0.5, 2.);
+    scheduler.init();
+
+    SECTION("The first step has the reference duration") {
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(1.));
+        REQUIRE(scheduler.getStepScale() == Approx(1.));
+        REQUIRE(scheduler.getStepIndex() == 1);
+    }
+
+    SECTION("Without force the step grows of maxGrowth up to the max duration") {
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(1.));
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(2.));
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(4.));
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(4.));
+        REQUIRE(scheduler.getStepScale() == Approx(4.));
+        REQUIRE(scheduler.getRunningTime() == Approx(11.));
+    }
+
+    SECTION("The strongest force limits the step") {
+        scheduler.computeSimulationStepDuration();
+        scheduler.computeSimulationStepDuration();
+        // the fastest agent may travel 0.5 * threshold : 0.5 * 1 * 1 / 2
+        scheduler.reportAgentForce(1.);
+        scheduler.reportAgentForce(2.);
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(0.25));
+        REQUIRE(scheduler.getStepScale() == Approx(0.25));
+        // forces are forgotten at each step
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(0.5));
+    }
+
+    SECTION("The step is clamped to the min duration") {
+        scheduler.computeSimulationStepDuration();
+        scheduler.reportAgentForce(100.);
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(0.1));
+    }
+
+    SECTION("The last step is truncated at the total duration") {
+        scheduler.setDuration(2.5);
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(1.));
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(1.5));
+        REQUIRE(scheduler.getRunningTime() == Approx(2.5));
+        REQUIRE(scheduler.computeSimulationStepDuration() == Approx(0.));
+    }
+}
+
+TEST_CASE("Chunked parallel loop", "[parallel]") {
+
+    SECTION("Each item is processed once") {
+        const std::size_t nbItems = 10007;
+        std::vector<std::atomic<int> > counts(nbItems);
+        for (std::atomic<int>& count : counts)
+            count = 0;
+        // Catch assertions are not thread safe, so the workers only record the faults
+        std::atomic<bool> badChunk(false), badThreadID(false);
+
+        processChunksInParallel(nbItems, 64, 4, [&](std::size_t begin, std::size_t end, unsigned int threadID) {
+            if (begin >= end || end > nbItems)
+                badChunk = true;
+            if (threadID >= 4)
+                badThreadID = true;
+            for (std::size_t i = begin; i < end && i < nbItems; ++i)
+                ++counts[i];
+        });
+
+        REQUIRE_FALSE(badChunk);
+        REQUIRE_FALSE(badThreadID);
+        for (std::size_t i = 0; i < nbItems; ++i)
+            REQUIRE(counts[i] == 1);
+    }
+
+    SECTION("Guided chunks shrink down to one item") {
+        ChunkQueue queue(1000, 100, 2);
+        std::size_t begin, end, expectedBegin = 0, previousSize = 100;
+        while (queue.takeChunk(begin, end)) {
+            REQUIRE(begin == expectedBegin);
+            REQUIRE(end - begin <= previousSize);
+            previousSize = end - begin;
+            expectedBegin = end;
+        }
+        REQUIRE(expectedBegin == 1000);
+        REQUIRE(previousSize == 1);
+    }
+
+    SECTION("Number of threads") {
+        REQUIRE(getNbThreadsFor(0, 10, 8) == 1);
+        REQUIRE(getNbThreadsFor(35, 10, 8) == 3);
+        REQUIRE(getNbThreadsFor(1000, 10, 8) == 8);
+        REQUIRE(getNbThreadsFor(1000, 0, 2) == 2);
+        REQUIRE(getNbThreadsFor(1000, 10) >= 1);
+    }
+}
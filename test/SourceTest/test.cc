@@ -97,6 +97,26 @@ TEST_CASE("Uniform source", "[source]") {
 
     }
 
+    SECTION("Isotropic directions and primary positions") {
+        cpop::UniformSource source{"electron", population};
+
+        const int number_particle = 10000;
+
+        Settings::Geometry::Point_3 center = population.spheroid_centroid();
+        G4ThreeVector spheroid_centroid(center.x(), center.y(), center.z());
+
+        G4ThreeVector mean_direction;
+        for(int i = 0; i < number_particle; ++i) {
+            G4ThreeVector direction = source.GetMomentum();
+            G4ThreeVector position = source.GetPrimaryPosition();
+            REQUIRE(direction.mag() == Approx(1.));
+            REQUIRE((position - spheroid_centroid).mag() <= population.spheroid_radius());
+            mean_direction += direction;
+        }
+        mean_direction /= number_particle;
+        REQUIRE(mean_direction.mag() < 0.05);
+    }
+
     SECTION("Messenger") {
         cpop::UniformSource source{"electron", population};
         G4String base = "/cpop/source/" + source.source_name();
@@ -0,0 +1,3 @@
+2 1 0.001
+0.1 keVV 0.5
+0.2 0.5
@@ -0,0 +1,4 @@
+0 2 0     # 0 : read until the end of file
+1	1.
+2	0.
+3	1.
@@ -0,0 +1,4 @@
+3 3 0
+1	0.
+2	1.
+3	1.
@@ -0,0 +1,3 @@
+2 2 0.001
+0.1 0.
+0.2 0.
@@ -0,0 +1,4 @@
+3 2 0.001
+0.1 0.5
+0.3 0.25
+0.2 0.25
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include "CPOP_SpectrumParser.hh"
+#include "CPOP_UserSpectrum.hh"
+
+static void requireParseError(const std::string& file, size_t line, size_t column) {
+    INFO("spectrum file : " << file);
+    try {
+        CPOP_SpectrumParser::parseFile(file);
+        FAIL("no error raised");
+    } catch(const CPOP_SpectrumParseError& e) {
+        INFO(e.what());
+        REQUIRE(e.source() == file);
+        REQUIRE(e.line() == line);
+        REQUIRE(e.column() == column);
+    }
+}
+
+TEST_CASE("Spectrum parser", "[spectrum]") {
+
+    SECTION("Comments and units") {
+        CPOP_SpectrumData data = CPOP_SpectrumParser::parseFile("valid.spec");
+
+        REQUIRE(data.mode == 1);
+        REQUIRE(data.emin == Approx(0.001));
+        REQUIRE(data.energies.size() == 3);
+        REQUIRE(data.probas.size() == 3);
+        REQUIRE(data.energies[0] == Approx(0.01));
+        REQUIRE(data.energies[1] == Approx(0.5));
+        REQUIRE(data.energies[2] == Approx(1.));
+        REQUIRE(data.probas[1] == Approx(0.5));
+    }
+
+    SECTION("Read until end of file") {
+        CPOP_SpectrumData data = CPOP_SpectrumParser::parseFile("histogram.spec");
+
+        REQUIRE(data.mode == 2);
+        REQUIRE(data.energies.size() == 3);
+    }
+
+    SECTION("Malformed files") {
+        REQUIRE_THROWS_AS(CPOP_SpectrumParser::parseFile("does_not_exist.spec"), std::runtime_error);
+
+        requireParseError("missing_header.spec", 3, 1);
+        requireParseError("bad_mode.spec", 1, 3);
+        requireParseError("bad_number.spec", 3, 5);
+        requireParseError("bad_unit.spec", 2, 5);
+        requireParseError("overlapping.spec", 4, 1);
+        requireParseError("negative_proba.spec", 3, 5);
+        requireParseError("too_few_lines.spec", 4, 1);
+        requireParseError("too_many_lines.spec", 3, 1);
+        requireParseError("null_proba.spec", 1, 1);
+    }
+}
+
+TEST_CASE("User spectrum", "[spectrum]") {
+
+    SECTION("Discrete") {
+        CPOP_UserSpectrum spectrum("valid.spec");
+
+        REQUIRE(spectrum.getNbRanges() == 3);
+        REQUIRE(spectrum.isNormalized());
+        REQUIRE(spectrum.getTotalProbability() == Approx(1.));
+        REQUIRE(spectrum.getRange(0)->getProbaLowBound() == Approx(0.));
+        REQUIRE(spectrum.getRange(0)->getProbaHighBound() == Approx(0.25));
+        REQUIRE(spectrum.getRange(2)->getProbaHighBound() == 1.);
+
+        REQUIRE(spectrum.GetEnergy(0.1, 0.5) == Approx(0.01));
+        REQUIRE(spectrum.GetEnergy(0.5, 0.5) == Approx(0.5));
+        REQUIRE(spectrum.GetEnergy(1., 0.5) == Approx(1.));
+    }
+
+    SECTION("Histogram with an empty bin") {
+        CPOP_UserSpectrum spectrum("histogram.spec");
+
+        REQUIRE(spectrum.getNbRanges() == 2);
+        // densities integrate to 2 : the spectrum is renormalized with a warning
+        REQUIRE_FALSE(spectrum.isNormalized());
+        REQUIRE(spectrum.getTotalProbability() == Approx(2.));
+        REQUIRE(spectrum.getRange(0)->getProbaHighBound() == Approx(0.5));
+        REQUIRE(spectrum.GetEnergy(0.25, 0.5) == Approx(0.5));
+        REQUIRE(spectrum.GetEnergy(0.75, 0.5) == Approx(2.5));
+    }
+
+    SECTION("Interpolated") {
+        CPOP_UserSpectrum spectrum("interpolated.spec");
+
+        REQUIRE(spectrum.getNbRanges() == 2);
+        REQUIRE(spectrum.getRange(0)->getProbaHighBound() == Approx(1./3.));
+        REQUIRE(spectrum.GetEnergy(0.1, 1.) == Approx(2.));
+        // flat segment is sampled on its own energy range
+        REQUIRE(spectrum.GetEnergy(0.9, 0.5) == Approx(2.5));
+    }
+}
@@ -0,0 +1,3 @@
+3 1 0.001
+0.1 0.5
+0.2 0.5
@@ -0,0 +1,6 @@
+# discrete spectrum with comments and units
+3 1 0.001
+10 keV	0.25   # attached or separated units are accepted
+0.5MeV	0.5
+
+1e3 keV	0.25
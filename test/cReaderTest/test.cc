@@ -7,6 +7,13 @@
 #include "customsection.hh"
 #include "customobject.hh"
 
+// section exposing the optional loading
+template <typename T = int>
+class OptionalSection : public conf::SectionReader<T> {
+public:
+	using conf::SectionReader<T>::loadOptional;
+};
+
 TEST_CASE("Section", "[cReader]") {
 	conf::SectionReader<> section;
 	zz::cfg::CfgParser parser("testcheck.cfg");
@@ -23,6 +30,14 @@ TEST_CASE("Section", "[cReader]") {
 		REQUIRE_THROWS_AS( section.load<int>("Check","empty"), std::invalid_argument );
 	}
 	
+	SECTION("LoadOptional") {
+		OptionalSection<> optionalSection;
+		optionalSection.setParser(&parser);
+		REQUIRE( optionalSection.loadOptional<int>("Load", "int", 3) == 1 );
+		REQUIRE( optionalSection.loadOptional<int>("Check", "empty", 3) == 3 );
+		REQUIRE( optionalSection.loadOptional<double>("Missing", "double", 4.5) == Approx(4.5).margin(tol) );
+	}
+	
 	SECTION("LoadInt") {
 		int myInt = section.load<int>("Load","int");
 		REQUIRE( myInt == 1 );
@@ -0,0 +1,30 @@
+#ifndef TEST_POPULATION_LOADER_HH
+#define TEST_POPULATION_LOADER_HH
+
+#include "catch.hpp"
+
+#include "CPOP_Loader.hh"
+#include "EnvironmentSettings.hh"
+
+#include <QString>
+
+#include <set>
+
+// load the cells of the first sub environment of the population file
+inline std::set<t_Cell_3*> loadCells(const QString& file = "population.xml") {
+    CPOP_Loader loader;
+    Settings::nEnvironment::t_Environment_3* env = loader.load3DEnvironment(file, true);
+    REQUIRE(env);
+    REQUIRE(env->getFirstChild());
+
+    std::set<t_Cell_3*> cells;
+    for (Agent* agent : env->getFirstChild()->getAgents()) {
+        t_Cell_3* cell = dynamic_cast<t_Cell_3*>(agent);
+        if (cell)
+            cells.insert(cell);
+    }
+    REQUIRE(!cells.empty());
+    return cells;
+}
+
+#endif